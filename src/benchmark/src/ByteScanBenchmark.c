@@ -0,0 +1,131 @@
+// Copyright 2024 Dynatrace LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Portions of this code, as identified in remarks, are provided under the
+// Creative Commons BY-SA 4.0 or the MIT license, and are provided without
+// any warranty. In each of the remarks, we have provided attribution to the
+// original creators and other attribution parties, along with the title of
+// the code (if known) a copyright notice and a link to the license, and a
+// statement indicating whether or not we have modified the code.
+
+#define _GNU_SOURCE // memmem()
+
+#include "../../core/src/ByteScan.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/**
+ * Throughput benchmark of the ByteScan kernels against the previous strnstr() of Utils.c (strstr() over the '\0' terminated buffer and a
+ * bound check afterwards) and glibc's memchr()/memmem(). Every search scans the whole buffer, since the buffer doesn't contain the
+ * searched bytes. Results are given in GB/s of scanned buffer.
+ *
+ * Usage: ByteScanBenchmark [buffer size in bytes] [iterations]
+ */
+
+#define DEFAULT_BUFFER_SIZE 4096
+#define DEFAULT_ITERATIONS 200000
+
+/**
+ * strnstr() of Utils.c before the ByteScan kernels.
+ */
+static char* legacyStrnstr(char* haystack, const char* needle, int nHaystack) {
+	char* needleInHaystack = strstr(haystack, needle);
+
+	if (needleInHaystack == NULL || (needleInHaystack - haystack) < 0 || (needleInHaystack - haystack) > nHaystack) {
+		return NULL;
+	}
+
+	return needleInHaystack;
+}
+
+static double elapsedNanoseconds(struct timespec* start, struct timespec* end) {
+	return (end->tv_sec - start->tv_sec) * 1e9 + (end->tv_nsec - start->tv_nsec);
+}
+
+typedef enum { Search__LINE_END, Search__VERSION, Search__HEADER } Search;
+
+static const char* runSearch(Search search, const char* name, const ByteScanKernels* kernels, char* buf, size_t length) {
+	switch (search) {
+	case Search__LINE_END:
+		if (kernels != NULL) {
+			return kernels->findByte(buf, length, '\r');
+		}
+		return strcmp(name, "memchr") == 0 ? memchr(buf, '\r', length) : legacyStrnstr(buf, "\r", length);
+	case Search__VERSION:
+		if (kernels != NULL) {
+			return kernels->findSubstring(buf, length, "HTTP/1.1", strlen("HTTP/1.1"));
+		}
+		return strcmp(name, "memmem") == 0 ? memmem(buf, length, "HTTP/1.1", strlen("HTTP/1.1")) : legacyStrnstr(buf, "HTTP/1.1", length);
+	default:
+		if (kernels != NULL) {
+			return kernels->findSubstring(buf, length, "Server: ", strlen("Server: "));
+		}
+		return strcmp(name, "memmem") == 0 ? memmem(buf, length, "Server: ", strlen("Server: ")) : legacyStrnstr(buf, "Server: ", length);
+	}
+}
+
+static void benchmark(Search search, const char* searchName, const char* name, const ByteScanKernels* kernels, char* buf, size_t length,
+		long iterations) {
+	struct timespec start, end;
+	const char* volatile result = NULL;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (long i = 0; i < iterations; i++) {
+		result = runSearch(search, name, kernels, buf, length);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	if (result != NULL) {
+		fprintf(stderr, "%s/%s: unexpected match\n", searchName, name);
+	}
+
+	printf("%-10s %-16s %8.2f GB/s\n", searchName, name, (double)length * iterations / elapsedNanoseconds(&start, &end));
+}
+
+int main(int argc, char** argv) {
+	size_t length = argc > 1 ? (size_t)atol(argv[1]) : DEFAULT_BUFFER_SIZE;
+	long iterations = argc > 2 ? atol(argv[2]) : DEFAULT_ITERATIONS;
+
+	// header-like text without '\r', "HTTP/1.1" and "Server: ", '\0' terminated for legacyStrnstr()
+	const char* pattern = "X-Forwarded-For: 10.0.0.1\nAccept-Encoding: gzip, deflate\nHTTP/1.0 Serve Servers: x\n";
+	char* buf = malloc(length + 1);
+	for (size_t i = 0; i < length; i++) {
+		buf[i] = pattern[i % strlen(pattern)];
+	}
+	buf[length] = '\0';
+
+	const char* searchNames[] = {"line-end", "version", "header"};
+	const char* baselines[][2] = {{"strnstr", "memchr"}, {"strnstr", "memmem"}, {"strnstr", "memmem"}};
+
+	printf("buffer: %zu bytes, iterations: %ld, selected kernels: %s\n", length, iterations, selectedByteScanKernels()->name);
+
+	for (Search search = Search__LINE_END; search <= Search__HEADER; search++) {
+		for (int i = 0; i < 2; i++) {
+			benchmark(search, searchNames[search], baselines[search][i], NULL, buf, length, iterations);
+		}
+		for (ByteScanIsa isa = ByteScanIsa__SCALAR; isa < ByteScanIsa__COUNT; isa++) {
+			const ByteScanKernels* kernels = byteScanKernels(isa);
+
+			if (kernels != NULL) {
+				benchmark(search, searchNames[search], kernels->name, kernels, buf, length, iterations);
+			}
+		}
+	}
+
+	free(buf);
+	return 0;
+}
@@ -0,0 +1,94 @@
+// Copyright 2024 Dynatrace LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Portions of this code, as identified in remarks, are provided under the
+// Creative Commons BY-SA 4.0 or the MIT license, and are provided without
+// any warranty. In each of the remarks, we have provided attribution to the
+// original creators and other attribution parties, along with the title of
+// the code (if known) a copyright notice and a link to the license, and a
+// statement indicating whether or not we have modified the code.
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/**
+ * Micro benchmark for the overhead of the overwritten read()/write() methods on file descriptors that aren't traced sockets (e.g. the
+ * tempfile I/O of the worst-case benchmark or class files read by the JVM). It is meant to be started three times by the Makefile target
+ * benchmark-fileio: without LD_PRELOAD, with LD_PRELOAD as an unsupported process and with LD_PRELOAD as a supported process (argv[0]
+ * contains "python"), so the deception hooks are active.
+ *
+ * Usage: FileIoBenchmark [iterations] [chunk size in bytes]
+ */
+
+#define DEFAULT_ITERATIONS 1000000
+#define DEFAULT_CHUNK_SIZE 64
+
+double elapsedNanoseconds(struct timespec* start, struct timespec* end) {
+	return (end->tv_sec - start->tv_sec) * 1e9 + (end->tv_nsec - start->tv_nsec);
+}
+
+int main(int argc, char** argv) {
+	long iterations = argc > 1 ? atol(argv[1]) : DEFAULT_ITERATIONS;
+	size_t chunkSize = argc > 2 ? (size_t)atol(argv[2]) : DEFAULT_CHUNK_SIZE;
+
+	char path[] = "/tmp/deception-fileio-benchmark-XXXXXX";
+	int fd = mkstemp(path);
+	if (fd < 0) {
+		perror("mkstemp");
+		return 1;
+	}
+	unlink(path);
+
+	char* buffer = malloc(chunkSize);
+	memset(buffer, 'x', chunkSize);
+
+	struct timespec start, end;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (long i = 0; i < iterations; i++) {
+		if (write(fd, buffer, chunkSize) != (ssize_t)chunkSize) {
+			perror("write");
+			return 1;
+		}
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	double writeNanoseconds = elapsedNanoseconds(&start, &end) / iterations;
+
+	lseek(fd, 0, SEEK_SET);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (long i = 0; i < iterations; i++) {
+		if (read(fd, buffer, chunkSize) != (ssize_t)chunkSize) {
+			perror("read");
+			return 1;
+		}
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	double readNanoseconds = elapsedNanoseconds(&start, &end) / iterations;
+
+	printf("%-28s write: %8.1f ns/call   read: %8.1f ns/call   (%ld x %zu bytes)\n",
+		   argv[0],
+		   writeNanoseconds,
+		   readNanoseconds,
+		   iterations,
+		   chunkSize);
+
+	free(buffer);
+	close(fd);
+	return 0;
+}
@@ -0,0 +1,115 @@
+// Copyright 2024 Dynatrace LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Portions of this code, as identified in remarks, are provided under the
+// Creative Commons BY-SA 4.0 or the MIT license, and are provided without
+// any warranty. In each of the remarks, we have provided attribution to the
+// original creators and other attribution parties, along with the title of
+// the code (if known) a copyright notice and a link to the license, and a
+// statement indicating whether or not we have modified the code.
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+/**
+ * Micro benchmark for the per-request overhead of the overwritten recv()/send() methods on a traced connection. The process listens on
+ * a deceived port, connects to itself and runs HTTP request/response round trips over a single keep-alive connection, so every request
+ * passes the request classification of recv() and the response rewrite of send(). It is meant to be started by the Makefile target
+ * compare-variants without LD_PRELOAD and with the release and dev variant of deception.so as a supported process (argv[0] contains
+ * "python"). The rewrite is only active if a honeyaml.yaml is available at HONEYAML_FILE.
+ *
+ * Usage: HttpRoundTripBenchmark [round trips] [port]
+ */
+
+#define DEFAULT_ROUND_TRIPS 100000
+#define DEFAULT_PORT 8081
+
+/**
+ * Time for the honeyaml thread of deception.so to load the initial configuration before the measurement starts.
+ */
+#define CONFIG_LOAD_WAIT 500000
+
+static const char REQUEST[] = "GET /admin HTTP/1.1\r\nHost: localhost\r\n\r\n";
+static const char RESPONSE[] = "HTTP/1.1 404 Not Found\r\nServer: SimpleHTTP/0.6 Python/3.11.7\r\nContent-Length: 0\r\n\r\n";
+
+double elapsedNanoseconds(struct timespec* start, struct timespec* end) {
+	return (end->tv_sec - start->tv_sec) * 1e9 + (end->tv_nsec - start->tv_nsec);
+}
+
+int main(int argc, char** argv) {
+	long roundTrips = argc > 1 ? atol(argv[1]) : DEFAULT_ROUND_TRIPS;
+	unsigned short port = argc > 2 ? (unsigned short)atoi(argv[2]) : DEFAULT_PORT;
+
+	struct sockaddr_in address;
+	memset(&address, 0, sizeof(address));
+	address.sin_family = AF_INET;
+	address.sin_port = htons(port);
+	address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+	int listenFd = socket(AF_INET, SOCK_STREAM, 0);
+	int reuse = 1;
+	setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+	if (bind(listenFd, (struct sockaddr*)&address, sizeof(address)) != 0 || listen(listenFd, 1) != 0) {
+		perror("bind/listen");
+		return 1;
+	}
+
+	int clientFd = socket(AF_INET, SOCK_STREAM, 0);
+	if (connect(clientFd, (struct sockaddr*)&address, sizeof(address)) != 0) {
+		perror("connect");
+		return 1;
+	}
+
+	struct sockaddr_in peerAddress;
+	socklen_t peerAddressLength = sizeof(peerAddress);
+	int serverFd = accept(listenFd, (struct sockaddr*)&peerAddress, &peerAddressLength);
+	if (serverFd < 0) {
+		perror("accept");
+		return 1;
+	}
+
+	usleep(CONFIG_LOAD_WAIT);
+
+	char buffer[4096];
+	struct timespec start, end;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (long i = 0; i < roundTrips; i++) {
+		if (write(clientFd, REQUEST, sizeof(REQUEST) - 1) != sizeof(REQUEST) - 1 || recv(serverFd, buffer, sizeof(buffer), 0) <= 0) {
+			perror("request");
+			return 1;
+		}
+		// send() gets a writable copy, since the deception rewrites the header in place
+		memcpy(buffer, RESPONSE, sizeof(RESPONSE));
+		if (send(serverFd, buffer, sizeof(RESPONSE) - 1, 0) <= 0 || read(clientFd, buffer, sizeof(buffer)) <= 0) {
+			perror("response");
+			return 1;
+		}
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	printf("%-28s round trip: %8.1f ns/request\n", argv[0], elapsedNanoseconds(&start, &end) / roundTrips);
+
+	close(clientFd);
+	close(serverFd);
+	close(listenFd);
+
+	return 0;
+}
@@ -0,0 +1,99 @@
+// Copyright 2024 Dynatrace LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Portions of this code, as identified in remarks, are provided under the
+// Creative Commons BY-SA 4.0 or the MIT license, and are provided without
+// any warranty. In each of the remarks, we have provided attribution to the
+// original creators and other attribution parties, along with the title of
+// the code (if known) a copyright notice and a link to the license, and a
+// statement indicating whether or not we have modified the code.
+
+#include "HoneBookThread.h"
+#include "HoneYamlParsing.h"
+#include "SharedModel.h"
+#include "Utils.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/**
+ * Offline compiler of a HoneYamlFile into the ModelImage that deception.so maps at startup instead of parsing the YAML (see
+ * HONEYAML_IMAGE_FILE). The image is only used for the exact content it was compiled from, so it has to be compiled again after every
+ * change of the HoneYamlFile. Built by the Makefile target honeyaml-compiler.
+ *
+ * Usage: honeyamlc <honeyaml.yaml> <honeyaml.img>
+ */
+
+/**
+ * The compiler runs without the logger of deception.so, parsing errors go to stderr.
+ */
+void simpleLoggerWrite(LoggerPriority loggerPriority, const char* format, ...) {
+	va_list args;
+
+	va_start(args, format);
+	vfprintf(stderr, format, args);
+	va_end(args);
+}
+
+int main(int argc, char** argv) {
+	if (argc != 3) {
+		fprintf(stderr, "Usage: %s <honeyaml.yaml> <honeyaml.img>\n", argv[0]);
+		return 2;
+	}
+
+	FILE* honeyamlFile = fopen(argv[1], "rb");
+	if (honeyamlFile == NULL) {
+		perror(argv[1]);
+		return 1;
+	}
+
+	char* content = malloc(HONEYAML_FILE_MAX_LENGTH);
+	size_t length = content != NULL ? fread(content, 1, HONEYAML_FILE_MAX_LENGTH, honeyamlFile) : 0;
+	bool truncated = content != NULL && !feof(honeyamlFile);
+	fclose(honeyamlFile);
+
+	if (content == NULL || truncated) {
+		fprintf(stderr, "%s is larger than %d bytes\n", argv[1], HONEYAML_FILE_MAX_LENGTH);
+		return 1;
+	}
+
+	HoneywiresConfig* honeywiresConfig = parseHoneYamlBuffer((const unsigned char*)content, length);
+	if (honeywiresConfig == NULL) {
+		fprintf(stderr, "Couldn't parse %s\n", argv[1]);
+		return 1;
+	}
+
+	SO_HW_Model* so_hw_model = compileHoneyModel(honeywiresConfig);
+	const ResponseProgram* program = so_hw_model->sendModel->responseProgram;
+	if (program != NULL && program->rejectedOperationsLength > 0) {
+		fprintf(stderr, "%s: %d header operations are left out, their values exceed %d bytes\n", argv[1], program->rejectedOperationsLength,
+				RESPONSE_PROGRAM_REPLACEMENT_MAX_LENGTH);
+	}
+	ModelImage* image = buildModelImage(so_hw_model, hashBytes(content, length), 1);
+	if (image == NULL || !writeModelImageFile(argv[2], image)) {
+		fprintf(stderr, "Couldn't write %s\n", argv[2]);
+		return 1;
+	}
+
+	printf("%s: %d honeywires compiled into %s (%lu bytes, version %u, checksum %016lx)\n",
+			argv[1],
+			honeywiresConfig->honeywiresLength,
+			argv[2],
+			image->length,
+			image->version,
+			image->checksum);
+
+	return 0;
+}
@@ -0,0 +1,195 @@
+// Copyright 2024 Dynatrace LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Portions of this code, as identified in remarks, are provided under the
+// Creative Commons BY-SA 4.0 or the MIT license, and are provided without
+// any warranty. In each of the remarks, we have provided attribution to the
+// original creators and other attribution parties, along with the title of
+// the code (if known) a copyright notice and a link to the license, and a
+// statement indicating whether or not we have modified the code.
+
+#include "ByteScan.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define BYTE_SCAN_X86
+#include <immintrin.h>
+#endif
+
+// --------------- scalar kernels
+
+static const char* findByteScalar(const char* buf, size_t length, char byte) {
+	for (size_t i = 0; i < length; i++) {
+		if (buf[i] == byte) {
+			return buf + i;
+		}
+	}
+
+	return NULL;
+}
+
+static const char* findSubstringScalar(const char* buf, size_t length, const char* needle, size_t needleLength) {
+	if (needleLength == 0) {
+		return buf;
+	}
+	if (needleLength > length) {
+		return NULL;
+	}
+
+	for (size_t i = 0; i <= length - needleLength; i++) {
+		if (buf[i] == needle[0] && memcmp(buf + i + 1, needle + 1, needleLength - 1) == 0) {
+			return buf + i;
+		}
+	}
+
+	return NULL;
+}
+
+static const ByteScanKernels SCALAR_KERNELS = {"scalar", findByteScalar, findSubstringScalar};
+
+#ifdef BYTE_SCAN_X86
+
+// --------------- SSE2 kernels (16 bytes per step)
+
+static const char* findByteSse2(const char* buf, size_t length, char byte) {
+	const __m128i pattern = _mm_set1_epi8(byte);
+	size_t i = 0;
+
+	for (; i + 16 <= length; i += 16) {
+		int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(buf + i)), pattern));
+		if (mask != 0) {
+			return buf + i + __builtin_ctz(mask);
+		}
+	}
+
+	return findByteScalar(buf + i, length - i, byte);
+}
+
+/**
+ * Compares the first and the last byte of @needle at 16 positions at once and only verifies the candidates with memcmp().
+ */
+static const char* findSubstringSse2(const char* buf, size_t length, const char* needle, size_t needleLength) {
+	if (needleLength < 2 || needleLength > length) {
+		return needleLength == 1 ? findByteSse2(buf, length, needle[0]) : findSubstringScalar(buf, length, needle, needleLength);
+	}
+
+	const __m128i first = _mm_set1_epi8(needle[0]);
+	const __m128i last = _mm_set1_epi8(needle[needleLength - 1]);
+	size_t i = 0;
+
+	// the block of last bytes ends at i + needleLength - 1 + 16
+	for (; i + needleLength - 1 + 16 <= length; i += 16) {
+		__m128i firstBlock = _mm_loadu_si128((const __m128i*)(buf + i));
+		__m128i lastBlock = _mm_loadu_si128((const __m128i*)(buf + i + needleLength - 1));
+		int mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(firstBlock, first), _mm_cmpeq_epi8(lastBlock, last)));
+
+		while (mask != 0) {
+			int offset = __builtin_ctz(mask);
+			if (memcmp(buf + i + offset + 1, needle + 1, needleLength - 2) == 0) {
+				return buf + i + offset;
+			}
+			mask &= mask - 1;
+		}
+	}
+
+	return findSubstringScalar(buf + i, length - i, needle, needleLength);
+}
+
+static const ByteScanKernels SSE2_KERNELS = {"sse2", findByteSse2, findSubstringSse2};
+
+// --------------- AVX2 kernels (32 bytes per step), only called if the CPU supports AVX2
+//
+// The tails are handed to the SSE2 kernels, which are legacy SSE encoded: the upper halves of the ymm registers are cleared before, since
+// gcc doesn't emit vzeroupper ahead of a tail call and every call would pay the AVX-SSE transition penalty otherwise.
+
+__attribute__((target("avx2"))) static const char* findByteAvx2(const char* buf, size_t length, char byte) {
+	const __m256i pattern = _mm256_set1_epi8(byte);
+	size_t i = 0;
+
+	for (; i + 32 <= length; i += 32) {
+		unsigned int mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(buf + i)), pattern));
+		if (mask != 0) {
+			return buf + i + __builtin_ctz(mask);
+		}
+	}
+
+	_mm256_zeroupper();
+	return findByteSse2(buf + i, length - i, byte);
+}
+
+__attribute__((target("avx2"))) static const char* findSubstringAvx2(
+		const char* buf, size_t length, const char* needle, size_t needleLength) {
+	if (needleLength < 2 || needleLength > length) {
+		return needleLength == 1 ? findByteAvx2(buf, length, needle[0]) : findSubstringScalar(buf, length, needle, needleLength);
+	}
+
+	const __m256i first = _mm256_set1_epi8(needle[0]);
+	const __m256i last = _mm256_set1_epi8(needle[needleLength - 1]);
+	size_t i = 0;
+
+	for (; i + needleLength - 1 + 32 <= length; i += 32) {
+		__m256i firstBlock = _mm256_loadu_si256((const __m256i*)(buf + i));
+		__m256i lastBlock = _mm256_loadu_si256((const __m256i*)(buf + i + needleLength - 1));
+		unsigned int mask = _mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(firstBlock, first), _mm256_cmpeq_epi8(lastBlock, last)));
+
+		while (mask != 0) {
+			int offset = __builtin_ctz(mask);
+			if (memcmp(buf + i + offset + 1, needle + 1, needleLength - 2) == 0) {
+				return buf + i + offset;
+			}
+			mask &= mask - 1;
+		}
+	}
+
+	_mm256_zeroupper();
+	return findSubstringSse2(buf + i, length - i, needle, needleLength);
+}
+
+static const ByteScanKernels AVX2_KERNELS = {"avx2", findByteAvx2, findSubstringAvx2};
+
+#endif
+
+const ByteScanKernels* byteScanKernels(ByteScanIsa isa) {
+	switch (isa) {
+	case ByteScanIsa__SCALAR:
+		return &SCALAR_KERNELS;
+#ifdef BYTE_SCAN_X86
+	case ByteScanIsa__SSE2:
+		return &SSE2_KERNELS;
+	case ByteScanIsa__AVX2:
+		__builtin_cpu_init();
+		return __builtin_cpu_supports("avx2") ? &AVX2_KERNELS : NULL;
+#endif
+	default:
+		return NULL;
+	}
+}
+
+static const ByteScanKernels* selectedKernels = NULL;
+
+const ByteScanKernels* selectedByteScanKernels() {
+	const ByteScanKernels* kernels = __atomic_load_n(&selectedKernels, __ATOMIC_RELAXED);
+
+	// every thread selects the same kernels, so a concurrent first call only repeats the selection
+	if (__builtin_expect(kernels == NULL, 0)) {
+		for (int isa = ByteScanIsa__COUNT - 1; kernels == NULL; isa--) {
+			kernels = byteScanKernels(isa);
+		}
+		__atomic_store_n(&selectedKernels, kernels, __ATOMIC_RELAXED);
+	}
+
+	return kernels;
+}
@@ -0,0 +1,71 @@
+// Copyright 2024 Dynatrace LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Portions of this code, as identified in remarks, are provided under the
+// Creative Commons BY-SA 4.0 or the MIT license, and are provided without
+// any warranty. In each of the remarks, we have provided attribution to the
+// original creators and other attribution parties, along with the title of
+// the code (if known) a copyright notice and a link to the license, and a
+// statement indicating whether or not we have modified the code.
+
+#pragma once
+
+#include <stddef.h>
+
+/**
+ * Instruction set of a ByteScanKernels implementation. SSE2 is part of every x86-64 CPU, AVX2 is selected at runtime if the CPU
+ * supports it. Other architectures only have the scalar kernels.
+ */
+typedef enum {
+	ByteScanIsa__SCALAR,
+	ByteScanIsa__SSE2,
+	ByteScanIsa__AVX2,
+	ByteScanIsa__COUNT,
+} ByteScanIsa;
+
+/**
+ * Bounded scanning kernels for socket buffers. None of them reads outside of [buf, buf + length), so they are safe on buffers that
+ * aren't '\0' terminated.
+ */
+typedef struct {
+	const char* name;
+
+	/**
+	 * @return the first occurrence of @byte, NULL if there is none (like memchr())
+	 */
+	const char* (*findByte)(const char* buf, size_t length, char byte);
+
+	/**
+	 * @return the first occurrence of @needle with @needleLength bytes, NULL if there is none (like memmem())
+	 */
+	const char* (*findSubstring)(const char* buf, size_t length, const char* needle, size_t needleLength);
+} ByteScanKernels;
+
+/**
+ * @return the kernels of @isa or NULL if the CPU doesn't support @isa. Used to compare the implementations (see ByteScanBenchmark.c).
+ */
+const ByteScanKernels* byteScanKernels(ByteScanIsa isa);
+
+/**
+ * @return the fastest kernels supported by the CPU, selected once on the first call
+ */
+const ByteScanKernels* selectedByteScanKernels();
+
+static inline const char* findByte(const char* buf, size_t length, char byte) {
+	return selectedByteScanKernels()->findByte(buf, length, byte);
+}
+
+static inline const char* findSubstring(const char* buf, size_t length, const char* needle, size_t needleLength) {
+	return selectedByteScanKernels()->findSubstring(buf, length, needle, needleLength);
+}
@@ -18,26 +18,63 @@
 // original creators and other attribution parties, along with the title of
 // the code (if known) a copyright notice and a link to the license, and a
 // statement indicating whether or not we have modified the code.
-
 #include "HoneBookThread.h"
+#ifndef WITHOUT_YAML_PARSER
 #include "HoneYamlParsing.h"
+#endif
+#include "SharedModel.h"
 #include "Utils.h"
 #include "structs/GlobalVariables.h"
 
+#include <errno.h>
+#include <limits.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <sys/inotify.h>
 #include <sys/stat.h>
+#include <sys/vfs.h>
 #include <unistd.h>
 
-int updateGlobalStateIfUpdateExists();
-int updateGlobalState();
+/**
+ * f_type of network filesystems (see statfs(2)). inotify only reports changes made by the local node on them, so the honeBookThread
+ * polls instead.
+ */
+#define NFS_SUPER_MAGIC 0x6969
+#define SMB_SUPER_MAGIC 0x517B
+#define CIFS_SUPER_MAGIC 0xFF534D42
+#define FUSE_SUPER_MAGIC 0x65735546
+
+/**
+ * Events within the watched directory that might change the content behind HONEYAML_FILE: an editor saving the file in place
+ * (IN_CLOSE_WRITE), a file or symlink renamed into place (IN_MOVED_TO, e.g. the "..data" symlink swap of a Kubernetes ConfigMap) and a
+ * replaced symlink (IN_CREATE). IN_MODIFY is left out on purpose, since it also fires for partially written files.
+ */
+#define HONEYAML_WATCH_EVENTS (IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE)
+
+/**
+ * inotify instance of the honeBookThread, -1 while it polls. Kept to close the instance a child process inherits from the parent.
+ */
+static int inotifyFd = -1;
+
+int updateGlobalStateIfContentChanged(time_t lastModified);
+int updateGlobalStateFromImage(time_t lastModified);
+int updateGlobalState(const char* honeyamlContent, size_t length, unsigned long contentHash, time_t configLastUpdated);
+bool watchHoneYamlDirectory();
 
 void* honeBookThread(void* argp) {
 	simpleLogger(LoggerPriority__INFO, " [-] honeBookThread(): thread started!\n");
 
-	while (1) {
-		updateGlobalStateIfUpdateExists();
+	updateGlobalStateIfUpdateExists(true);
+
+	// only returns if inotify isn't available for the HONEYAML_FILE
+	watchHoneYamlDirectory();
 
+	simpleLogger(LoggerPriority__INFO, " [-] honeBookThread(): polling \"%s\" every %d seconds\n", HONEYAML_FILE, HONEYAML_CHECK_INTERVAL);
+	while (1) {
 		sleep(HONEYAML_CHECK_INTERVAL);
+
+		updateGlobalStateIfUpdateExists(true);
 	}
 }
 
@@ -49,15 +86,158 @@ void startHoneyBookUpdateThread(HoneywiresBook* honeywiresBook) {
 	pthread_create(&(honeywiresBook->readConfigThread), NULL, honeBookThread, NULL);
 }
 
+void restartHoneyBookUpdateThread(HoneywiresBook* honeywiresBook) {
+	// nobody reads the inherited inotify instance, its events would only pile up in the kernel
+	if (inotifyFd != -1) {
+		close(inotifyFd);
+		inotifyFd = -1;
+	}
+
+	startHoneyBookUpdateThread(honeywiresBook);
+}
+
 /**
- * 0 = failure or file end
- * 1 = success
+ * @return true if @directory is located on a filesystem where inotify also reports changes of other nodes
  */
-int updateGlobalStateIfUpdateExists() {
+static bool isInotifySupported(const char* directory) {
+	struct statfs fileSystemStat;
+
+	if (statfs(directory, &fileSystemStat) != 0) {
+		return false;
+	}
+
+	switch ((unsigned long)fileSystemStat.f_type) {
+	case NFS_SUPER_MAGIC:
+	case SMB_SUPER_MAGIC:
+	case CIFS_SUPER_MAGIC:
+	case FUSE_SUPER_MAGIC:
+		return false;
+	default:
+		return true;
+	}
+}
+
+/**
+ * Name of the "..data" symlink of a Kubernetes ConfigMap volume, which is swapped to switch all files of the volume at once.
+ */
+#define CONFIG_MAP_DATA_LINK "..data"
+
+/**
+ * @return true if @name is the entry of @path within its directory
+ */
+static bool isEntryOf(const char* name, const char* path) {
+	const char* lastSlash = strrchr(path, '/');
+
+	return strcmp(name, lastSlash != NULL ? lastSlash + 1 : path) == 0;
+}
+
+/**
+ * Only events of the HONEYAML_FILE, the HONEYAML_IMAGE_FILE and the CONFIG_MAP_DATA_LINK are relevant, others of the directory (e.g. the
+ * temporary file written by the honeyaml-compiler before it is renamed into place) would only trigger a reload of unchanged content.
+ * IN_CREATE is only relevant for symlinks, a newly created regular file is still empty and will be followed by an IN_CLOSE_WRITE.
+ */
+static bool isRelevantHoneYamlEvent(const char* directory, const struct inotify_event* event) {
+	if (event->len == 0 || (event->mask & IN_ISDIR) ||
+		!(isEntryOf(event->name, HONEYAML_FILE) || isEntryOf(event->name, HONEYAML_IMAGE_FILE) ||
+				strcmp(event->name, CONFIG_MAP_DATA_LINK) == 0)) {
+		return false;
+	}
+	if (!(event->mask & IN_CREATE)) {
+		return true;
+	}
+
+	char path[PATH_MAX];
+	struct stat entryStat;
+	if (snprintf(path, sizeof(path), "%s/%s", directory, event->name) >= (int)sizeof(path)) {
+		return false;
+	}
+
+	return lstat(path, &entryStat) == 0 && S_ISLNK(entryStat.st_mode);
+}
+
+/**
+ * Block on inotify events of the directory containing HONEYAML_FILE and reload the file after each relevant event. The directory is
+ * watched instead of the file itself, since the file might be replaced (e.g. renamed into place or a Kubernetes ConfigMap swapping its
+ * "..data" symlink), which would silently end a watch on the file.
+ * @return false if inotify isn't available (or the watch got lost), the caller has to poll in that case
+ */
+bool watchHoneYamlDirectory() {
+	char directory[PATH_MAX];
+	snprintf(directory, sizeof(directory), "%s", HONEYAML_FILE);
+	char* lastSlash = strrchr(directory, '/');
+	if (lastSlash == NULL) {
+		return false;
+	}
+	*lastSlash = '\0';
+
+	if (!isInotifySupported(directory)) {
+		simpleLogger(LoggerPriority__INFO, " [-] watchHoneYamlDirectory(): \"%s\" is on a network filesystem\n", directory);
+		return false;
+	}
+
+	inotifyFd = inotify_init1(IN_CLOEXEC);
+	if (inotifyFd == -1) {
+		simpleLogger(LoggerPriority__ERROR, "!-- watchHoneYamlDirectory(): inotify isn't available!\n");
+		return false;
+	}
+	if (inotify_add_watch(inotifyFd, directory, HONEYAML_WATCH_EVENTS) == -1) {
+		simpleLogger(LoggerPriority__ERROR, "!-- watchHoneYamlDirectory(): Couldn't watch directory \"%s\"!\n", directory);
+		close(inotifyFd);
+		inotifyFd = -1;
+		return false;
+	}
+
+	simpleLogger(LoggerPriority__INFO, " [-] watchHoneYamlDirectory(): watching \"%s\"\n", directory);
+
+	// a change in between the initial check of the honeBookThread and the start of the watch has no event
+	updateGlobalStateIfUpdateExists(false);
+
+	char events[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+
+	while (1) {
+		ssize_t length = read(inotifyFd, events, sizeof(events));
+		if (length == -1 && errno == EINTR) {
+			continue;
+		}
+		if (length <= 0) {
+			break;
+		}
+
+		bool relevant = false;
+		bool watchLost = false;
+
+		for (char* position = events; position < events + length;) {
+			const struct inotify_event* event = (const struct inotify_event*)position;
+
+			watchLost |= (event->mask & IN_IGNORED) != 0;
+			relevant |= isRelevantHoneYamlEvent(directory, event);
+
+			position += sizeof(struct inotify_event) + event->len;
+		}
+
+		if (watchLost) {
+			break;
+		}
+		// the modification time isn't compared, since a file moved into place might keep an older one
+		if (relevant) {
+			updateGlobalStateIfUpdateExists(false);
+		}
+	}
+
+	simpleLogger(LoggerPriority__ERROR, "!-- watchHoneYamlDirectory(): Lost the watch of directory \"%s\"!\n", directory);
+	close(inotifyFd);
+	inotifyFd = -1;
+	return false;
+}
+
+int updateGlobalStateIfUpdateExists(bool compareModificationTime) {
 	struct stat fileStat;
 
+	// without HONEYAML_FILE a HONEYAML_IMAGE_FILE is used on its own
+	bool imageOnly = stat(HONEYAML_FILE, &fileStat) != 0;
+
 	// check if file exists and stats could be allocated as expected
-	if (stat(HONEYAML_FILE, &fileStat) != 0) {
+	if (imageOnly && stat(HONEYAML_IMAGE_FILE, &fileStat) != 0) {
 		simpleLogger(LoggerPriority__ERROR, "!-- updateGlobalStateIfUpdateExists(): Couldn't find file \"%s\"!\n", HONEYAML_FILE);
 		return 0;
 	}
@@ -65,25 +245,134 @@ int updateGlobalStateIfUpdateExists() {
 	time_t lastModified = fileStat.st_mtime;
 
 	// check if file exists and stats could be allocated as expected
-	if (globals.honeywiresBook->honeyConfigLastUpdated >= lastModified) {
+	if (compareModificationTime && globals.honeywiresBook->honeyConfigLastUpdated >= lastModified) {
 		return 1;
 	}
 
-	int success = updateGlobalState(HONEYAML_FILE, lastModified);
+	if (imageOnly) {
+		return updateGlobalStateFromImage(lastModified);
+	}
+	return updateGlobalStateIfContentChanged(lastModified);
+}
+
+/**
+ * Publish the model of the HONEYAML_IMAGE_FILE if it differs from the current one.
+ * 0 = failure
+ * 1 = success
+ */
+int updateGlobalStateFromImage(time_t lastModified) {
+	SO_HW_Model* so_hw_model = mapModelFile(HONEYAML_IMAGE_FILE, 0, true);
+
+	if (so_hw_model == NULL) {
+		simpleLogger(LoggerPriority__ERROR, "!-- updateGlobalStateFromImage(): Couldn't map the file \"%s\"!\n", HONEYAML_IMAGE_FILE);
+		return 0;
+	}
 
+	unsigned long sourceHash = ((const ModelImage*)so_hw_model->image)->sourceHash;
+	if (sourceHash == globals.honeywiresBook->honeyConfigHash) {
+		freeSharedObjectHoneywireMapping(so_hw_model);
+		globals.honeywiresBook->honeyConfigLastUpdated = lastModified;
+		return 1;
+	}
+
+	simpleLogger(LoggerPriority__INFO, " [-] updateGlobalStateFromImage(): HoneYaml image update detected!\n");
+	updateHoneyConfig(globals.honeywiresBook, NULL, so_hw_model, lastModified);
+	globals.honeywiresBook->honeyConfigHash = sourceHash;
+
+	return 1;
+}
+
+/**
+ * Read the HONEYAML_FILE and only parse it if its content differs from the one of the current honeywiresConfig.
+ * 0 = failure
+ * 1 = success
+ */
+int updateGlobalStateIfContentChanged(time_t lastModified) {
+	FILE* honeyamlFile = fopen(HONEYAML_FILE, "rb");
+	if (honeyamlFile == NULL) {
+		simpleLogger(LoggerPriority__ERROR, "!-- updateGlobalStateIfContentChanged(): Couldn't open file \"%s\"!\n", HONEYAML_FILE);
+		return 0;
+	}
+
+	char* content = malloc(HONEYAML_FILE_MAX_LENGTH);
+	size_t length = content != NULL ? fread(content, 1, HONEYAML_FILE_MAX_LENGTH, honeyamlFile) : 0;
+	bool truncated = content != NULL && !feof(honeyamlFile);
+	fclose(honeyamlFile);
+
+	if (content == NULL || truncated) {
+		simpleLogger(
+				LoggerPriority__ERROR,
+				"!-- updateGlobalStateIfContentChanged(): \"%s\" is larger than %d bytes!\n",
+				HONEYAML_FILE,
+				HONEYAML_FILE_MAX_LENGTH);
+		free(content);
+		return 0;
+	}
+
+	unsigned long contentHash = hashBytes(content, length);
+	int success = 1;
+
+	if (contentHash != globals.honeywiresBook->honeyConfigHash) {
+		success = updateGlobalState(content, length, contentHash, lastModified);
+	} else {
+		// unchanged content (e.g. file only touched): remember the time to not read it again while polling
+		globals.honeywiresBook->honeyConfigLastUpdated = lastModified;
+	}
+
+	free(content);
 	return success;
 }
 
-int updateGlobalState(char* honeyamlFile, time_t configLastUpdated) {
-	HoneywiresConfig* honeywiresConfig = parseHoneYamlFile(honeyamlFile);
+int updateGlobalState(const char* honeyamlContent, size_t length, unsigned long contentHash, time_t configLastUpdated) {
+	HoneywiresConfig* honeywiresConfig = NULL;
+	int lockFd = -1;
+
+	// an image compiled from the same content by the honeyaml-compiler, or else by another process of the node. Without the lock the
+	// published image is still complete (see writeModelImageFile()), only compiling a missing one isn't serialized anymore.
+	SO_HW_Model* so_hw_model = mapModelFile(HONEYAML_IMAGE_FILE, contentHash, true);
+	if (so_hw_model == NULL) {
+		lockFd = lockSharedModel();
+		so_hw_model = mapModelFile(SHARED_MODEL_FILE, contentHash, false);
+	}
 
-	if (honeywiresConfig == NULL) {
-		simpleLogger(LoggerPriority__ERROR, "!-- updateGlobalState(): Couldn't parse the file \"%s\"!\n", honeyamlFile);
+	if (so_hw_model == NULL) {
+#ifdef WITHOUT_YAML_PARSER
+		unlockSharedModel(lockFd);
+		simpleLogger(
+				LoggerPriority__ERROR,
+				"!-- updateGlobalState(): \"%s\" isn't compiled into \"%s\" and YAML parsing isn't built in!\n",
+				HONEYAML_FILE,
+				HONEYAML_IMAGE_FILE);
 		return 0;
+#else
+		honeywiresConfig = parseHoneYamlBuffer((const unsigned char*)honeyamlContent, length);
+
+		if (honeywiresConfig == NULL) {
+			unlockSharedModel(lockFd);
+			simpleLogger(LoggerPriority__ERROR, "!-- updateGlobalState(): Couldn't parse the file \"%s\"!\n", HONEYAML_FILE);
+			return 0;
+		}
+
+		so_hw_model = compileHoneyModel(honeywiresConfig);
+		const ResponseProgram* program = so_hw_model->sendModel->responseProgram;
+		if (program != NULL && program->rejectedOperationsLength > 0) {
+			simpleLogger(
+					LoggerPriority__ERROR,
+					"!-- updateGlobalState(): %d header operations of \"%s\" are left out, their values exceed %d bytes!\n",
+					program->rejectedOperationsLength,
+					HONEYAML_FILE,
+					RESPONSE_PROGRAM_REPLACEMENT_MAX_LENGTH);
+		}
+		if (lockFd != -1) {
+			so_hw_model = publishSharedModel(so_hw_model, contentHash);
+		}
+#endif
 	}
+	unlockSharedModel(lockFd);
 
 	simpleLogger(LoggerPriority__INFO, " [-] updateGlobalState(): HoneYaml file update detected!\n");
-	updateHoneyConfig(globals.honeywiresBook, honeywiresConfig, configLastUpdated);
+	updateHoneyConfig(globals.honeywiresBook, honeywiresConfig, so_hw_model, configLastUpdated);
+	globals.honeywiresBook->honeyConfigHash = contentHash;
 
 	return 1;
 }
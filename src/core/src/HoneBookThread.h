@@ -24,14 +24,34 @@
 #include "structs/HoneywireBook.h"
 
 /**
- * Defines the interval time for honeBookThread in seconds.
+ * Defines the interval time for honeBookThread in seconds, if it has to poll for updates since inotify isn't available.
  *
  */
 #define HONEYAML_CHECK_INTERVAL 5
 
 /**
- * Thread that periodically checks for update of a HoneYamlFile and updates the global
+ * Maximal size of a HoneYamlFile in bytes.
+ */
+#define HONEYAML_FILE_MAX_LENGTH (1 << 20)
+
+/**
+ * Thread that waits for updates of a HoneYamlFile and updates the global HoneywiresBook. Updates are detected with inotify on the
+ * directory of the file, or by polling every HONEYAML_CHECK_INTERVAL if inotify isn't available (e.g. on network filesystems).
  */
 void* honeBookThread(void* argp);
 
 void startHoneyBookUpdateThread(HoneywiresBook* honeywiresBook);
+
+/**
+ * Update globals.honeywiresBook from the HoneYamlFile (or its image), only called by the honeBookThread and before it is started.
+ * @compareModificationTime: skip reading the file if it wasn't modified since the last update (used while polling)
+ * 0 = failure or file end
+ * 1 = success
+ */
+int updateGlobalStateIfUpdateExists(bool compareModificationTime);
+
+/**
+ * Start the honeBookThread again in a forked child process, which only inherits the thread that called fork(). The child keeps the
+ * honeywiresBook of the parent, so the first check of the restarted thread only parses the HoneYamlFile if it changed since.
+ */
+void restartHoneyBookUpdateThread(HoneywiresBook* honeywiresBook);
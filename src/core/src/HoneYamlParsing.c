@@ -28,6 +28,7 @@
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <strings.h>
 
 typedef enum {
 	HoneywireYamlParsingStage__EMPTY,
@@ -35,22 +36,52 @@ typedef enum {
 	HoneywireYamlParsingStage__HONEYWIRE,
 	HoneywireYamlParsingStage__HONEYWIRE_OPERATIONS,
 	HoneywireYamlParsingStage__HONEYWIRE_OPERATIONS_CONDITION,
+	HoneywireYamlParsingStage__LENGTH,
 } HoneywireYamlParsingStage;
 
 typedef struct {
 	HoneywireYamlParsingStage state;
 	bool outstandingRightShift;
 	bool outstandingLeftShift;
+
+	// key of the last object that was opened (e.g. "condition"), the key of a sequence if the object is followed by one
+	HoneywireAttribute openedKey;
+
+	// sequence of objects opened in a stage (e.g. "condition:" followed by multiple "- path: ..." entries)
+	bool sequenceOpen[HoneywireYamlParsingStage__LENGTH];
+	HoneywireAttribute sequenceKeys[HoneywireYamlParsingStage__LENGTH];
 } YamlState;
 
 int readHoneYamlLine(HoneywiresConfig* honeywiresConfig, YamlState* state, yaml_parser_t* parser, yaml_event_t* event);
 int processKey(HoneywiresConfig* config, yaml_event_t* event, char* key);
+int openYamlObject(HoneywiresConfig* config, HoneywireAttribute keyType);
 int saveYamlEntry(HoneywiresConfig* config, HoneywireAttribute keyType, char* value);
 
+/**
+ * Parse all honeywires of the input that is set for the initialized @parser. Deletes the @parser.
+ */
+static HoneywiresConfig* parseHoneYaml(yaml_parser_t* parser) {
+	yaml_event_t event;
+
+	HoneywiresConfig* honeywiresConfig = malloc(sizeof(HoneywiresConfig));
+	honeywiresConfig->honeywiresLength = 0;
+
+	int fileEndingReached = 0;
+	YamlState yamlState = {HoneywireYamlParsingStage__EMPTY, false, false};
+
+	do {
+		fileEndingReached = readHoneYamlLine(honeywiresConfig, &yamlState, parser, &event);
+	} while (fileEndingReached == 1);
+
+	// free resources
+	yaml_parser_delete(parser);
+
+	return honeywiresConfig;
+}
+
 HoneywiresConfig* parseHoneYamlFile(const char* honeyamlFilePath) {
 	FILE* yamlFilePointer = fopen(honeyamlFilePath, "rb");
 	yaml_parser_t parser;
-	yaml_event_t event;
 
 	if (yamlFilePointer == NULL) {
 		simpleLogger(LoggerPriority__ERROR, "!-- parseHoneYamlFile(): Failed to open file!\n");
@@ -58,26 +89,29 @@ HoneywiresConfig* parseHoneYamlFile(const char* honeyamlFilePath) {
 	}
 	if (!yaml_parser_initialize(&parser)) {
 		simpleLogger(LoggerPriority__ERROR, "!-- parseHoneYamlFile(): Failed to initialize parser!\n");
+		fclose(yamlFilePointer);
 		return NULL;
 	}
 
 	yaml_parser_set_input_file(&parser, yamlFilePointer);
 
-	HoneywiresConfig* honeywiresConfig = malloc(sizeof(HoneywiresConfig));
-	honeywiresConfig->honeywiresLength = 0;
+	HoneywiresConfig* honeywiresConfig = parseHoneYaml(&parser);
+	fclose(yamlFilePointer);
 
-	int fileEndingReached = 0;
-	YamlState yamlState = {HoneywireYamlParsingStage__EMPTY, false, false};
+	return honeywiresConfig;
+}
 
-	do {
-		fileEndingReached = readHoneYamlLine(honeywiresConfig, &yamlState, &parser, &event);
-	} while (fileEndingReached == 1);
+HoneywiresConfig* parseHoneYamlBuffer(const unsigned char* buffer, size_t length) {
+	yaml_parser_t parser;
 
-	// free resources
-	yaml_parser_delete(&parser);
-	fclose(yamlFilePointer);
+	if (!yaml_parser_initialize(&parser)) {
+		simpleLogger(LoggerPriority__ERROR, "!-- parseHoneYamlBuffer(): Failed to initialize parser!\n");
+		return NULL;
+	}
 
-	return honeywiresConfig;
+	yaml_parser_set_input_string(&parser, buffer, length);
+
+	return parseHoneYaml(&parser);
 }
 
 int readHoneYamlLine(HoneywiresConfig* honeywiresConfig, YamlState* state, yaml_parser_t* parser, yaml_event_t* event) {
@@ -130,6 +164,7 @@ int readHoneYamlLine(HoneywiresConfig* honeywiresConfig, YamlState* state, yaml_
 		} else {
 			// Key starts an object (e.g. key without value)
 			state->outstandingRightShift = true;
+			state->openedKey = keyType;
 		}
 		break;
 	case YAML_STREAM_START_EVENT:
@@ -153,11 +188,36 @@ int readHoneYamlLine(HoneywiresConfig* honeywiresConfig, YamlState* state, yaml_
 		} else if (state->outstandingRightShift) {
 			state->outstandingRightShift = false;
 			state->state += 1;
+		} else if (state->state < HoneywireYamlParsingStage__LENGTH && state->sequenceOpen[state->state]) {
+			// every further entry of a sequence opens a new object of the sequence key, e.g. the next condition
+			keyType = openYamlObject(honeywiresConfig, state->sequenceKeys[state->state]);
+			if (keyType < 0) {
+				simpleLogger(LoggerPriority__ERROR, "!-- readHoneYamlLine(): HoneYAML sequence entry failed with error code %d!\n", keyType);
+				return 0;
+			}
+			state->state += 1;
 		} else {
 			simpleLogger(LoggerPriority__ERROR, "!-- readHoneYamlLine(): Unexpected indent to the right in the YAML config!\n");
 			return 0;
 		}
 
+		return readHoneYamlLine(honeywiresConfig, state, parser, event);
+		break;
+	case YAML_SEQUENCE_START_EVENT:
+		yaml_event_delete(event);
+		if (state->outstandingRightShift && state->state < HoneywireYamlParsingStage__LENGTH) {
+			state->sequenceOpen[state->state] = true;
+			state->sequenceKeys[state->state] = state->openedKey;
+		}
+
+		return readHoneYamlLine(honeywiresConfig, state, parser, event);
+		break;
+	case YAML_SEQUENCE_END_EVENT:
+		yaml_event_delete(event);
+		if (state->state < HoneywireYamlParsingStage__LENGTH) {
+			state->sequenceOpen[state->state] = false;
+		}
+
 		return readHoneYamlLine(honeywiresConfig, state, parser, event);
 		break;
 	case YAML_MAPPING_END_EVENT:
@@ -191,8 +251,17 @@ int processKey(HoneywiresConfig* config, yaml_event_t* event, char* key) {
 	if (keyID == HoneywireYamlParsingError__KEY_NOT_FOUND) {
 		return HoneywireYamlParsingError__KEY_NOT_FOUND;
 	}
-	HoneywireAttribute keyType = keyID;
 
+	return openYamlObject(config, keyID);
+}
+
+/**
+ * Open the object of @keyType (e.g. a new condition for "condition") if @keyType opens an object.
+ * Return value:
+ * >=0: @keyType
+ * < 0: HoneywireYamlParsingError
+ */
+int openYamlObject(HoneywiresConfig* config, HoneywireAttribute keyType) {
 	Honeywire* honeywire;
 	HoneywireOperation* operation;
 	HoneywireOperationCondition* condition;
@@ -235,7 +304,7 @@ int processKey(HoneywiresConfig* config, yaml_event_t* event, char* key) {
 		honeywire = config->honeywires[config->honeywiresLength - 1];
 		operation = honeywire->operations[honeywire->operationsLength - 1];
 		if (operation->conditionsLength + 1 == HONEYWIRE_OPERATION_CONDITIONS_MAX_LENGTH) {
-			return -1;
+			return HoneywireYamlParsingError__OPERATION_CONDITIONS_MAX_LENGTH_REACHED;
 		}
 
 		condition = malloc(sizeof(HoneywireOperationCondition));
@@ -296,3 +365,15 @@ int saveYamlEntry(HoneywiresConfig* config, HoneywireAttribute keyType, char* va
 	}
 	return 1;
 }
+
+bool strToBool(const char* stringToConvert) {
+	char* TRUE_VALUES[] = {"y", "yes", "true", "on"};
+	const int NUM_TRUE_VALUES = 4;
+
+	for (int i = 0; i < NUM_TRUE_VALUES; i++) {
+		if (strcasecmp(stringToConvert, TRUE_VALUES[i]) == 0) {
+			return true;
+		}
+	}
+	return false;
+}
@@ -23,7 +23,21 @@
 
 #include "./structs/HoneywireBook.h"
 
+#include <stdbool.h>
+#include <stddef.h>
+
 /**
  * Parse HoneYaml file and return the parsed file as a HoneywiresConfig
  */
 HoneywiresConfig* parseHoneYamlFile(const char* honeyamlFilePath);
+
+/**
+ * Parse the HoneYaml content of @length bytes in @buffer (e.g. a file that was already read for comparing its content hash) and return
+ * it as a HoneywiresConfig
+ */
+HoneywiresConfig* parseHoneYamlBuffer(const unsigned char* buffer, size_t length);
+
+/**
+ * YAML 1.1 boolean of a scalar (e.g. "enabled: yes"), everything but "y", "yes", "true" and "on" is false.
+ */
+bool strToBool(const char* stringToConvert);
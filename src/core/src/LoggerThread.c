@@ -0,0 +1,160 @@
+// Copyright 2024 Dynatrace LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Portions of this code, as identified in remarks, are provided under the
+// Creative Commons BY-SA 4.0 or the MIT license, and are provided without
+// any warranty. In each of the remarks, we have provided attribution to the
+// original creators and other attribution parties, along with the title of
+// the code (if known) a copyright notice and a link to the license, and a
+// statement indicating whether or not we have modified the code.
+
+#include "LoggerThread.h"
+#include "Utils.h"
+#include "structs/GlobalVariables.h"
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+/**
+ * Only accessed while holding the consumerMutex of globals.logRing.
+ */
+static int logFileFd = -1;
+static bool logFileFailed = false;
+static unsigned long reportedDropCount = 0;
+
+/**
+ * Open the LOG_FILE once for appending. O_APPEND keeps each writev() atomic towards the other processes logging into the same file.
+ */
+static bool openLogFile() {
+	if (logFileFd != -1) {
+		return true;
+	}
+	if (logFileFailed) {
+		return false;
+	}
+
+	logFileFd = open(LOG_FILE, O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0644);
+	if (logFileFd == -1) {
+		logFileFailed = true;
+		fprintf(stderr,
+				"!-- Process is running with deception, but won't produce any logs. Reason: No permission to generate a log file \"%s\"!\n",
+				LOG_FILE);
+		return false;
+	}
+
+	return true;
+}
+
+static void flushLoggerOnExit() {
+	LogRing* logRing = __atomic_load_n(&(globals.logRing), __ATOMIC_ACQUIRE);
+
+	if (logRing != NULL) {
+		flushLogRing(logRing);
+	}
+}
+
+void* loggerThread(void* argp) {
+	LogRing* logRing = argp;
+
+	while (1) {
+		flushLogRing(logRing);
+
+		waitForLogRecords(logRing, LOGGER_IDLE_TIMEOUT_MS);
+		usleep(LOGGER_FLUSH_INTERVAL);
+	}
+}
+
+void startLoggerThread() {
+	LogRing* logRing = initLogRing();
+	if (logRing == NULL) {
+		simpleLogger(LoggerPriority__ERROR, "!-- startLoggerThread(): Couldn't allocate the log ring, logging stays synchronous!\n");
+		return;
+	}
+
+	pthread_t thread;
+	if (pthread_create(&thread, NULL, loggerThread, logRing) != 0) {
+		simpleLogger(LoggerPriority__ERROR, "!-- startLoggerThread(): Couldn't start the logger thread, logging stays synchronous!\n");
+		return;
+	}
+	pthread_detach(thread);
+
+	__atomic_store_n(&(globals.logRing), logRing, __ATOMIC_RELEASE);
+	atexit(flushLoggerOnExit);
+}
+
+void restartLoggerThread() {
+	if (__atomic_load_n(&(globals.logRing), __ATOMIC_ACQUIRE) == NULL) {
+		return;
+	}
+
+	// the inherited ring may contain records claimed by threads that don't exist anymore, its content is flushed by the parent
+	LogRing* logRing = initLogRing();
+	pthread_t thread;
+	reportedDropCount = 0;
+	if (logRing == NULL || pthread_create(&thread, NULL, loggerThread, logRing) != 0) {
+		__atomic_store_n(&(globals.logRing), NULL, __ATOMIC_RELEASE);
+		simpleLogger(LoggerPriority__ERROR, "!-- restartLoggerThread(): Couldn't restart the logger thread, logging stays synchronous!\n");
+		return;
+	}
+	pthread_detach(thread);
+
+	__atomic_store_n(&(globals.logRing), logRing, __ATOMIC_RELEASE);
+}
+
+void flushLogRing(LogRing* logRing) {
+	struct iovec iov[LOGGER_BATCH_LENGTH + 1];
+	char dropNotice[LOG_RECORD_MAX_LENGTH];
+	int recordCount;
+
+	pthread_mutex_lock(&(logRing->consumerMutex));
+
+	do {
+		LogRecord* record;
+		recordCount = 0;
+
+		while (recordCount < LOGGER_BATCH_LENGTH && (record = peekLogRecord(logRing, recordCount)) != NULL) {
+			iov[recordCount].iov_base = record->text;
+			iov[recordCount].iov_len = record->length;
+			recordCount++;
+		}
+
+		int iovCount = recordCount;
+		unsigned long dropCount = __atomic_load_n(&(logRing->dropCount), __ATOMIC_RELAXED);
+
+		if (dropCount != reportedDropCount) {
+			int length = snprintf(
+					dropNotice,
+					sizeof(dropNotice),
+					"!-- simpleLogger(): %lu log lines dropped since the log ring was full!\n",
+					dropCount - reportedDropCount);
+			iov[iovCount].iov_base = dropNotice;
+			iov[iovCount].iov_len = length;
+			iovCount++;
+			reportedDropCount = dropCount;
+		}
+
+		// records are discarded if the LOG_FILE can't be opened, so producers don't start dropping
+		if (iovCount > 0 && openLogFile()) {
+			writev(logFileFd, iov, iovCount);
+		}
+
+		releaseLogRecords(logRing, recordCount);
+	} while (recordCount == LOGGER_BATCH_LENGTH);
+
+	pthread_mutex_unlock(&(logRing->consumerMutex));
+}
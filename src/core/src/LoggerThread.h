@@ -0,0 +1,62 @@
+// Copyright 2024 Dynatrace LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Portions of this code, as identified in remarks, are provided under the
+// Creative Commons BY-SA 4.0 or the MIT license, and are provided without
+// any warranty. In each of the remarks, we have provided attribution to the
+// original creators and other attribution parties, along with the title of
+// the code (if known) a copyright notice and a link to the license, and a
+// statement indicating whether or not we have modified the code.
+
+#pragma once
+
+#include "structs/LogRing.h"
+
+/**
+ * Time in microseconds the loggerThread collects further log lines after it got woken up by the first one, i.e. the maximal delay until
+ * a log line reaches the LOG_FILE. Lines pushed meanwhile don't wake it again.
+ */
+#define LOGGER_FLUSH_INTERVAL 50000
+
+/**
+ * Time in milliseconds the loggerThread sleeps on the empty globals.logRing at most, only a fallback in case a wakeup is missed.
+ */
+#define LOGGER_IDLE_TIMEOUT_MS 60000
+
+/**
+ * Maximal number of log records written with a single writev() call.
+ */
+#define LOGGER_BATCH_LENGTH 64
+
+/**
+ * Thread that drains globals.logRing into the LOG_FILE. It sleeps while the ring is empty, so idle processes aren't woken up.
+ */
+void* loggerThread(void* argp);
+
+/**
+ * Allocate globals.logRing and start the loggerThread. Until this is called (or if it fails) simpleLogger() writes synchronously.
+ */
+void startLoggerThread();
+
+/**
+ * Replace globals.logRing by a new one with its own loggerThread in a forked child process. The flushLoggerOnExit() handler registered
+ * by startLoggerThread() is inherited and flushes the new ring.
+ */
+void restartLoggerThread();
+
+/**
+ * Write all records of @logRing to the LOG_FILE, batched into as few writev() calls as possible. Also called on process exit to not
+ * lose the records written since the last interval.
+ */
+void flushLogRing(LogRing* logRing);
@@ -21,18 +21,190 @@
 
 #include "SharedLibraries.h"
 #include "HoneBookThread.h"
+#include "LoggerThread.h"
 #include "Utils.h"
 #include "structs/GlobalVariables.h"
 #include "structs/HoneywireBook.h"
 #include "structs/SupportedTechnology.h"
 
 #include <arpa/inet.h>
-#include <dlfcn.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 
+/**
+ * globals.sharedLibraryMethods is resolved exactly once per process by the constructor of the shared object (see
+ * initSharedObject()). Afterwards every overwritten libc-method is a single indirect call into the original libc-method (process without
+ * deception) or the deception implementation (e.g. read_default) without any dlsym() lookup or check.
+ */
+static pthread_once_t sharedLibraryMethodsOnce = PTHREAD_ONCE_INIT;
+
+/**
+ * argv[0] passed to the constructor of the shared object, NULL if the methods are resolved before it is called.
+ */
+static char* startArgv0 = NULL;
+
+static void initSharedLibraryMethods(void) {
+	char processName[PROCESS_NAME_MAX_LENGTH];
+
+	if (startArgv0 != NULL) {
+		globals.supportedTechnology = supportedTechnologyTypeID(startArgv0);
+	} else if (readProcessName(processName, sizeof(processName))) {
+		globals.supportedTechnology = supportedTechnologyTypeID(processName);
+	} else {
+		globals.supportedTechnology = SUPPORTED_TECHNOLOGY_NOT_FOUND;
+	}
+
+	setGlobalSharedLibrary(globals.supportedTechnology);
+}
+
+static void __attribute__((noinline, cold)) resolveSharedLibraryMethods(void) {
+	pthread_once(&sharedLibraryMethodsOnce, initSharedLibraryMethods);
+}
+
+/**
+ * glibc passes argc, argv and envp to the constructors of shared objects, which run before __libc_start_main.
+ */
+static void __attribute__((constructor)) initSharedObject(int argc, char** argv, char** envp) {
+	startArgv0 = argc > 0 && argv != NULL ? argv[0] : NULL;
+	resolveSharedLibraryMethods();
+}
+
+/**
+ * Initial targets of globals.sharedLibraryMethods (see GlobalVariables.c): calls of the overwritten libc-methods before initSharedObject()
+ * (e.g. by constructors of shared objects that are initialized earlier) resolve all methods and forward the call, so the overwritten
+ * libc-methods never test if they are resolved.
+ */
+int unresolvedBind(int sockfd, const struct sockaddr* address, socklen_t address_len) {
+	resolveSharedLibraryMethods();
+	return globals.sharedLibraryMethods.bind_global(sockfd, address, address_len);
+}
+
+int unresolvedAccept(int socket, struct sockaddr* address, socklen_t* address_len) {
+	resolveSharedLibraryMethods();
+	return globals.sharedLibraryMethods.accept_global(socket, address, address_len);
+}
+
+int unresolvedAccept4(int sockfd, struct sockaddr* address, socklen_t* addrlen, int flags) {
+	resolveSharedLibraryMethods();
+	return globals.sharedLibraryMethods.accept4_global(sockfd, address, addrlen, flags);
+}
+
+int unresolvedGetsockname(int socket, struct sockaddr* address, socklen_t* restrict address_len) {
+	resolveSharedLibraryMethods();
+	return globals.sharedLibraryMethods.getsockname_global(socket, address, address_len);
+}
+
+ssize_t unresolvedRecv(int sockfd, void* buf, size_t len, int flags) {
+	resolveSharedLibraryMethods();
+	return globals.sharedLibraryMethods.recv_global(sockfd, buf, len, flags);
+}
+
+ssize_t unresolvedSend(int sockfd, const void* buf, size_t len, int flags) {
+	resolveSharedLibraryMethods();
+	return globals.sharedLibraryMethods.send_global(sockfd, buf, len, flags);
+}
+
+ssize_t unresolvedRead(int fd, void* buf, size_t count) {
+	resolveSharedLibraryMethods();
+	return globals.sharedLibraryMethods.read_global(fd, buf, count);
+}
+
+ssize_t unresolvedWrite(int fd, const void* buf, size_t count) {
+	resolveSharedLibraryMethods();
+	return globals.sharedLibraryMethods.write_global(fd, buf, count);
+}
+
+ssize_t unresolvedReadv(int fd, const struct iovec* iov, int iovcnt) {
+	resolveSharedLibraryMethods();
+	return globals.sharedLibraryMethods.readv_global(fd, iov, iovcnt);
+}
+
+ssize_t unresolvedRecvmsg(int sockfd, struct msghdr* msg, int flags) {
+	resolveSharedLibraryMethods();
+	return globals.sharedLibraryMethods.recvmsg_global(sockfd, msg, flags);
+}
+
+ssize_t unresolvedRecvfrom(int sockfd, void* buf, size_t len, int flags, struct sockaddr* src_addr, socklen_t* addrlen) {
+	resolveSharedLibraryMethods();
+	return globals.sharedLibraryMethods.recvfrom_global(sockfd, buf, len, flags, src_addr, addrlen);
+}
+
+ssize_t unresolvedWritev(int fd, const struct iovec* iov, int iovcnt) {
+	resolveSharedLibraryMethods();
+	return globals.sharedLibraryMethods.writev_global(fd, iov, iovcnt);
+}
+
+ssize_t unresolvedSendmsg(int sockfd, const struct msghdr* msg, int flags) {
+	resolveSharedLibraryMethods();
+	return globals.sharedLibraryMethods.sendmsg_global(sockfd, msg, flags);
+}
+
+ssize_t unresolvedSendto(int sockfd, const void* buf, size_t len, int flags, const struct sockaddr* dest_addr, socklen_t addrlen) {
+	resolveSharedLibraryMethods();
+	return globals.sharedLibraryMethods.sendto_global(sockfd, buf, len, flags, dest_addr, addrlen);
+}
+
+ssize_t unresolvedSendfile(int out_fd, int in_fd, off_t* offset, size_t count) {
+	resolveSharedLibraryMethods();
+	return globals.sharedLibraryMethods.sendfile_global(out_fd, in_fd, offset, count);
+}
+
+int unresolvedClose(int fd) {
+	resolveSharedLibraryMethods();
+	return globals.sharedLibraryMethods.close_global(fd);
+}
+
+/**
+ * pthread_atfork() handlers of a process with deception. A child of fork() (e.g. a worker of a pre-forking server) only inherits the
+ * forking thread, so the locks taken by other threads are held across the fork() and the honeBookThread and loggerThread are started
+ * again in the child. The already parsed honeywiresBook is shared with the child copy-on-write.
+ */
+static void prepareFork(void) {
+	prepareHoneywiresBookFork(globals.honeywiresBook);
+	pthread_mutex_lock(&(globals.socketInfoPool.mutex));
+}
+
+static void parentAfterFork(void) {
+	pthread_mutex_unlock(&(globals.socketInfoPool.mutex));
+	parentHoneywiresBookFork(globals.honeywiresBook);
+}
+
+static void childAfterFork(void) {
+	pthread_mutex_unlock(&(globals.socketInfoPool.mutex));
+	childHoneywiresBookFork(globals.honeywiresBook);
+
+	restartLoggerThread();
+	simpleLogger(LoggerPriority__INFO, " [-] childAfterFork(): pid: %d (parent pid: %d)\n", getpid(), getppid());
+
+	restartHoneyBookUpdateThread(globals.honeywiresBook);
+}
+
+static pthread_once_t startDeceptionOnce = PTHREAD_ONCE_INIT;
+
+static void initDeception(void) {
+	startLoggerThread();
+	simpleLogger(LoggerPriority__INFO, " [-] startDeception(): pid: %d\n", getpid());
+
+	if (!initFdTable(&(globals.fdTable))) {
+		simpleLogger(LoggerPriority__ERROR, "!-- startDeception(): Couldn't reserve the fd table, no connection will be traced!\n");
+	}
+
+	// hooks of other threads may already load the pointer, the book is complete before
+	__atomic_store_n(&(globals.honeywiresBook), initHoneywiresBook(), __ATOMIC_RELEASE);
+
+	// the first connections of the port are already deceived, the honeBookThread only picks up later changes
+	updateGlobalStateIfUpdateExists(true);
+	startHoneyBookUpdateThread(globals.honeywiresBook);
+	pthread_atfork(prepareFork, parentAfterFork, childAfterFork);
+}
+
+void startDeception() {
+	pthread_once(&startDeceptionOnce, initDeception);
+}
+
 /**
  * Use the __libc_start_main to initialize variable and start a additional threat for handling asynchronous workload like updating
  * configuration
@@ -46,89 +218,87 @@ int __libc_start_main(
 		void (*rtld_fini)(void),
 		void(*stack_end)) {
 
-	SUPPORTED_TECHNOLOGY supportedTechnology = supportedTechnologyTypeID(argv[0]);
+	// resolved by initSharedObject() already, unless the constructors of the shared object weren't run
+	startArgv0 = argv[0];
+	resolveSharedLibraryMethods();
 
-	if (supportedTechnology != SUPPORTED_TECHNOLOGY_NOT_FOUND) {
+	// everything else is started by startDeception() once the process binds a deceived port
+	if (globals.supportedTechnology != SUPPORTED_TECHNOLOGY_NOT_FOUND) {
 		int pid = getpid();
 		simpleLogger(LoggerPriority__INFO, " [-] __libc_start_main(arguments count: %d; argv[0]: %s): pid: %d \n", argc, argv[0], pid);
-
-		globals.honeywiresBook = initHoneywiresBook();
-		startHoneyBookUpdateThread(globals.honeywiresBook);
 	}
 
-	setGlobalSharedLibrary(supportedTechnology);
-
 	return globals.sharedLibraryMethods.main_global(main, argc, argv, init, fini, rtld_fini, stack_end);
 }
 
 int bind(int sockfd, const struct sockaddr* address, socklen_t address_len) {
-	if (globals.sharedLibraryMethods.bind_global != NULL) {
-		return globals.sharedLibraryMethods.bind_global(sockfd, address, address_len);
-	} else {
-		return ((func_bind_t)dlsym(RTLD_NEXT, "bind"))(sockfd, address, address_len);
-	}
+	return globals.sharedLibraryMethods.bind_global(sockfd, address, address_len);
 }
 
 int accept(int socket, struct sockaddr* restrict address, socklen_t* restrict address_len) {
-	if (globals.sharedLibraryMethods.accept_global != NULL) {
-		return globals.sharedLibraryMethods.accept_global(socket, address, address_len);
-	} else {
-		return ((func_accept_t)dlsym(RTLD_NEXT, "accept"))(socket, address, address_len);
-	}
+	return globals.sharedLibraryMethods.accept_global(socket, address, address_len);
 }
 
 int accept4(int sockfd, struct sockaddr* address, socklen_t* addrlen, int flags) {
-	if (globals.sharedLibraryMethods.accept4_global != NULL) {
-		return globals.sharedLibraryMethods.accept4_global(sockfd, address, addrlen, flags);
-	} else {
-		return ((func_accept4_t)dlsym(RTLD_NEXT, "accept4"))(sockfd, address, addrlen, flags);
-	}
+	return globals.sharedLibraryMethods.accept4_global(sockfd, address, addrlen, flags);
 }
 
 int getsockname(int socket, struct sockaddr* restrict address, socklen_t* restrict address_len) {
-	if (globals.sharedLibraryMethods.getsockname_global != NULL) {
-		return globals.sharedLibraryMethods.getsockname_global(socket, address, address_len);
-	} else {
-		return ((func_getsockname_t)dlsym(RTLD_NEXT, "getsockname"))(socket, address, address_len);
-	}
+	return globals.sharedLibraryMethods.getsockname_global(socket, address, address_len);
 }
 
 ssize_t read(int fd, void* buf, size_t count) {
-	if (globals.sharedLibraryMethods.read_global != NULL) {
-		return globals.sharedLibraryMethods.read_global(fd, buf, count);
-	} else {
-		return ((func_read_t)dlsym(RTLD_NEXT, "read"))(fd, buf, count);
-	}
+	return globals.sharedLibraryMethods.read_global(fd, buf, count);
 }
 
 ssize_t write(int fd, const void* buf, size_t count) {
-	if (globals.sharedLibraryMethods.write_global != NULL) {
-		return globals.sharedLibraryMethods.write_global(fd, buf, count);
-	} else {
-		return ((func_write_t)dlsym(RTLD_NEXT, "write"))(fd, buf, count);
-	}
+	return globals.sharedLibraryMethods.write_global(fd, buf, count);
 }
 
 ssize_t recv(int sockfd, void* buf, size_t len, int flags) {
-	if (globals.sharedLibraryMethods.write_global != NULL) {
-		return globals.sharedLibraryMethods.recv_global(sockfd, buf, len, flags);
-	} else {
-		return ((func_recv_t)dlsym(RTLD_NEXT, "recv"))(sockfd, buf, len, flags);
-	}
+	return globals.sharedLibraryMethods.recv_global(sockfd, buf, len, flags);
 }
 
 ssize_t send(int sockfd, const void* buf, size_t len, int flags) {
-	if (globals.sharedLibraryMethods.write_global != NULL) {
-		return globals.sharedLibraryMethods.send_global(sockfd, buf, len, flags);
-	} else {
-		return ((func_send_t)dlsym(RTLD_NEXT, "send"))(sockfd, buf, len, flags);
-	}
+	return globals.sharedLibraryMethods.send_global(sockfd, buf, len, flags);
+}
+
+ssize_t readv(int fd, const struct iovec* iov, int iovcnt) {
+	return globals.sharedLibraryMethods.readv_global(fd, iov, iovcnt);
+}
+
+ssize_t recvmsg(int sockfd, struct msghdr* msg, int flags) {
+	return globals.sharedLibraryMethods.recvmsg_global(sockfd, msg, flags);
+}
+
+ssize_t recvfrom(int sockfd, void* buf, size_t len, int flags, struct sockaddr* src_addr, socklen_t* addrlen) {
+	return globals.sharedLibraryMethods.recvfrom_global(sockfd, buf, len, flags, src_addr, addrlen);
+}
+
+ssize_t writev(int fd, const struct iovec* iov, int iovcnt) {
+	return globals.sharedLibraryMethods.writev_global(fd, iov, iovcnt);
+}
+
+ssize_t sendmsg(int sockfd, const struct msghdr* msg, int flags) {
+	return globals.sharedLibraryMethods.sendmsg_global(sockfd, msg, flags);
+}
+
+ssize_t sendto(int sockfd, const void* buf, size_t len, int flags, const struct sockaddr* dest_addr, socklen_t addrlen) {
+	return globals.sharedLibraryMethods.sendto_global(sockfd, buf, len, flags, dest_addr, addrlen);
+}
+
+ssize_t sendfile(int out_fd, int in_fd, off_t* offset, size_t count) {
+	return globals.sharedLibraryMethods.sendfile_global(out_fd, in_fd, offset, count);
+}
+
+/**
+ * Large file variant of sendfile() called by e.g. the JVM, off_t and off64_t are the same on the supported 64-bit platforms.
+ */
+_Static_assert(sizeof(off_t) == 8, "sendfile64() is only overwritten for a 64-bit off_t");
+ssize_t sendfile64(int out_fd, int in_fd, off_t* offset, size_t count) {
+	return sendfile(out_fd, in_fd, offset, count);
 }
 
 int close(int fd) {
-	if (globals.sharedLibraryMethods.close_global != NULL) {
-		return globals.sharedLibraryMethods.close_global(fd);
-	} else {
-		return ((func_close_t)dlsym(RTLD_NEXT, "close"))(fd);
-	}
+	return globals.sharedLibraryMethods.close_global(fd);
 }
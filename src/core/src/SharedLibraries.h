@@ -23,8 +23,38 @@
 
 #include "./structs/SharedLibraryMethods.h"
 
+#include <sys/sendfile.h>
 #include <sys/socket.h>
 #include <sys/types.h>
+#include <sys/uio.h>
+
+/**
+ * Start the deception of a supported process once: fdTable, honeywiresBook with the current config, honeBookThread and loggerThread.
+ * Called by the first bind()/getsockname() of a deceived port, so processes that never listen on one (e.g. CLI scripts, build tools or
+ * JVM utilities) don't pay for any of it.
+ */
+void startDeception();
+
+/**
+ * Initial values of globals.sharedLibraryMethods, which resolve all methods with the first call of an overwritten shared library method
+ * before the constructor of the shared object and forward the call.
+ */
+int unresolvedBind(int sockfd, const struct sockaddr* address, socklen_t address_len);
+int unresolvedAccept(int socket, struct sockaddr* address, socklen_t* address_len);
+int unresolvedAccept4(int sockfd, struct sockaddr* address, socklen_t* addrlen, int flags);
+int unresolvedGetsockname(int socket, struct sockaddr* address, socklen_t* restrict address_len);
+ssize_t unresolvedRecv(int sockfd, void* buf, size_t len, int flags);
+ssize_t unresolvedSend(int sockfd, const void* buf, size_t len, int flags);
+ssize_t unresolvedRead(int fd, void* buf, size_t count);
+ssize_t unresolvedWrite(int fd, const void* buf, size_t count);
+ssize_t unresolvedReadv(int fd, const struct iovec* iov, int iovcnt);
+ssize_t unresolvedRecvmsg(int sockfd, struct msghdr* msg, int flags);
+ssize_t unresolvedRecvfrom(int sockfd, void* buf, size_t len, int flags, struct sockaddr* src_addr, socklen_t* addrlen);
+ssize_t unresolvedWritev(int fd, const struct iovec* iov, int iovcnt);
+ssize_t unresolvedSendmsg(int sockfd, const struct msghdr* msg, int flags);
+ssize_t unresolvedSendto(int sockfd, const void* buf, size_t len, int flags, const struct sockaddr* dest_addr, socklen_t addrlen);
+ssize_t unresolvedSendfile(int out_fd, int in_fd, off_t* offset, size_t count);
+int unresolvedClose(int fd);
 
 /**
  * Overwritten shared library methods.
@@ -37,4 +67,12 @@ ssize_t read(int fd, void* buf, size_t count);
 ssize_t write(int fd, const void* buf, size_t count);
 ssize_t recv(int sockfd, void* buf, size_t len, int flags);
 ssize_t send(int sockfd, const void* buf, size_t len, int flags);
+ssize_t readv(int fd, const struct iovec* iov, int iovcnt);
+ssize_t recvmsg(int sockfd, struct msghdr* msg, int flags);
+ssize_t recvfrom(int sockfd, void* buf, size_t len, int flags, struct sockaddr* src_addr, socklen_t* addrlen);
+ssize_t writev(int fd, const struct iovec* iov, int iovcnt);
+ssize_t sendmsg(int sockfd, const struct msghdr* msg, int flags);
+ssize_t sendto(int sockfd, const void* buf, size_t len, int flags, const struct sockaddr* dest_addr, socklen_t addrlen);
+ssize_t sendfile(int out_fd, int in_fd, off_t* offset, size_t count);
+ssize_t sendfile64(int out_fd, int in_fd, off_t* offset, size_t count);
 int close(int fd);
@@ -0,0 +1,223 @@
+// Copyright 2024 Dynatrace LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Portions of this code, as identified in remarks, are provided under the
+// Creative Commons BY-SA 4.0 or the MIT license, and are provided without
+// any warranty. In each of the remarks, we have provided attribution to the
+// original creators and other attribution parties, along with the title of
+// the code (if known) a copyright notice and a link to the license, and a
+// statement indicating whether or not we have modified the code.
+
+#include "SharedModel.h"
+#include "Utils.h"
+#include "structs/GlobalVariables.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * Read the @length bytes of the file @fd into a read-only private anonymous mapping.
+ * @return the mapping, MAP_FAILED if the file couldn't be read completely
+ */
+static void* copyModelImageFile(int fd, size_t length) {
+	void* image = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (image == MAP_FAILED) {
+		return MAP_FAILED;
+	}
+
+	size_t copied = 0;
+	while (copied < length) {
+		ssize_t bytesRead = pread(fd, (char*)image + copied, length - copied, copied);
+		if (bytesRead <= 0) {
+			break;
+		}
+		copied += bytesRead;
+	}
+
+	if (copied != length || mprotect(image, length, PROT_READ) != 0) {
+		munmap(image, length);
+		return MAP_FAILED;
+	}
+	return image;
+}
+
+const ModelImage* mapModelImageFile(const char* path, bool copy, size_t* length) {
+	// symlinks are followed (e.g. the files of a Kubernetes ConfigMap), only the owner of the image itself counts
+	int fd = open(path, O_RDONLY | O_CLOEXEC);
+	if (fd == -1) {
+		return NULL;
+	}
+
+	struct stat fileStat;
+	if (fstat(fd, &fileStat) != 0 || !S_ISREG(fileStat.st_mode) || (fileStat.st_uid != 0 && fileStat.st_uid != geteuid()) ||
+		(fileStat.st_mode & (S_IWGRP | S_IWOTH)) != 0 || fileStat.st_size < (off_t)sizeof(ModelImage) ||
+		fileStat.st_size > MODEL_IMAGE_MAX_LENGTH) {
+		close(fd);
+		return NULL;
+	}
+
+	// a shared mapping stays valid if the file is replaced, a renamed image is never written again
+	void* image = copy ? copyModelImageFile(fd, fileStat.st_size) : mmap(NULL, fileStat.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (image == MAP_FAILED) {
+		return NULL;
+	}
+
+	if (!validateModelImage(image, fileStat.st_size)) {
+		simpleLogger(LoggerPriority__ERROR, "!-- mapModelImageFile(): \"%s\" isn't a valid model image!\n", path);
+		munmap(image, fileStat.st_size);
+		return NULL;
+	}
+
+	*length = fileStat.st_size;
+	return image;
+}
+
+/**
+ * Open the lock file of the SHARED_MODEL_FILE. A lock file that already exists has to be trusted like the SHARED_MODEL_FILE itself (see
+ * mapModelImageFile()), since its owner could hold the lock forever.
+ * @return fd of the lock file, -1 if it can't be opened or isn't trusted
+ */
+static int openSharedModelLock() {
+	int lockFd = open(SHARED_MODEL_LOCK_FILE, O_RDONLY | O_CREAT | O_EXCL | O_CLOEXEC | O_NOFOLLOW, 0644);
+	if (lockFd != -1 || errno != EEXIST) {
+		return lockFd;
+	}
+
+	lockFd = open(SHARED_MODEL_LOCK_FILE, O_RDONLY | O_CLOEXEC | O_NOFOLLOW);
+	if (lockFd == -1) {
+		return -1;
+	}
+
+	struct stat fileStat;
+	if (fstat(lockFd, &fileStat) != 0 || !S_ISREG(fileStat.st_mode) || (fileStat.st_uid != 0 && fileStat.st_uid != geteuid())) {
+		simpleLogger(LoggerPriority__ERROR, "!-- openSharedModelLock(): \"%s\" isn't trusted!\n", SHARED_MODEL_LOCK_FILE);
+		close(lockFd);
+		return -1;
+	}
+
+	return lockFd;
+}
+
+int lockSharedModel() {
+	int lockFd = openSharedModelLock();
+	if (lockFd == -1) {
+		return -1;
+	}
+
+	// another process compiles and publishes the model meanwhile, it's waited for with a bounded backoff only
+	useconds_t backoff = SHARED_MODEL_LOCK_BACKOFF;
+	for (int attempt = 1; flock(lockFd, LOCK_EX | LOCK_NB) != 0; attempt++) {
+		if ((errno != EWOULDBLOCK && errno != EINTR) || attempt == SHARED_MODEL_LOCK_ATTEMPTS) {
+			close(lockFd);
+			return -1;
+		}
+
+		usleep(backoff);
+		backoff *= 2;
+	}
+
+	return lockFd;
+}
+
+void unlockSharedModel(int lockFd) {
+	if (lockFd != -1) {
+		// closing the fd releases the lock
+		close(lockFd);
+	}
+}
+
+SO_HW_Model* mapModelFile(const char* path, uint64_t sourceHash, bool copy) {
+	size_t length;
+	const ModelImage* image = mapModelImageFile(path, copy, &length);
+
+	if (image == NULL) {
+		return NULL;
+	}
+	if (sourceHash != 0 && image->sourceHash != sourceHash) {
+		munmap((void*)image, length);
+		return NULL;
+	}
+
+	SO_HW_Model* model = mapModelImage(image, length);
+	if (model == NULL) {
+		munmap((void*)image, length);
+		return NULL;
+	}
+
+	simpleLogger(LoggerPriority__INFO, " [-] mapModelFile(): mapped generation %lu of \"%s\"\n", image->generation, path);
+	return model;
+}
+
+bool writeModelImageFile(const char* path, const ModelImage* image) {
+	char temporaryPath[PATH_MAX];
+	snprintf(temporaryPath, sizeof(temporaryPath), "%s.%d", path, getpid());
+
+	int fd = open(temporaryPath, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC | O_NOFOLLOW, 0644);
+	if (fd == -1) {
+		return false;
+	}
+
+	size_t written = 0;
+	while (written < image->length) {
+		ssize_t length = write(fd, (const char*)image + written, image->length - written);
+		if (length <= 0) {
+			break;
+		}
+		written += length;
+	}
+
+	if (close(fd) != 0 || written != image->length || rename(temporaryPath, path) != 0) {
+		unlink(temporaryPath);
+		return false;
+	}
+
+	return true;
+}
+
+SO_HW_Model* publishSharedModel(SO_HW_Model* model, uint64_t sourceHash) {
+	uint64_t generation = 1;
+	size_t length;
+	const ModelImage* previousImage = mapModelImageFile(SHARED_MODEL_FILE, false, &length);
+
+	if (previousImage != NULL) {
+		generation = previousImage->generation + 1;
+		munmap((void*)previousImage, length);
+	}
+
+	ModelImage* image = buildModelImage(model, sourceHash, generation);
+	if (image == NULL || !writeModelImageFile(SHARED_MODEL_FILE, image)) {
+		simpleLogger(LoggerPriority__ERROR, "!-- publishSharedModel(): Couldn't write \"%s\", the model isn't shared!\n", SHARED_MODEL_FILE);
+		free(image);
+		return model;
+	}
+	free(image);
+
+	// use the published image as well, so this process shares its pages with all others
+	SO_HW_Model* sharedModel = mapModelFile(SHARED_MODEL_FILE, sourceHash, false);
+	if (sharedModel == NULL) {
+		return model;
+	}
+
+	simpleLogger(LoggerPriority__INFO, " [-] publishSharedModel(): published generation %lu of \"%s\"\n", generation, SHARED_MODEL_FILE);
+	freeSharedObjectHoneywireMapping(model);
+	return sharedModel;
+}
@@ -0,0 +1,73 @@
+// Copyright 2024 Dynatrace LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Portions of this code, as identified in remarks, are provided under the
+// Creative Commons BY-SA 4.0 or the MIT license, and are provided without
+// any warranty. In each of the remarks, we have provided attribution to the
+// original creators and other attribution parties, along with the title of
+// the code (if known) a copyright notice and a link to the license, and a
+// statement indicating whether or not we have modified the code.
+
+#pragma once
+
+#include "structs/HoneyWireSharedObjectModel.h"
+#include "structs/ModelImage.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Map the ModelImage file at @path read-only and validate it. With @copy the image is read into a private anonymous mapping, so a file
+ * that is truncated or whose filesystem goes away (e.g. a stale NFS handle) can't raise SIGBUS while its model is in use. Otherwise the
+ * file itself is mapped and its pages are shared with all processes that map it, so it has to be replaced by rename only (see
+ * writeModelImageFile()), like the SHARED_MODEL_FILE.
+ * @return the mapped image of @length bytes (unmap it with munmap()), NULL if the file doesn't exist, isn't trusted (not a regular file,
+ * owned by another user than root or the process or writable by others) or isn't a valid image of this version
+ */
+const ModelImage* mapModelImageFile(const char* path, bool copy, size_t* length);
+
+/**
+ * Attempts to take the lock of the SHARED_MODEL_FILE and the delay in microseconds in front of the second one, which doubles with each
+ * further attempt (about 0.25 s in total). The lock is taken within the first bind() of the application, so it's never waited for longer.
+ */
+#define SHARED_MODEL_LOCK_ATTEMPTS 8
+#define SHARED_MODEL_LOCK_BACKOFF 1000
+
+/**
+ * Serialize the lookups of the SHARED_MODEL_FILE of all processes on the node, so only one of them compiles a changed HoneYamlFile.
+ * @return fd of the lock to pass to unlockSharedModel(), -1 if SHARED_MODEL_FILE isn't available (e.g. no /dev/shm), its lock file isn't
+ * trusted or another process holds the lock for longer than SHARED_MODEL_LOCK_ATTEMPTS, so the process compiles its own model
+ */
+int lockSharedModel();
+
+void unlockSharedModel(int lockFd);
+
+/**
+ * Map the model of the ModelImage file at @path (see mapModelImageFile() for @copy), e.g. the SHARED_MODEL_FILE published by another
+ * process or a copy of the HONEYAML_IMAGE_FILE compiled by the honeyaml-compiler.
+ * @return NULL if there is none or it was compiled from another content than @sourceHash (0 accepts any content)
+ */
+SO_HW_Model* mapModelFile(const char* path, uint64_t sourceHash, bool copy);
+
+/**
+ * Write the @image to a temporary file next to @path and rename it into place, so no process ever maps a partially written image.
+ */
+bool writeModelImageFile(const char* path, const ModelImage* image);
+
+/**
+ * Publish the compiled @model of the HoneYamlFile with @sourceHash to the SHARED_MODEL_FILE as its next generation and map it in place of
+ * @model, call it while holding lockSharedModel().
+ * @return the mapped model (@model is freed), or @model if the image couldn't be written
+ */
+SO_HW_Model* publishSharedModel(SO_HW_Model* model, uint64_t sourceHash);
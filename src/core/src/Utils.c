@@ -21,18 +21,24 @@
 
 
 #include "Utils.h"
+#include "ByteScan.h"
+#include "SharedLibraries.h"
 #include "structs/GlobalVariables.h"
 
 #include "../../default/src/SharedLibraries_Default.h"
 #include "../../dev/src/SharedLibraries_Dev.h"
 
 #include <arpa/inet.h>
+#include <ctype.h>
 #include <dlfcn.h>
 #include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <fcntl.h>
 #include <sys/file.h>
+#include <sys/syscall.h>
+#include <unistd.h>
 
 void initOriginalSharedLibraryMethods();
 
@@ -45,13 +51,19 @@ void setSharedLibraryMethods(
 		func_write_t writeFunction,
 		func_recv_t recvFunction,
 		func_send_t sendFunction,
+		func_readv_t readvFunction,
+		func_recvmsg_t recvmsgFunction,
+		func_recvfrom_t recvfromFunction,
+		func_writev_t writevFunction,
+		func_sendmsg_t sendmsgFunction,
+		func_sendto_t sendtoFunction,
+		func_sendfile_t sendfileFunction,
 		func_close_t closeFunction);
 
-void simpleLogger(LoggerPriority loggerPriority, const char* format, ...) {
-	if (loggerPriority < globals.loggerPriority) {
-		return;
-	}
-
+/**
+ * Synchronous fallback of simpleLogger() used until the loggerThread is started (or if it couldn't be started).
+ */
+static void writeLogSynchronously(const char* format, va_list args) {
 	FILE* logFile = fopen(LOG_FILE, "a");
 
 	if (logFile == NULL) {
@@ -61,14 +73,9 @@ void simpleLogger(LoggerPriority loggerPriority, const char* format, ...) {
 		return;
 	}
 
-	va_list args;
-	int errorCode = 0;
-
-	errorCode = flock(fileno(logFile), LOCK_EX);
+	int errorCode = flock(fileno(logFile), LOCK_EX);
 	if (errorCode == 0) {
-		va_start(args, format);
-		errorCode = vfprintf(logFile, format, args);
-		va_end(args);
+		vfprintf(logFile, format, args);
 		flock(fileno(logFile), LOCK_UN);
 	} else {
 		fprintf(stderr, "!-- Process is running with deception, but won't produce any logs. Reason: Can not lock logfile with flock()!\n");
@@ -77,26 +84,65 @@ void simpleLogger(LoggerPriority loggerPriority, const char* format, ...) {
 	fclose(logFile);
 }
 
-char* strnstr(char* haystack, const char* needle, int nHaystack) {
-	char* needleInHaystack = strstr(haystack, needle);
+void simpleLoggerWrite(LoggerPriority loggerPriority, const char* format, ...) {
+	if (loggerPriority < globals.loggerPriority) {
+		return;
+	}
 
-	if (needleInHaystack == NULL || (needleInHaystack - haystack) < 0 || (needleInHaystack - haystack) > nHaystack) {
+	va_list args;
+	LogRing* logRing = __atomic_load_n(&(globals.logRing), __ATOMIC_ACQUIRE);
+
+	if (logRing == NULL) {
+		va_start(args, format);
+		writeLogSynchronously(format, args);
+		va_end(args);
+		return;
+	}
+
+	char record[LOG_RECORD_MAX_LENGTH];
+
+	va_start(args, format);
+	int length = vsnprintf(record, sizeof(record), format, args);
+	va_end(args);
+
+	if (length < 0) {
+		return;
+	}
+	// keep truncated lines on their own line
+	if (length >= (int)sizeof(record)) {
+		length = sizeof(record) - 1;
+		record[length - 1] = '\n';
+	}
+
+	pushLogRecord(logRing, record, length);
+}
+
+char* strnstr(char* haystack, const char* needle, int nHaystack) {
+	// a negative length is passed by callers computing it from a line end that wasn't found
+	if (nHaystack <= 0) {
 		return NULL;
 	}
 
-	return needleInHaystack;
+	return (char*)findSubstring(haystack, nHaystack, needle, strlen(needle));
 }
 
-bool strToBool(const char* stringToConvert) {
-	char* TRUE_VALUES[] = {"y", "yes", "true", "on"};
-	const int NUM_TRUE_VALUES = 4;
+bool readProcessName(char* processName, int length) {
+	int fd = syscall(SYS_openat, AT_FDCWD, "/proc/self/cmdline", O_RDONLY | O_CLOEXEC);
 
-	for (int i = 0; i < NUM_TRUE_VALUES; i++) {
-		if (strcasecmp(stringToConvert, TRUE_VALUES[i]) == 0) {
-			return true;
-		}
+	if (fd < 0) {
+		return false;
 	}
-	return false;
+
+	long bytesRead = syscall(SYS_read, fd, processName, length - 1);
+	syscall(SYS_close, fd);
+
+	if (bytesRead <= 0) {
+		return false;
+	}
+
+	// cmdline separates the arguments with '\0', so the string ends with argv[0]
+	processName[bytesRead] = '\0';
+	return true;
 }
 
 void setGlobalSharedLibrary(SUPPORTED_TECHNOLOGY technology) {
@@ -116,6 +162,13 @@ void setGlobalSharedLibrary(SUPPORTED_TECHNOLOGY technology) {
 				&write_default,
 				&recv_default,
 				&send_default,
+				&readv_default,
+				&recvmsg_default,
+				&recvfrom_default,
+				&writev_default,
+				&sendmsg_default,
+				&sendto_default,
+				&sendfile_default,
 				&close_default);
 		break;
 	case SUPPORTED_TECHNOLOGY_NOT_FOUND:
@@ -128,6 +181,13 @@ void setGlobalSharedLibrary(SUPPORTED_TECHNOLOGY technology) {
 				globals.originalSharedLibraryMethods.write_global,
 				globals.originalSharedLibraryMethods.recv_global,
 				globals.originalSharedLibraryMethods.send_global,
+				globals.originalSharedLibraryMethods.readv_global,
+				globals.originalSharedLibraryMethods.recvmsg_global,
+				globals.originalSharedLibraryMethods.recvfrom_global,
+				globals.originalSharedLibraryMethods.writev_global,
+				globals.originalSharedLibraryMethods.sendmsg_global,
+				globals.originalSharedLibraryMethods.sendto_global,
+				globals.originalSharedLibraryMethods.sendfile_global,
 				globals.originalSharedLibraryMethods.close_global);
 		break;
 	}
@@ -144,6 +204,13 @@ void initOriginalSharedLibraryMethods() {
 	globals.originalSharedLibraryMethods.write_global = (func_write_t)dlsym(RTLD_NEXT, "write");
 	globals.originalSharedLibraryMethods.recv_global = (func_recv_t)dlsym(RTLD_NEXT, "recv");
 	globals.originalSharedLibraryMethods.send_global = (func_send_t)dlsym(RTLD_NEXT, "send");
+	globals.originalSharedLibraryMethods.readv_global = (func_readv_t)dlsym(RTLD_NEXT, "readv");
+	globals.originalSharedLibraryMethods.recvmsg_global = (func_recvmsg_t)dlsym(RTLD_NEXT, "recvmsg");
+	globals.originalSharedLibraryMethods.recvfrom_global = (func_recvfrom_t)dlsym(RTLD_NEXT, "recvfrom");
+	globals.originalSharedLibraryMethods.writev_global = (func_writev_t)dlsym(RTLD_NEXT, "writev");
+	globals.originalSharedLibraryMethods.sendmsg_global = (func_sendmsg_t)dlsym(RTLD_NEXT, "sendmsg");
+	globals.originalSharedLibraryMethods.sendto_global = (func_sendto_t)dlsym(RTLD_NEXT, "sendto");
+	globals.originalSharedLibraryMethods.sendfile_global = (func_sendfile_t)dlsym(RTLD_NEXT, "sendfile");
 	globals.originalSharedLibraryMethods.close_global = (func_close_t)dlsym(RTLD_NEXT, "close");
 }
 
@@ -156,6 +223,13 @@ void setSharedLibraryMethods(
 		func_write_t writeFunction,
 		func_recv_t recvFunction,
 		func_send_t sendFunction,
+		func_readv_t readvFunction,
+		func_recvmsg_t recvmsgFunction,
+		func_recvfrom_t recvfromFunction,
+		func_writev_t writevFunction,
+		func_sendmsg_t sendmsgFunction,
+		func_sendto_t sendtoFunction,
+		func_sendfile_t sendfileFunction,
 		func_close_t closeFunction) {
 	globals.sharedLibraryMethods.bind_global = bindFunction;
 	globals.sharedLibraryMethods.accept_global = acceptFunction;
@@ -165,6 +239,13 @@ void setSharedLibraryMethods(
 	globals.sharedLibraryMethods.write_global = writeFunction;
 	globals.sharedLibraryMethods.recv_global = recvFunction;
 	globals.sharedLibraryMethods.send_global = sendFunction;
+	globals.sharedLibraryMethods.readv_global = readvFunction;
+	globals.sharedLibraryMethods.recvmsg_global = recvmsgFunction;
+	globals.sharedLibraryMethods.recvfrom_global = recvfromFunction;
+	globals.sharedLibraryMethods.writev_global = writevFunction;
+	globals.sharedLibraryMethods.sendmsg_global = sendmsgFunction;
+	globals.sharedLibraryMethods.sendto_global = sendtoFunction;
+	globals.sharedLibraryMethods.sendfile_global = sendfileFunction;
 	globals.sharedLibraryMethods.close_global = closeFunction;
 }
 
@@ -172,108 +253,334 @@ bool isIp(sa_family_t sockFamily) {
 	return sockFamily == AF_INET || sockFamily == AF_INET6;
 }
 
-bool isSupportedPort(unsigned port) {
+uint8_t deceivedPortReference(unsigned port) {
 	for (int i = 0; i < DECEIVED_PORTS_COUNT; i++) {
 		if (globals.DECEIVED_PORTS[i] == port) {
-			return true;
+			return i + 1;
 		}
 	}
-	return false;
+	return 0;
+}
+
+void trackBoundSocket(int fd, unsigned port, const char* methodName) {
+	// e.g. getsockname() of a connection accepted on a deceived port
+	if (isTracedFdState(&(globals.fdTable), fd)) {
+		return;
+	}
+
+	uint8_t deceivedPort = deceivedPortReference(port);
+	if (deceivedPort != 0) {
+		// the first deceived port starts the deception of the process
+		startDeception();
+
+		if (listenerDeceivedPort(&(globals.fdTable), fd) != deceivedPort) {
+			simpleLogger(LoggerPriority__INFO, "  |- %s -> connections accepted on sockfd %d (port %u) are traced\n", methodName, fd, port);
+		}
+	}
+	listenFdState(&(globals.fdTable), fd, deceivedPort);
 }
 
 int isSupportedHttpVersion(char* buf, int len) {
-	int httpVersion = -1;
+	const char* end = buf + (len > 0 ? len : 0);
+	const char* position = strnstr(buf, HTTP_VERSION_PREFIX, len);
 
-	for (int i = 0; i < sizeof(globals.SUPPORTED_HTTP_VERSIONS) / sizeof(char*); i++) {
-		if (strnstr(buf, globals.SUPPORTED_HTTP_VERSIONS[i], len) != NULL) {
-			httpVersion = i;
-			break;
+	// all SUPPORTED_HTTP_VERSIONS share the HTTP_VERSION_PREFIX: scan for it once and compare the versions only at its occurrences
+	while (position != NULL) {
+		for (int i = 0; i < SUPPORTED_HTTP_VERSIONS_COUNT; i++) {
+			size_t versionLength = strlen(globals.SUPPORTED_HTTP_VERSIONS[i]);
+
+			if ((size_t)(end - position) >= versionLength && memcmp(position, globals.SUPPORTED_HTTP_VERSIONS[i], versionLength) == 0) {
+				return i;
+			}
 		}
+
+		position = findSubstring(position + 1, end - position - 1, HTTP_VERSION_PREFIX, strlen(HTTP_VERSION_PREFIX));
+	}
+
+	return -1;
+}
+
+int statusLineLength(const char* buf, size_t length) {
+	const char* lineEnd = findByte(buf, length, '\n');
+	if (lineEnd == NULL) {
+		return -1;
 	}
 
-	return httpVersion;
+	int lineLength = (int)(lineEnd - buf);
+	return lineLength > 0 && buf[lineLength - 1] == '\r' ? lineLength - 1 : lineLength;
 }
 
-short isSupportedHttpVersionAndMatchingPath(char* buf, int len) {
-	const char* matchingPath = globals.honeywiresBook->so_hw_model->recvModel->matchingPathString;
+bool overWriteStatusCode(ResponseRewrite* rewrite, const char* HTTP_HEADER, const char* newStatusCode) {
+	const char* buf = rewrite->original;
+	int oldFirstLineLength = statusLineLength(buf, rewrite->originalLength);
+	if (oldFirstLineLength == -1) {
+		return false;
+	}
 
-	if (matchingPath == NULL) {
-		simpleLogger(
-				LoggerPriority__ERROR,
-				"!-- startHoneyBookUpdateThrisSupportedHttpVersionAndMatchingPathead(): matchingPathString of recvModel was NULL!");
-		return 0;
+	int httpHeaderLength = strlen(HTTP_HEADER);
+	if (strnstr((char*)buf, HTTP_HEADER, oldFirstLineLength) == NULL) {
+		return false;
 	}
 
-	char* firstLineEnd = strnstr(buf, "\r", len);
+	int newStatusCodeLength = strlen(newStatusCode);
+	int newFirstLineLength = httpHeaderLength + 1 + newStatusCodeLength; // +1 = space
+	char* newFirstLine = reserveResponseScratch(rewrite, newFirstLineLength);
+	if (newFirstLine == NULL) {
+		return false;
+	}
 
-	if (firstLineEnd == NULL) {
-		return 0;
+	memcpy(newFirstLine, buf, httpHeaderLength); // version of the old response
+	newFirstLine[httpHeaderLength] = ' ';
+	memcpy(newFirstLine + httpHeaderLength + 1, newStatusCode, newStatusCodeLength);
+
+	return spliceResponse(rewrite, 0, oldFirstLineLength, newFirstLine, newFirstLineLength);
+}
+
+/**
+ * Apply @instruction to the header line @line if it is a REPLACE_HEADER or DELETE_HEADER instruction for its attribute @name. @applied is
+ * set to false if the instruction matched, but the rewrite couldn't take it (see spliceResponse()).
+ * @return true if the instruction matched the header line
+ */
+static bool runHeaderLineInstruction(
+		const ResponseInstruction* instruction, ResponseRewrite* rewrite, const char* line, const char* lineEnd, const char* name,
+		size_t nameLength, bool* applied) {
+	if (instruction->keyLength != nameLength || strncasecmp(name, instruction->key, nameLength) != 0) {
+		return false;
 	}
 
-	short firstLineLength = (int)(firstLineEnd - buf);
+	if (instruction->type == ResponseInstructionType__DELETE_HEADER) {
+		// the line including its line ending
+		*applied = spliceResponse(rewrite, line - rewrite->original, lineEnd + 1 - line, "", 0);
+		return true;
+	}
 
-	int httpHeaderInUse = isSupportedHttpVersion(buf, firstLineLength);
-	char* isAdminPath = strnstr(buf, matchingPath, firstLineLength);
+	// the value starts after the optional white space behind the ':' and ends before the line ending
+	const char* valueStart = name + nameLength + 1;
+	const char* valueEnd = lineEnd > line && lineEnd[-1] == '\r' ? lineEnd - 1 : lineEnd;
+	while (valueStart < valueEnd && (*valueStart == ' ' || *valueStart == '\t')) {
+		valueStart++;
+	}
 
-	return httpHeaderInUse >= 0 && isAdminPath != NULL;
+	*applied = spliceResponse(rewrite, valueStart - rewrite->original, valueEnd - valueStart, instruction->value, instruction->valueLength);
+	return true;
 }
 
-int overWriteStatusCode(
-		char* oldBuf, const char** newBuf, int oldLength, const char* HTTP_HEADER, const char* newStatusCode) {
-	int oldFirstLineLength = (int)(strnstr(oldBuf, "\r", oldLength) - oldBuf);
-	char* httpHeaderVersion = strnstr(oldBuf, HTTP_HEADER, oldFirstLineLength);
+/**
+ * Apply the first of the @overridesLength @overrides, or else the first REPLACE_HEADER or DELETE_HEADER instruction of @program, for the
+ * attribute @name of the header line @line.
+ * @return 1 if an override is applied to the header line, -1 if an override matched but couldn't be applied, 0 otherwise
+ */
+static int runHeaderLineInstructions(
+		const ResponseProgram* program,
+		const ResponseInstruction* overrides,
+		int overridesLength,
+		ResponseRewrite* rewrite,
+		const char* line,
+		const char* lineEnd,
+		const char* name,
+		size_t nameLength) {
+	bool applied = true;
+	for (int i = 0; i < overridesLength; i++) {
+		if (runHeaderLineInstruction(&(overrides[i]), rewrite, line, lineEnd, name, nameLength, &applied)) {
+			return applied ? 1 : -1;
+		}
+	}
 
-	if (httpHeaderVersion == NULL) {
-		return -1;
+	// most header lines are rejected by the filter, independent of the number of instructions
+	unsigned char initial = tolower((unsigned char)name[0]);
+	if ((program->keyLengths & (1ull << (nameLength < 63 ? nameLength : 63))) == 0 ||
+		(program->keyInitials[initial / 32] & (1u << (initial % 32))) == 0) {
+		return 0;
 	}
 
-	int newFirstLineLength = strlen(HTTP_HEADER) + 1 + strlen(newStatusCode); // +1 = space
-	int restOfLinesLength = oldLength - oldFirstLineLength;
-	int newBufLength = newFirstLineLength + restOfLinesLength;
+	for (int i = 0; i < program->instructionsLength; i++) {
+		if (runHeaderLineInstruction(&(program->instructions[i]), rewrite, line, lineEnd, name, nameLength, &applied)) {
+			return 0;
+		}
+	}
+	return 0;
+}
 
-	*newBuf = (char*)malloc(sizeof(char) * newBufLength + 1); // +1 = space
-	int startPosition = strlen(HTTP_HEADER) + 1;
-	char* pos = *newBuf;
+bool runResponseProgram(
+		const ResponseProgram* program, const ResponseInstruction* overrides, int overridesLength, ResponseRewrite* rewrite) {
+	if (program->instructionsLength == 0 && program->insertedHeaders == NULL && overridesLength == 0) {
+		return true;
+	}
 
-	memcpy(pos, oldBuf, startPosition);                                  // firstline of old response without status code
-	memcpy((pos + startPosition), newStatusCode, strlen(newStatusCode)); // add newStatusCode
-	memcpy((pos + newFirstLineLength), (oldBuf + oldFirstLineLength), newBufLength - newFirstLineLength); // rest of old buffer
+	const char* buf = rewrite->original;
+	const char* end = buf + rewrite->originalLength;
+	const char* statusLineEnd = findByte(buf, end - buf, '\n');
+
+	// single pass over the complete header lines behind the status line
+	const char* line = statusLineEnd != NULL ? statusLineEnd + 1 : end;
+	const char* headerEnd = NULL;
+	int appliedOverrides = 0;
+	bool overridesFailed = false;
+	while (line < end) {
+		const char* lineEnd = findByte(line, end - line, '\n');
+		if (lineEnd == NULL) {
+			break;
+		}
 
-	return newBufLength;
+		// the empty line terminates the header block
+		if (lineEnd == line || (lineEnd == line + 1 && *line == '\r')) {
+			headerEnd = line;
+			break;
+		}
+
+		const char* colon = findByte(line, lineEnd - line, ':');
+		if (colon != NULL) {
+			int overridden = runHeaderLineInstructions(program, overrides, overridesLength, rewrite, line, lineEnd, line, colon - line);
+			appliedOverrides += overridden == 1 ? 1 : 0;
+			overridesFailed = overridesFailed || overridden == -1;
+		}
+
+		line = lineEnd + 1;
+	}
+
+	if (headerEnd != NULL && program->insertedHeaders != NULL) {
+		spliceResponse(rewrite, headerEnd - buf, 0, program->insertedHeaders, program->insertedHeadersLength);
+	}
+
+	return !overridesFailed && appliedOverrides >= overridesLength;
 }
 
-void replaceHttpHeader(char* buf, int length) {
-	const char* ORIGINAL_KEY = globals.honeywiresBook->so_hw_model->sendModel->attributeKey;
-	int originalKeyLength = strlen(ORIGINAL_KEY);
+/**
+ * @return true if the attribute @name of a header line is @expected (case-insensitive)
+ */
+static bool isHeaderName(const char* name, size_t nameLength, const char* expected) {
+	return nameLength == strlen(expected) && strncasecmp(name, expected, nameLength) == 0;
+}
 
-	// Adding ": " to the string since ORIGINAL_KEY only contains the header attribute name like "Date" or "Server".
-	// This is needed for determining what an header attribute is and what not.
-	char* headerAttribute = malloc(sizeof(char) * originalKeyLength + 3);
-	strcpy(headerAttribute, ORIGINAL_KEY);
-	headerAttribute[originalKeyLength] = ':';
-	headerAttribute[originalKeyLength + 1] = ' ';
-	headerAttribute[originalKeyLength + 2] = '\0';
+/**
+ * @return true if the @valueLength bytes of the Content-Type @value announce a textual body (e.g. text/html or application/json), so an
+ * inserted decoy doesn't break a binary format
+ */
+static bool isTextualContentType(const char* value, size_t valueLength) {
+	static const char* TEXTUAL_SUBTYPES[] = {"json", "xml", "javascript"};
 
-	char* headerKeyPosition = strnstr(buf, headerAttribute, length);
+	if (valueLength >= strlen("text/") && strncasecmp(value, "text/", strlen("text/")) == 0) {
+		return true;
+	}
+	for (size_t i = 0; i < sizeof(TEXTUAL_SUBTYPES) / sizeof(TEXTUAL_SUBTYPES[0]); i++) {
+		if (findSubstring(value, valueLength, TEXTUAL_SUBTYPES[i], strlen(TEXTUAL_SUBTYPES[i])) != NULL) {
+			return true;
+		}
+	}
 
-	if (headerKeyPosition == NULL) {
-		free(headerAttribute);
-		return;
+	return false;
+}
+
+BodyInjection* startResponseBodyInjection(
+		const ResponseProgram* program,
+		const char* response,
+		size_t length,
+		bool headResponse,
+		ResponseInstruction* contentLength,
+		char contentLengthValue[CONTENT_LENGTH_VALUE_LENGTH]) {
+	if (program->bodyValue == NULL || headResponse) {
+		return NULL;
 	}
 
-	char* serverValuePosition = headerKeyPosition - 1 + strlen(headerAttribute);
-	char* pos = serverValuePosition;
-	free(headerAttribute);
+	// responses with status code 1xx, 204 or 304 have no body
+	const char* end = response + length;
+	const char* statusLineEnd = findByte(response, length, '\n');
+	const char* statusCode = statusLineEnd != NULL ? findByte(response, statusLineEnd - response, ' ') : NULL;
+	if (statusCode == NULL || statusLineEnd - statusCode < 4) {
+		return NULL;
+	}
+	int status = 0;
+	for (int i = 1; i <= 3; i++) {
+		if (statusCode[i] < '0' || statusCode[i] > '9') {
+			return NULL;
+		}
+		status = status * 10 + statusCode[i] - '0';
+	}
+	if (status < 200 || status == 204 || status == 304) {
+		return NULL;
+	}
 
-	const char* deceptionDemoText = globals.honeywiresBook->so_hw_model->sendModel->newServerString;
-	const int textLen = strlen(deceptionDemoText);
+	// single pass over the header lines for the attributes that frame the body
+	bool textual = false;
+	bool encoded = false;
+	bool chunked = false;
+	bool hasContentLength = false;
+	uint64_t originalContentLength = 0;
+	size_t headerLength = 0;
+	const char* line = statusLineEnd + 1;
+	while (line < end) {
+		const char* lineEnd = findByte(line, end - line, '\n');
+		if (lineEnd == NULL) {
+			break;
+		}
+		if (lineEnd == line || (lineEnd == line + 1 && *line == '\r')) {
+			headerLength = lineEnd + 1 - response;
+			break;
+		}
 
-	// Copy the Server attribute in-place beginning with deceptionDemoText and filled up with 'x' chars.
-	while (*++pos != '\r') {
-		if (pos - serverValuePosition < textLen + 1) {
-			*pos = deceptionDemoText[pos - serverValuePosition - 1];
-		} else {
-			*pos = ' ';
+		const char* colon = findByte(line, lineEnd - line, ':');
+		if (colon != NULL) {
+			const char* value = colon + 1;
+			const char* valueEnd = lineEnd[-1] == '\r' ? lineEnd - 1 : lineEnd;
+			while (value < valueEnd && (*value == ' ' || *value == '\t')) {
+				value++;
+			}
+			size_t valueLength = valueEnd - value;
+
+			if (isHeaderName(line, colon - line, "Content-Type")) {
+				textual = isTextualContentType(value, valueLength);
+			} else if (isHeaderName(line, colon - line, "Content-Encoding")) {
+				encoded = !isHeaderName(value, valueLength, "identity");
+			} else if (isHeaderName(line, colon - line, "Transfer-Encoding")) {
+				// other transfer codings (e.g. gzip, chunked) can't be rewritten
+				chunked = isHeaderName(value, valueLength, "chunked");
+				encoded = encoded || !chunked;
+			} else if (isHeaderName(line, colon - line, "Content-Length")) {
+				hasContentLength = valueLength > 0 && valueLength < CONTENT_LENGTH_VALUE_LENGTH - 1;
+				for (size_t i = 0; hasContentLength && i < valueLength; i++) {
+					hasContentLength = value[i] >= '0' && value[i] <= '9';
+					originalContentLength = originalContentLength * 10 + value[i] - '0';
+				}
+			}
 		}
+
+		line = lineEnd + 1;
+	}
+
+	if (headerLength == 0 || !textual || encoded) {
+		return NULL;
+	}
+
+	BodyInjection* injection = acquireBodyInjection(&(globals.socketInfoPool));
+	if (injection == NULL) {
+		return NULL;
+	}
+
+	BodyFraming framing = chunked ? BodyFraming__CHUNKED : hasContentLength ? BodyFraming__CONTENT_LENGTH : BodyFraming__CLOSE;
+	if (!startBodyInjection(
+				injection,
+				framing,
+				originalContentLength,
+				headerLength,
+				program->bodyAnchor,
+				program->bodyAnchorLength,
+				program->bodyValue,
+				program->bodyValueLength)) {
+		releaseBodyInjection(&(globals.socketInfoPool), injection);
+		return NULL;
 	}
+
+	if (framing == BodyFraming__CONTENT_LENGTH) {
+		contentLength->type = ResponseInstructionType__REPLACE_HEADER;
+		contentLength->key = "Content-Length";
+		contentLength->keyLength = strlen("Content-Length");
+		contentLength->value = contentLengthValue;
+		contentLength->valueLength = snprintf(
+				contentLengthValue,
+				CONTENT_LENGTH_VALUE_LENGTH,
+				"%llu",
+				(unsigned long long)(originalContentLength + program->bodyValueLength));
+	}
+
+	return injection;
 }
@@ -21,26 +21,60 @@
 
 #pragma once
 
+#include "structs/BodyInjection.h"
+#include "structs/HoneyWireSharedObjectModel.h"
 #include "structs/LoggerPriority.h"
+#include "structs/ResponseRewrite.h"
 #include "structs/SupportedTechnology.h"
 
 #include <sys/socket.h>
 #include <stdbool.h>
+#include <stdint.h>
 
 /**
- * Log the @format to the LOG_FILE if the @loggerPriority is higher then globals.loggerPriority.
+ * Lowest LoggerPriority that is compiled into the binary. The release build (see src/Makefile) raises it to LoggerPriority__ERROR, so
+ * INFO-level calls of simpleLogger() are removed entirely, including the evaluation of their arguments.
  */
-void simpleLogger(LoggerPriority loggerPriority, const char* format, ...);
+#ifndef LOGGER_COMPILE_PRIORITY
+#define LOGGER_COMPILE_PRIORITY LoggerPriority__INFO
+#endif
 
 /**
- * Look if the @needle exists in the first @nHaystack chars within the @haystack.
+ * Log the @format to the LOG_FILE if the @loggerPriority is higher then globals.loggerPriority. Once the loggerThread is running, the
+ * line is only formatted and handed over to globals.logRing, so the calling thread never blocks on the file (lines are dropped and
+ * counted if the ring is full).
+ */
+#define simpleLogger(loggerPriority, ...)                     \
+	do {                                                      \
+		if ((loggerPriority) >= LOGGER_COMPILE_PRIORITY) {    \
+			simpleLoggerWrite((loggerPriority), __VA_ARGS__); \
+		}                                                     \
+	} while (0)
+
+/**
+ * Implementation of simpleLogger(), use the macro to let the compiler remove calls below LOGGER_COMPILE_PRIORITY.
+ */
+void simpleLoggerWrite(LoggerPriority loggerPriority, const char* format, ...);
+
+/**
+ * Look if the @needle exists completely within the first @nHaystack chars of the @haystack (no '\0' termination needed, see ByteScan.h).
  * For example the HTTP version attribute(@needle) is only valid within the first
  * line (given by @nHaystack) of the HTTP header buffer (@haystack), because the
  * occurrence in lines below could be just a text or header property.
  */
 char* strnstr(char* haystack, const char* needle, int nHaystack);
 
-bool strToBool(const char* stringToConvert);
+/**
+ * Maximum length of the process name read by readProcessName() including the terminating '\0'.
+ */
+#define PROCESS_NAME_MAX_LENGTH 256
+
+/**
+ * Read argv[0] of the current process from /proc/self/cmdline into @processName (truncated to @length). Only uses raw syscalls and
+ * therefore none of the overwritten libc-methods, so it can be called while the shared library methods are being resolved.
+ * @return false if /proc/self/cmdline isn't readable
+ */
+bool readProcessName(char* processName, int length);
 
 /**
  * initOriginalSharedLibraryMethods is meant to fetch all dynamically linkable method
@@ -58,28 +92,75 @@ void setDevSharedLibraries();
 bool isIp(sa_family_t sockFamily);
 
 /**
- * Check if the port is contained within the tracingPorts of the global state.
+ * @return the reference of @port into the DECEIVED_PORTS of the global state (1 + its index, see FdState.deceivedPort), 0 if @port isn't
+ * deceived
+ */
+uint8_t deceivedPortReference(unsigned port);
+
+/**
+ * Track the socket @fd that @methodName (e.g. bind()) found bound to @port: the connections accepted on it are traced if @port is
+ * deceived (see listenFdState()). Any number of listening sockets can be traced, traced connections are left as they are. The first
+ * deceived port starts the deception of the process (see startDeception()).
+ */
+void trackBoundSocket(int fd, unsigned port, const char* methodName);
+
+/**
+ * Common prefix of all SUPPORTED_HTTP_VERSIONS.
+ */
+#define HTTP_VERSION_PREFIX "HTTP/"
+
+/**
+ * Empty line terminating the header block of a HTTP message.
  */
-bool isSupportedPort(unsigned port);
+#define HEADER_BLOCK_END "\r\n\r\n"
 
 /**
  * Compare if the http string @buf contains one of the global define HTTP-Version-Strings.
+ * @return index of the version within globals.SUPPORTED_HTTP_VERSIONS or -1
  */
 int isSupportedHttpVersion(char* buf, int len);
 
 /**
- * Compare if @buf contains the path "/admin" and isSupportedHttpVersion()
+ * The status line at the start of the @length bytes of a response ends with the first '\n', a '\r' in front of it is optional. The same
+ * rule applies to every method writing a response, so bare LF line endings and a CRLF split between two writes are handled the same.
+ * @return length of the status line without its line ending, -1 if it doesn't end within @buf
+ */
+int statusLineLength(const char* buf, size_t length);
+
+/**
+ * Splice the status line of the response of @rewrite with the status code replaced by @newStatusCode (e.g. "HTTP/1.1 200") into @rewrite.
+ * Has to be called before any other splice, the status line is the beginning of the response.
+ * @return false if the response doesn't start with a complete status line of @HTTP_HEADER or @rewrite is exhausted
+ */
+bool overWriteStatusCode(ResponseRewrite* rewrite, const char* HTTP_HEADER, const char* newStatusCode);
+
+/**
+ * Apply the header instructions of @program to the response of @rewrite in a single pass over its header lines and insert the header lines
+ * of @program in front of the empty line ending the header block. The @overridesLength @overrides (e.g. the Content-Length of a
+ * BodyInjection) take precedence over the instructions of @program. Header lines that continue in a further write() are kept, and
+ * insertions need the end of the header block within the response. The status line is left to overWriteStatusCode().
+ * @return false if an override isn't applied, i.e. no header line matched it or the rewrite couldn't take it (see spliceResponse())
  */
-short isSupportedHttpVersionAndMatchingPath(char* buf, int len);
+bool runResponseProgram(
+		const ResponseProgram* program, const ResponseInstruction* overrides, int overridesLength, ResponseRewrite* rewrite);
 
 /**
- * Malloc @*newBuf and copy @oldBuf with a new status code. Return the length of @*newBuf.
+ * Bytes of the decimal Content-Length value of a BodyInjection, including the terminating '\0'.
  */
-int overWriteStatusCode(
-		char* oldBuf, const char** newBuf, int oldLength, const char* HTTP_HEADER, const char* newStatuscode);
+#define CONTENT_LENGTH_VALUE_LENGTH sizeof("18446744073709551615")
 
 /**
- * Exchange header value of attribute "Server". Does not change content length (i.e. inplace string manipulation with padding/cutting new
- * value derived from honeyaml.yaml if needed).
+ * Start the BodyInjection of @program for the response of @length bytes of @response (its header block has to be complete) if the
+ * response has a textual, not encoded body, i.e. not for a HEAD response (@headResponse) or a status code without body. For a body with
+ * Content-Length, @contentLength is set to the REPLACE_HEADER instruction announcing the decoy (see runResponseProgram()), its value is
+ * written to @contentLengthValue.
+ * @return the BodyInjection taken from globals.socketInfoPool (see releaseBodyInjection()) or NULL if the body of the response isn't
+ * rewritten
  */
-void replaceHttpHeader(char* buf, int length);
+BodyInjection* startResponseBodyInjection(
+		const ResponseProgram* program,
+		const char* response,
+		size_t length,
+		bool headResponse,
+		ResponseInstruction* contentLength,
+		char contentLengthValue[CONTENT_LENGTH_VALUE_LENGTH]);
@@ -0,0 +1,458 @@
+// Copyright 2024 Dynatrace LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Portions of this code, as identified in remarks, are provided under the
+// Creative Commons BY-SA 4.0 or the MIT license, and are provided without
+// any warranty. In each of the remarks, we have provided attribution to the
+// original creators and other attribution parties, along with the title of
+// the code (if known) a copyright notice and a link to the license, and a
+// statement indicating whether or not we have modified the code.
+
+#include "BodyInjection.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define NO_FRAMING ((size_t)-1)
+
+/**
+ * Maximal length of the chunk-size line of the decoy.
+ */
+#define VALUE_CHUNK_SIZE_MAX_LENGTH (2 * sizeof(size_t) + 2)
+
+/**
+ * Rewrite of the bytes of a single call of the application by a BodyInjection.
+ */
+typedef struct {
+	// NULL while the bytes are only passed (see advanceResponseBody())
+	ResponseRewrite* rewrite;
+	const char* buf;
+	size_t length;
+
+	/**
+	 * Start of the chunk framing of the application that isn't removed yet, NO_FRAMING within chunk data.
+	 */
+	size_t framingStart;
+
+	/**
+	 * Chunk of the call that joins the chunk data of the application: its reserved chunk-size line (NULL while passing) and data bytes.
+	 */
+	bool chunkOpen;
+	char* chunkSize;
+	int chunkSizeWidth;
+	size_t chunkLength;
+} BodyPass;
+
+bool startBodyInjection(
+		BodyInjection* injection, BodyFraming framing, uint64_t contentLength, size_t headerLength, const char* anchor, size_t anchorLength,
+		const char* value, size_t valueLength) {
+	if (anchorLength > BODY_INJECTION_ANCHOR_MAX_LENGTH || valueLength > BODY_INJECTION_VALUE_MAX_LENGTH) {
+		return false;
+	}
+
+	injection->framing = framing;
+	memset(&(injection->state), 0, sizeof(BodyInjectionState));
+	injection->state.headerRemaining = headerLength;
+	injection->state.remaining = framing == BodyFraming__CONTENT_LENGTH ? contentLength : 0;
+	injection->state.chunkState = ChunkState__SIZE;
+
+	injection->anchorLength = anchorLength;
+	injection->valueLength = valueLength;
+	memcpy(injection->anchor, anchor, anchorLength);
+	memcpy(injection->value, value, valueLength);
+
+	size_t fallback = 0;
+	for (size_t i = 1; i < anchorLength; i++) {
+		while (fallback > 0 && anchor[i] != anchor[fallback]) {
+			fallback = injection->anchorFallback[fallback - 1];
+		}
+		if (anchor[i] == anchor[fallback]) {
+			fallback++;
+		}
+		injection->anchorFallback[i] = fallback;
+	}
+	if (anchorLength > 0) {
+		injection->anchorFallback[0] = 0;
+	}
+
+	return true;
+}
+
+/**
+ * Match the anchor of @injection in the @length bytes of @data of the body, continuing the match of the previous bytes.
+ * @return true if the anchor is complete, @matchEnd is the offset behind it
+ */
+static bool findAnchor(BodyInjection* injection, const char* data, size_t length, size_t* matchEnd) {
+	size_t matched = injection->state.matched;
+
+	if (matched == injection->anchorLength) {
+		*matchEnd = 0;
+		return true;
+	}
+
+	for (size_t i = 0; i < length; i++) {
+		// skip to the next candidate of the first anchor byte while nothing is matched
+		if (matched == 0) {
+			const char* candidate = memchr(data + i, injection->anchor[0], length - i);
+			if (candidate == NULL) {
+				break;
+			}
+			i = candidate - data;
+		}
+
+		while (matched > 0 && data[i] != injection->anchor[matched]) {
+			matched = injection->anchorFallback[matched - 1];
+		}
+		if (data[i] == injection->anchor[matched]) {
+			matched++;
+		}
+		if (matched == injection->anchorLength) {
+			injection->state.matched = matched;
+			*matchEnd = i + 1;
+			return true;
+		}
+	}
+
+	injection->state.matched = matched;
+	return false;
+}
+
+/**
+ * Check that @splices further splices with @replacementLength bytes fit into the rewrite of @pass, keeping room for closing the chunk of
+ * the call (and for inserting the decoy, as long as it isn't inserted).
+ */
+static bool hasCapacity(const BodyInjection* injection, const BodyPass* pass, int splices, size_t replacementLength) {
+	if (pass->rewrite == NULL) {
+		return true;
+	}
+
+	// the closing CRLF of the chunk in front of a last chunk "0\r\n"
+	int reservedSplices = 1;
+	size_t reservedLength = strlen("\r\n0\r\n");
+	if (!injection->state.injected) {
+		// the decoy, as a chunk of its own if the anchor doesn't occur (see insertValueChunk())
+		reservedSplices++;
+		reservedLength += VALUE_CHUNK_SIZE_MAX_LENGTH + injection->valueLength + strlen("\r\n");
+	}
+
+	// each splice needs up to two segments, the rest of the original one more
+	return pass->rewrite->segmentsLength + 2 * (splices + reservedSplices) + 1 <= RESPONSE_REWRITE_MAX_SEGMENTS &&
+		replacementLength + reservedLength <= RESPONSE_REWRITE_SCRATCH_LENGTH - pass->rewrite->scratchLength;
+}
+
+static void splice(BodyPass* pass, size_t offset, size_t replacedLength, const char* replacement, size_t replacementLength) {
+	if (pass->rewrite != NULL) {
+		spliceResponse(pass->rewrite, offset, replacedLength, replacement, replacementLength);
+	}
+}
+
+/**
+ * Insert the decoy of @injection at @offset of the call of @pass.
+ */
+static void insertValue(BodyInjection* injection, BodyPass* pass, size_t offset) {
+	splice(pass, offset, 0, injection->value, injection->valueLength);
+	injection->state.injected = true;
+	pass->chunkLength += injection->valueLength;
+}
+
+/**
+ * Insert the decoy of @injection in front of the last chunk, whose chunk framing starts at @offset of the call of @pass, since the anchor
+ * didn't occur in the body: into the chunk of the call if it is open, as a chunk of its own otherwise.
+ */
+static void insertValueChunk(BodyInjection* injection, BodyPass* pass, size_t offset) {
+	if (pass->chunkOpen || injection->valueLength == 0) {
+		insertValue(injection, pass, offset);
+		return;
+	}
+
+	char chunk[VALUE_CHUNK_SIZE_MAX_LENGTH + BODY_INJECTION_VALUE_MAX_LENGTH + sizeof("\r\n")];
+	size_t chunkLength = snprintf(chunk, VALUE_CHUNK_SIZE_MAX_LENGTH + 1, "%zx\r\n", injection->valueLength);
+	memcpy(chunk + chunkLength, injection->value, injection->valueLength);
+	chunkLength += injection->valueLength;
+	memcpy(chunk + chunkLength, "\r\n", strlen("\r\n"));
+	chunkLength += strlen("\r\n");
+
+	splice(pass, offset, 0, chunk, chunkLength);
+	injection->state.injected = true;
+}
+
+/**
+ * Open the chunk of the call of @pass in front of the chunk data at @offset, replacing the chunk framing of the application in front of it.
+ * @return false if the rewrite is exhausted
+ */
+static bool openChunk(BodyInjection* injection, BodyPass* pass, size_t offset) {
+	// the chunk holds at most the rest of the call and the decoy
+	size_t maxLength = pass->length - offset + (injection->state.injected ? 0 : injection->valueLength);
+	int width = 1;
+	while (width < (int)(2 * sizeof(size_t)) && (maxLength >> (4 * width)) > 0) {
+		width++;
+	}
+
+	if (!hasCapacity(injection, pass, 1, width + strlen("\r\n"))) {
+		return false;
+	}
+
+	size_t framingStart = pass->framingStart != NO_FRAMING ? pass->framingStart : offset;
+	if (pass->rewrite != NULL) {
+		// the chunk-size is written once the chunk is closed, leading zeros keep the reserved width
+		pass->chunkSize = reserveResponseScratch(pass->rewrite, width + strlen("\r\n"));
+		spliceResponse(pass->rewrite, framingStart, offset - framingStart, pass->chunkSize, width + strlen("\r\n"));
+	}
+	pass->chunkSizeWidth = width;
+	pass->chunkOpen = true;
+	pass->chunkLength = 0;
+	pass->framingStart = NO_FRAMING;
+
+	return true;
+}
+
+/**
+ * Close the chunk of the call of @pass at @offset and replace the chunk framing of the application in front of @offset with the
+ * @terminatorLength bytes of @terminator (e.g. the last chunk).
+ */
+static void closeChunk(BodyPass* pass, size_t offset, const char* terminator, size_t terminatorLength) {
+	size_t framingStart = pass->framingStart != NO_FRAMING ? pass->framingStart : offset;
+	char replacement[sizeof("\r\n0\r\n")];
+	size_t replacementLength = 0;
+
+	if (pass->chunkOpen) {
+		memcpy(replacement, "\r\n", strlen("\r\n"));
+		replacementLength += strlen("\r\n");
+
+		if (pass->chunkSize != NULL) {
+			static const char HEX_DIGITS[] = "0123456789abcdef";
+			size_t chunkLength = pass->chunkLength;
+
+			for (int i = pass->chunkSizeWidth - 1; i >= 0; i--) {
+				pass->chunkSize[i] = HEX_DIGITS[chunkLength & 0xf];
+				chunkLength >>= 4;
+			}
+			memcpy(pass->chunkSize + pass->chunkSizeWidth, "\r\n", strlen("\r\n"));
+		}
+	}
+	memcpy(replacement + replacementLength, terminator, terminatorLength);
+	replacementLength += terminatorLength;
+
+	if (replacementLength > 0 || offset > framingStart) {
+		splice(pass, framingStart, offset - framingStart, replacement, replacementLength);
+	}
+	pass->chunkOpen = false;
+	pass->chunkSize = NULL;
+	pass->framingStart = NO_FRAMING;
+}
+
+/**
+ * @return the value of the hexadecimal digit @byte, -1 if it isn't one
+ */
+static int hexDigitValue(char byte) {
+	if (byte >= '0' && byte <= '9') {
+		return byte - '0';
+	}
+	if (byte >= 'a' && byte <= 'f') {
+		return byte - 'a' + 10;
+	}
+	if (byte >= 'A' && byte <= 'F') {
+		return byte - 'A' + 10;
+	}
+	return -1;
+}
+
+/**
+ * Rewrite the chunked body from @offset of the call of @pass.
+ * @return the end of the bytes of the call that are rewritten
+ */
+static size_t passChunkedBody(BodyInjection* injection, BodyPass* pass, size_t offset) {
+	BodyInjectionState* state = &(injection->state);
+	const char* buf = pass->buf;
+
+	pass->framingStart = state->chunkState == ChunkState__DATA || state->chunkState == ChunkState__TRAILER ? NO_FRAMING : offset;
+	if (!hasCapacity(injection, pass, 0, 0)) {
+		return offset;
+	}
+
+	while (offset < pass->length) {
+		char byte = buf[offset];
+
+		switch (state->chunkState) {
+		case ChunkState__SIZE:
+		case ChunkState__EXTENSION:
+			offset++;
+
+			if (byte != '\n') {
+				int digit = hexDigitValue(byte);
+
+				if (state->chunkState == ChunkState__SIZE && digit != -1) {
+					if (state->remaining < (UINT64_MAX >> 4)) {
+						state->remaining = (state->remaining << 4) | digit;
+					}
+				} else if (byte != '\r') {
+					state->chunkState = ChunkState__EXTENSION;
+				}
+				break;
+			}
+
+			if (state->remaining > 0) {
+				state->chunkState = ChunkState__DATA;
+				break;
+			}
+
+			// the last chunk: the chunk of the call ends in front of it and its trailer section is passed as it is
+			if (!state->injected) {
+				insertValueChunk(injection, pass, pass->framingStart);
+			}
+			closeChunk(pass, offset, "0\r\n", strlen("0\r\n"));
+			state->chunkState = ChunkState__TRAILER;
+			state->trailerLineLength = 0;
+			break;
+		case ChunkState__DATA: {
+			if (!pass->chunkOpen) {
+				if (!openChunk(injection, pass, offset)) {
+					closeChunk(pass, offset, "", 0);
+					return offset;
+				}
+			} else if (pass->framingStart != NO_FRAMING) {
+				if (!hasCapacity(injection, pass, 1, 0)) {
+					closeChunk(pass, offset, "", 0);
+					return offset;
+				}
+				splice(pass, pass->framingStart, offset - pass->framingStart, "", 0);
+				pass->framingStart = NO_FRAMING;
+			}
+
+			size_t length = pass->length - offset < state->remaining ? pass->length - offset : state->remaining;
+			size_t matchEnd;
+			if (!state->injected && findAnchor(injection, buf + offset, length, &matchEnd)) {
+				insertValue(injection, pass, offset + matchEnd);
+			}
+
+			pass->chunkLength += length;
+			state->remaining -= length;
+			offset += length;
+
+			if (state->remaining == 0) {
+				state->chunkState = ChunkState__DATA_END;
+				pass->framingStart = offset;
+			}
+			break;
+		}
+		case ChunkState__DATA_END:
+			offset++;
+
+			if (byte == '\n') {
+				state->chunkState = ChunkState__SIZE;
+
+				// the chunks of the application are consistent again from the next one on
+				if (state->injected) {
+					closeChunk(pass, offset, "", 0);
+					state->done = true;
+					return pass->length;
+				}
+			}
+			break;
+		case ChunkState__TRAILER:
+			offset++;
+
+			if (byte == '\n') {
+				if (state->trailerLineLength == 0) {
+					state->done = true;
+					return pass->length;
+				}
+				state->trailerLineLength = 0;
+			} else if (byte != '\r') {
+				state->trailerLineLength++;
+			}
+			break;
+		}
+	}
+
+	closeChunk(pass, offset, "", 0);
+	return offset;
+}
+
+/**
+ * Rewrite the body delimited by its Content-Length or the end of the connection from @offset of the call of @pass.
+ * @return the end of the bytes of the call that are rewritten
+ */
+static size_t passDelimitedBody(BodyInjection* injection, BodyPass* pass, size_t offset) {
+	BodyInjectionState* state = &(injection->state);
+	size_t length = pass->length - offset;
+
+	if (injection->framing == BodyFraming__CONTENT_LENGTH && state->remaining < length) {
+		length = state->remaining;
+	}
+	if (!hasCapacity(injection, pass, 0, 0)) {
+		return offset;
+	}
+
+	size_t matchEnd;
+	if (findAnchor(injection, pass->buf + offset, length, &matchEnd)) {
+		insertValue(injection, pass, offset + matchEnd);
+		state->done = true;
+	} else if (injection->framing == BodyFraming__CONTENT_LENGTH) {
+		state->remaining -= length;
+
+		// the Content-Length announces the decoy
+		if (state->remaining == 0) {
+			insertValue(injection, pass, offset + length);
+			state->done = true;
+		}
+	}
+
+	return pass->length;
+}
+
+/**
+ * Pass the @length bytes of @buf of the response, splicing into @rewrite unless it is NULL.
+ */
+static void passResponseBody(BodyInjection* injection, ResponseRewrite* rewrite, const char* buf, size_t length) {
+	BodyInjectionState* state = &(injection->state);
+	size_t offset = state->headerRemaining < length ? state->headerRemaining : length;
+
+	state->headerRemaining -= offset;
+	if (state->headerRemaining > 0 || state->done) {
+		return;
+	}
+
+	BodyPass pass = {rewrite, buf, length, NO_FRAMING, false, NULL, 0, 0};
+	size_t end;
+	if (injection->framing == BodyFraming__CHUNKED) {
+		end = passChunkedBody(injection, &pass, offset);
+	} else {
+		end = passDelimitedBody(injection, &pass, offset);
+	}
+
+	if (rewrite != NULL && end < length) {
+		truncateResponseRewrite(rewrite, end);
+	}
+}
+
+void rewriteResponseBody(BodyInjection* injection, ResponseRewrite* rewrite) {
+	passResponseBody(injection, rewrite, rewrite->original, rewrite->originalLength);
+}
+
+void advanceResponseBody(BodyInjection* injection, const char* buf, size_t length) {
+	passResponseBody(injection, NULL, buf, length);
+}
+
+size_t finishResponseBody(BodyInjection* injection, const char** rest) {
+	BodyInjectionState* state = &(injection->state);
+	if (injection->framing != BodyFraming__CLOSE || state->headerRemaining > 0 || state->done) {
+		return 0;
+	}
+
+	state->injected = true;
+	state->done = true;
+	*rest = injection->value;
+	return injection->valueLength;
+}
@@ -0,0 +1,154 @@
+// Copyright 2024 Dynatrace LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Portions of this code, as identified in remarks, are provided under the
+// Creative Commons BY-SA 4.0 or the MIT license, and are provided without
+// any warranty. In each of the remarks, we have provided attribution to the
+// original creators and other attribution parties, along with the title of
+// the code (if known) a copyright notice and a link to the license, and a
+// statement indicating whether or not we have modified the code.
+
+#pragma once
+
+#include "ResponseRewrite.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Maximal length of the anchor a decoy is inserted behind.
+ */
+#define BODY_INJECTION_ANCHOR_MAX_LENGTH 64
+
+/**
+ * Maximal length of a decoy, it has to fit into the scratch buffer of a ResponseRewrite together with the header replacements.
+ */
+#define BODY_INJECTION_VALUE_MAX_LENGTH 512
+
+/**
+ * How the end of a response body is delimited.
+ */
+typedef enum {
+	BodyFraming__CONTENT_LENGTH,
+	BodyFraming__CHUNKED,
+	// the body ends when the connection is closed
+	BodyFraming__CLOSE,
+} BodyFraming;
+
+/**
+ * Position within the chunked transfer coding of a body.
+ */
+typedef enum {
+	// chunk-size (followed by chunk extensions or the line ending)
+	ChunkState__SIZE,
+	ChunkState__EXTENSION,
+	ChunkState__DATA,
+	// line ending behind the chunk data
+	ChunkState__DATA_END,
+	// trailer section behind the last chunk
+	ChunkState__TRAILER,
+} ChunkState;
+
+/**
+ * Progress of a BodyInjection within the response, a plain value so it can be restored when the application has to repeat a part of a
+ * write (see advanceResponseBody()).
+ */
+typedef struct {
+	/**
+	 * Bytes of the header block of the response that aren't passed yet.
+	 */
+	size_t headerRemaining;
+
+	/**
+	 * Bytes of the body (Content-Length) or of the current chunk (chunked) that aren't passed yet.
+	 */
+	uint64_t remaining;
+
+	ChunkState chunkState;
+	size_t trailerLineLength;
+
+	/**
+	 * Bytes of the anchor matched by the end of the passed body.
+	 */
+	size_t matched;
+
+	bool injected;
+	bool done;
+} BodyInjectionState;
+
+/**
+ * Streaming insertion of a decoy (e.g. a fake HTML comment or fake credentials of a JSON object) into the body of a response, behind the
+ * first occurrence of an anchor. If the anchor doesn't occur in the body, the decoy is appended at the end of the body, whatever its framing.
+ * The body is rewritten write by write without buffering it, only the framing is kept consistent:
+ * - Content-Length: the header announces the decoy up front (see startResponseBodyInjection()).
+ * - chunked: the chunks of each write are joined into a single chunk of the rewritten length, until the decoy is inserted and the next
+ *   chunk of the application starts. Without the anchor the decoy ends the last joined chunk or is a chunk of its own in front of the last
+ *   chunk "0".
+ * - close delimited: the decoy is inserted as it is. Without the anchor the end of the body is only known once the connection is closed,
+ *   where the decoy is appended (see finishResponseBody()).
+ * A BodyInjection lives from the header write of the response until the decoy is inserted, so its memory doesn't depend on the size of the
+ * response.
+ */
+typedef struct {
+	BodyFraming framing;
+	BodyInjectionState state;
+
+	size_t anchorLength;
+	size_t valueLength;
+	/**
+	 * Length of the longest proper prefix of anchor[0..i] that is also its suffix (Knuth-Morris-Pratt), so the anchor is matched across
+	 * writes without holding back any byte.
+	 */
+	uint8_t anchorFallback[BODY_INJECTION_ANCHOR_MAX_LENGTH];
+	char anchor[BODY_INJECTION_ANCHOR_MAX_LENGTH];
+	char value[BODY_INJECTION_VALUE_MAX_LENGTH];
+} BodyInjection;
+
+/**
+ * Start @injection inserting the @valueLength bytes of @value behind the @anchorLength bytes of @anchor (at the start of the body if empty)
+ * into a response whose header block has @headerLength bytes and whose body is delimited by @framing (@contentLength for
+ * BodyFraming__CONTENT_LENGTH).
+ * @return false if the anchor or value is too long
+ */
+bool startBodyInjection(
+		BodyInjection* injection, BodyFraming framing, uint64_t contentLength, size_t headerLength, const char* anchor, size_t anchorLength,
+		const char* value, size_t valueLength);
+
+/**
+ * Splice the decoy and the chunk framing of @injection into the bytes of @rewrite (the next bytes of the response) behind the splices that
+ * are already part of it. If the segments or the scratch buffer of @rewrite are exhausted, @rewrite is truncated (see
+ * truncateResponseRewrite()) and @injection stops at its end.
+ */
+void rewriteResponseBody(BodyInjection* injection, ResponseRewrite* rewrite);
+
+/**
+ * Pass the @length bytes of @buf of the response without rewriting them, e.g. to account the bytes of a rewritten write that are sent
+ * after @injection is restored to the state in front of it.
+ */
+void advanceResponseBody(BodyInjection* injection, const char* buf, size_t length);
+
+/**
+ * End the body of @injection at the end of the connection. Only a close delimited body whose anchor didn't occur has a rest, the decoy
+ * (a Content-Length or chunked body ends within the writes of the application).
+ * @return the length of the @rest of the body to write in front of closing the connection, 0 if nothing is left
+ */
+size_t finishResponseBody(BodyInjection* injection, const char** rest);
+
+/**
+ * @return true if nothing is left to rewrite in the response of @injection, i.e. it can be freed
+ */
+static inline bool isBodyInjectionDone(const BodyInjection* injection) {
+	return injection->state.done;
+}
@@ -0,0 +1,90 @@
+// Copyright 2024 Dynatrace LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Portions of this code, as identified in remarks, are provided under the
+// Creative Commons BY-SA 4.0 or the MIT license, and are provided without
+// any warranty. In each of the remarks, we have provided attribution to the
+// original creators and other attribution parties, along with the title of
+// the code (if known) a copyright notice and a link to the license, and a
+// statement indicating whether or not we have modified the code.
+
+#include "FdTable.h"
+
+#include <sys/mman.h>
+#include <sys/resource.h>
+
+bool initFdTable(FdTable* fdTable) {
+	struct rlimit fileLimit;
+	rlim_t length = FD_TABLE_MAX_LENGTH;
+
+	if (getrlimit(RLIMIT_NOFILE, &fileLimit) == 0 && fileLimit.rlim_max != RLIM_INFINITY && fileLimit.rlim_max < length) {
+		length = fileLimit.rlim_max;
+	}
+
+	void* states = mmap(NULL, length * sizeof(FdState), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	if (states == MAP_FAILED) {
+		return false;
+	}
+
+	fdTable->states = states;
+	__atomic_store_n(&(fdTable->length), (int)length, __ATOMIC_RELEASE);
+
+	return true;
+}
+
+void listenFdState(FdTable* fdTable, int fd, uint8_t deceivedPort) {
+	FdState* state = fdState(fdTable, fd);
+
+	// sockets of ports that aren't deceived are only written to drop the mark of a previous socket with the same fd (e.g. after dup2())
+	if (state == NULL || __atomic_load_n(&(state->traced), __ATOMIC_RELAXED) != 0 ||
+		__atomic_load_n(&(state->deceivedPort), __ATOMIC_RELAXED) == deceivedPort) {
+		return;
+	}
+
+	__atomic_store_n(&(state->deceivedPort), deceivedPort, __ATOMIC_RELEASE);
+}
+
+SocketInfo* traceFdState(FdTable* fdTable, int fd, int socketType, uint8_t deceivedPort) {
+	FdState* state = fdState(fdTable, fd);
+
+	if (state == NULL) {
+		return NULL;
+	}
+
+	SocketInfo* staleSocketInfo = state->socketInfo;
+	state->socketType = socketType;
+	state->socketInfo = NULL;
+	__atomic_store_n(&(state->deceivedPort), deceivedPort, __ATOMIC_RELAXED);
+	__atomic_store_n(&(state->traced), 1, __ATOMIC_RELEASE);
+
+	return staleSocketInfo;
+}
+
+SocketInfo* resetFdState(FdTable* fdTable, int fd) {
+	FdState* state = fdState(fdTable, fd);
+
+	// states of other fds are never written to keep their pages untouched
+	if (state == NULL ||
+		(__atomic_load_n(&(state->traced), __ATOMIC_RELAXED) == 0 && __atomic_load_n(&(state->deceivedPort), __ATOMIC_RELAXED) == 0)) {
+		return NULL;
+	}
+
+	SocketInfo* socketInfo = state->socketInfo;
+	__atomic_store_n(&(state->traced), 0, __ATOMIC_RELEASE);
+	__atomic_store_n(&(state->deceivedPort), 0, __ATOMIC_RELEASE);
+	state->socketType = 0;
+	state->socketInfo = NULL;
+
+	return socketInfo;
+}
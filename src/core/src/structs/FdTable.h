@@ -0,0 +1,127 @@
+// Copyright 2024 Dynatrace LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Portions of this code, as identified in remarks, are provided under the
+// Creative Commons BY-SA 4.0 or the MIT license, and are provided without
+// any warranty. In each of the remarks, we have provided attribution to the
+// original creators and other attribution parties, along with the title of
+// the code (if known) a copyright notice and a link to the license, and a
+// statement indicating whether or not we have modified the code.
+
+#pragma once
+
+#include "SocketInfo.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Upper bound of fds covered by the FdTable if RLIMIT_NOFILE is unlimited or larger. Only limits the reserved virtual address space,
+ * memory is allocated page by page when a fd is traced for the first time.
+ */
+#define FD_TABLE_MAX_LENGTH (1 << 24)
+
+/**
+ * State of a single fd, packed into 16 bytes so that 4 fds share a cache line and the fast path of the overwritten read/write methods
+ * only needs a single load.
+ */
+typedef struct {
+	/**
+	 * 1 if the fd is a connection accepted on a listening socket of a deceived port and needs to be further investigated, 0 means ignore.
+	 * Accessed with atomic loads/stores since accept4() and close() of different threads update it while other threads read it.
+	 */
+	uint8_t traced;
+
+	/**
+	 * SO_TYPE of the socket, cached on accept4() so the write methods don't need a getsockopt() call.
+	 */
+	uint8_t socketType;
+
+	/**
+	 * Deceived port the socket is bound to (listening sockets) or accepted on (traced connections) as reference into the table of
+	 * deceived ports (1 + its index), 0 if none. Accessed with atomic loads/stores like traced.
+	 */
+	uint8_t deceivedPort;
+
+	/**
+	 * Per-connection state taken from globals.socketInfoPool once a supported HTTP request was received on the fd, NULL before.
+	 */
+	SocketInfo* socketInfo;
+} FdState;
+
+/**
+ * Per-fd state table indexed by the fd. The table reserves virtual address space for the hard RLIMIT_NOFILE (the soft limit might be
+ * raised at runtime, e.g. by the JVM) with MAP_NORESERVE. Pages are only backed by memory once a state on them is written, reading
+ * untouched states maps the zero page. Since the table never moves, lookups don't need any lock, even with concurrent accept/close.
+ */
+typedef struct {
+	FdState* states;
+
+	/**
+	 * Number of fds covered by states, 0 if the table isn't initialized (e.g. process without deception).
+	 */
+	int length;
+} FdTable;
+
+/**
+ * Reserve the memory for the states of all possible fds of this process.
+ * @return false if the memory couldn't be reserved, @fdTable stays empty in that case.
+ */
+bool initFdTable(FdTable* fdTable);
+
+/**
+ * @return the state of @fd or NULL if @fd isn't covered by the table
+ */
+static inline FdState* fdState(FdTable* fdTable, int fd) {
+	return (unsigned)fd < (unsigned)fdTable->length ? &(fdTable->states[fd]) : NULL;
+}
+
+/**
+ * Fast path check with a single relaxed load if @fd is a traced connection.
+ */
+static inline bool isTracedFdState(FdTable* fdTable, int fd) {
+	return (unsigned)fd < (unsigned)fdTable->length && __atomic_load_n(&(fdTable->states[fd].traced), __ATOMIC_RELAXED) != 0;
+}
+
+/**
+ * @return the deceived port of @fd (see FdState.deceivedPort) if it is a listening socket whose accepted connections are traced, 0 otherwise
+ */
+static inline uint8_t listenerDeceivedPort(FdTable* fdTable, int fd) {
+	if ((unsigned)fd >= (unsigned)fdTable->length || __atomic_load_n(&(fdTable->states[fd].traced), __ATOMIC_RELAXED) != 0) {
+		return 0;
+	}
+	return __atomic_load_n(&(fdTable->states[fd].deceivedPort), __ATOMIC_ACQUIRE);
+}
+
+/**
+ * Mark the socket @fd, which isn't a traced connection, as bound to the deceived port @deceivedPort (0 if its port isn't deceived), so
+ * the connections accepted on it are traced.
+ */
+void listenFdState(FdTable* fdTable, int fd, uint8_t deceivedPort);
+
+/**
+ * Start tracing the connection @fd of type @socketType, accepted on a listening socket of the deceived port @deceivedPort. Resets all
+ * other states of @fd.
+ * @return the SocketInfo of a previous connection on @fd that was closed without the overwritten close() (e.g. by dup2()), NULL
+ * otherwise. The caller has to release it to the SocketInfoPool.
+ */
+SocketInfo* traceFdState(FdTable* fdTable, int fd, int socketType, uint8_t deceivedPort);
+
+/**
+ * Stop tracing @fd (a connection or a listening socket) and reset its state. Has to be called before the fd is released with the original
+ * close().
+ * @return the SocketInfo of @fd or NULL, the caller has to release it to the SocketInfoPool.
+ */
+SocketInfo* resetFdState(FdTable* fdTable, int fd);
@@ -24,13 +24,28 @@
 #include "GlobalVariables.h"
 
 Globals globals = {
-		{}, // sharedLibraryMethods: will be initialize within __libc_start_main
+		{NULL, // sharedLibraryMethods: resolved by the constructor of the shared object or the first call of an overwritten method
+		 unresolvedBind,
+		 unresolvedAccept,
+		 unresolvedAccept4,
+		 unresolvedGetsockname,
+		 unresolvedRecv,
+		 unresolvedSend,
+		 unresolvedRead,
+		 unresolvedWrite,
+		 unresolvedReadv,
+		 unresolvedRecvmsg,
+		 unresolvedRecvfrom,
+		 unresolvedWritev,
+		 unresolvedSendmsg,
+		 unresolvedSendto,
+		 unresolvedSendfile,
+		 unresolvedClose},
 		{}, // originalSharedLibraryMethods: will be initialize within __libc_start_main only if deception is active
 		{5000, 5001, 4200, 8080, 8081, 8000, 8001, 80, 9411}, // DECEIVED_PORTS[]: size have to be the same as DECEIVED_PORTS_COUNT defined
 															  // in GlobalVariables.h
-		-1,                                                   // socketFdTracing: not detected yet
-		{0},                                                  // socketTracedToPort[]: default value for not traced - 0
-		{((void*)0)},                                         // socketInfos[]: default value for no additional info - NULL pointer
+		{((void*)0), 0},                                      // fdTable: will be initialized within __libc_start_main
+		SOCKET_INFO_POOL_INITIALIZER,                         // socketInfoPool: slabs are allocated with the first HTTP request
 		{"HTTP/1.0",
 		 "HTTP/1.1"}, // SUPPORTED_HTTP_VERSIONS[]: size have to be the same as SUPPORTED_HTTP_VERSIONS_COUNT defined in GlobalVariables.h
 		{"python",
@@ -38,4 +53,6 @@ Globals globals = {
 		 "java"}, // SUPPORTED_EXECUTION_TOOL[]: size have to be the same as SUPPORTED_EXECUTION_TOOL_COUNT defined in GlobalVariables.h
 		NULL,      // honeyBook: initialized in main hook
 		LoggerPriority__INFO, // loggerPriority
+		NULL,                 // logRing: will be initialized within __libc_start_main
+		SUPPORTED_TECHNOLOGY_NOT_FOUND, // supportedTechnology: will be set when the first shared library method is resolved
 };
@@ -21,10 +21,12 @@
 
 #pragma once
 
+#include "FdTable.h"
 #include "HoneywireBook.h"
+#include "LogRing.h"
 #include "LoggerPriority.h"
 #include "SharedLibraryMethods.h"
-#include "SocketInfo.h"
+#include "SocketInfoPool.h"
 #include "SupportedTechnology.h"
 
 #include <pthread.h>
@@ -42,15 +44,28 @@
 #define HONEYAML_FILE "/var/opt/honeyaml.yaml"
 
 /**
- * For compilation of global state, the size of the DECEIVED_PORTS array have to be known.
+ * ModelImage of the HONEYAML_FILE compiled by the honeyaml-compiler (see src/Makefile). It's mapped instead of parsing the HONEYAML_FILE
+ * if it was compiled from its current content, or on its own if there is no HONEYAML_FILE. Has to be in the folder of the HONEYAML_FILE,
+ * since only this folder is watched for changes.
  */
-#define DECEIVED_PORTS_COUNT 9
+#define HONEYAML_IMAGE_FILE "/var/opt/honeyaml.img"
+
+/**
+ * The model compiled from the HONEYAML_FILE is published to SHARED_MODEL_FILE (a tmpfs, so its pages are shared in memory) and mapped by
+ * all processes of the node, so only the first process compiles a changed HONEYAML_FILE (see SharedModel.h). Processes compile their own
+ * model if the folder doesn't exist or isn't writable.
+ */
+#define SHARED_MODEL_FILE "/dev/shm/deception-model"
 
 /**
- * Limit of socketFd value that will be traced at most. Currently limits memory allocation and will be unnecessary (or at least be
- * renamed) with a hashmap implementation instead of an array TODO: TR-70
+ * Lock file that serializes the compilation of the SHARED_MODEL_FILE by the processes of the node (see lockSharedModel()).
  */
-#define SOCKET_FD_LIMIT 1000
+#define SHARED_MODEL_LOCK_FILE SHARED_MODEL_FILE ".lock"
+
+/**
+ * For compilation of global state, the size of the DECEIVED_PORTS array have to be known.
+ */
+#define DECEIVED_PORTS_COUNT 9
 
 /**
  * For compilation of individual components, the size of the SUPPORTED_HTTP_VERSIONS array have to be known.
@@ -60,7 +75,7 @@
 /**
  * For compilation of individual components, the size of the SUPPORTED_EXECUTION_TOOL array have to be known.
  */
-#define SUPPORTED_EXECUTION_TOOL_COUNT 4
+#define SUPPORTED_EXECUTION_TOOL_COUNT 3
 
 /**
  * Structure Globals define all global variable that are available within the Agent.
@@ -77,36 +92,24 @@ typedef struct {
 	SharedLibraryMethods originalSharedLibraryMethods;
 
 	/**
-	 * Ports where the deception will be active.
+	 * Ports where the deception will be active: the connections accepted on every listening socket bound to one of them are traced. The
+	 * fdTable references the entry of the port of listening sockets and their connections (see FdState.deceivedPort).
 	 */
 	const unsigned short DECEIVED_PORTS[DECEIVED_PORTS_COUNT];
 
 	/**
-	 * SocketFd that is allocated for creating new connection(new socketFd) with accept4() based on a the ports specified in tracingPorts.
-	 * For example the SocketFd for python is identified by the getsockname() method defined in ./SharedLibraries.c.
-	 * Default value = -1 = socketFd is not set
-	 */
-	int socketFdTracing;
-
-	/**
-	 * Boolean Hashmap of socketFd that indicates if a socketFd should be further traced. 0 means ignore, 1 means further investigate.
-	 *
-	 * Note1: For easier management short is used instead of boolean/bit. This is enough for now but will be changed in the
-	 * future for better performance. TODO RT-3624
+	 * State of every fd of the process (e.g. if a socketFd should be further traced and the state of its current request), indexed
+	 * by the fd. The states live in their own mmap'ed region, so they don't share cache lines with the other globals.
 	 *
-	 * Note2: Array is used instead Hashmap since new file descriptor will always be allocated at the least possible index.
-	 * Therefore a array is enough for this PoC. To limit storage allocation the SOCKET_FD_LIMIT is used. TODO RT-3624
+	 * Note: An array is used instead of a Hashmap since new file descriptor will always be allocated at the least possible index.
+	 * Initialized by startDeception() on the first bind of a deceived port, empty (length 0) before.
 	 */
-	unsigned short socketTracedToPort[SOCKET_FD_LIMIT];
+	FdTable fdTable;
 
 	/**
-	 * SocketInfos saves additional information to a traced socketFd (i.e. socketTracedToPort[socketFd]==1) if needed.
-	 * This would be needed for example for more complex deception processed or "playbooks".
-	 *
-	 * Note: Array is used instead Hashmap since new file descriptor will always be allocated at the least possible index.
-	 * Therefore a array is enough for this PoC. To limit storage allocation the SOCKET_FD_LIMIT is used. TODO RT-3624
+	 * Allocator of the per-connection SocketInfos referenced by the fdTable states.
 	 */
-	SocketInfo* socketInfos[SOCKET_FD_LIMIT];
+	SocketInfoPool socketInfoPool;
 
 	/**
 	 * All supported HTTP Version. Saved as string format that will be used to parse HTTP requests. E.g. "HTTP/1.0"
@@ -122,6 +125,7 @@ typedef struct {
 	/**
 	 * Contains a HoneywiresConfig with all active or deactivated Honeywires extracted from honeyaml.yaml. Also includes threadsafe
 	 * read/write operation for interacting with the honeywireConfig.
+	 * NULL until startDeception() is called on the first bind of a deceived port.
 	 */
 	HoneywiresBook* honeywiresBook;
 
@@ -129,6 +133,17 @@ typedef struct {
 	 * Defines the default level that a log have to be to get actually logged in Utils.PrintfLogger().
 	 */
 	LoggerPriority loggerPriority;
+
+	/**
+	 * Ring buffer drained by the loggerThread (see LoggerThread.c), NULL while simpleLogger() writes synchronously.
+	 */
+	LogRing* logRing;
+
+	/**
+	 * Technology of the current process derived from argv[0]. Set once before the first overwritten libc-method is bound (see
+	 * SharedLibraries.c), SUPPORTED_TECHNOLOGY_NOT_FOUND means the process runs without deception.
+	 */
+	SUPPORTED_TECHNOLOGY supportedTechnology;
 } Globals;
 
 /**
@@ -0,0 +1,61 @@
+// Copyright 2024 Dynatrace LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Portions of this code, as identified in remarks, are provided under the
+// Creative Commons BY-SA 4.0 or the MIT license, and are provided without
+// any warranty. In each of the remarks, we have provided attribution to the
+// original creators and other attribution parties, along with the title of
+// the code (if known) a copyright notice and a link to the license, and a
+// statement indicating whether or not we have modified the code.
+
+#include "HeaderAccumulator.h"
+
+#include <string.h>
+
+void initHeaderAccumulator(HeaderAccumulator* accumulator) {
+	accumulator->buffer = NULL;
+	accumulator->length = 0;
+}
+
+size_t holdHeaderBytes(HeaderAccumulator* accumulator, const void* buf, size_t length) {
+	if (accumulator->buffer == NULL) {
+		return 0;
+	}
+
+	if (accumulator->length == 0) {
+		clock_gettime(CLOCK_MONOTONIC, &(accumulator->heldSince));
+	}
+
+	size_t held = HEADER_ACCUMULATOR_MAX_LENGTH - accumulator->length;
+	if (length < held) {
+		held = length;
+	}
+
+	memcpy(accumulator->buffer + accumulator->length, buf, held);
+	accumulator->length += held;
+
+	return held;
+}
+
+bool isHeaderAccumulatorExhausted(const HeaderAccumulator* accumulator) {
+	if (accumulator->length >= HEADER_ACCUMULATOR_MAX_LENGTH) {
+		return true;
+	}
+
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	long heldMs = (now.tv_sec - accumulator->heldSince.tv_sec) * 1000 + (now.tv_nsec - accumulator->heldSince.tv_nsec) / 1000000;
+	return heldMs >= HEADER_ACCUMULATOR_TIMEOUT_MS;
+}
@@ -0,0 +1,71 @@
+// Copyright 2024 Dynatrace LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Portions of this code, as identified in remarks, are provided under the
+// Creative Commons BY-SA 4.0 or the MIT license, and are provided without
+// any warranty. In each of the remarks, we have provided attribution to the
+// original creators and other attribution parties, along with the title of
+// the code (if known) a copyright notice and a link to the license, and a
+// statement indicating whether or not we have modified the code.
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <time.h>
+
+/**
+ * Maximal number of bytes of a response header that are held back until the end of the header block is written.
+ */
+#define HEADER_ACCUMULATOR_MAX_LENGTH 8192
+
+/**
+ * Maximal time in milliseconds a response header is held back, evaluated by the next write()/send() of the connection.
+ */
+#define HEADER_ACCUMULATOR_TIMEOUT_MS 50
+
+/**
+ * Response header of a connection that is written with several write()/send() calls (e.g. status line and each header attribute on their
+ * own): the bytes are held back until the end of the header block is written, so the header can be rewritten as a whole. The bytes are
+ * already reported as written to the application.
+ */
+typedef struct {
+	/**
+	 * HEADER_ACCUMULATOR_MAX_LENGTH bytes, taken from the SocketInfoPool when the first header of the connection is held back.
+	 */
+	char* buffer;
+	size_t length;
+
+	/**
+	 * CLOCK_MONOTONIC time the first byte of the held header was written.
+	 */
+	struct timespec heldSince;
+} HeaderAccumulator;
+
+void initHeaderAccumulator(HeaderAccumulator* accumulator);
+
+/**
+ * Hold back @length bytes of @buf behind the already held bytes of @accumulator, at most up to HEADER_ACCUMULATOR_MAX_LENGTH.
+ * @return number of held bytes of @buf, 0 if @accumulator has no buffer
+ */
+size_t holdHeaderBytes(HeaderAccumulator* accumulator, const void* buf, size_t length);
+
+/**
+ * @return true if the held bytes reached HEADER_ACCUMULATOR_MAX_LENGTH or are held for HEADER_ACCUMULATOR_TIMEOUT_MS
+ */
+bool isHeaderAccumulatorExhausted(const HeaderAccumulator* accumulator);
+
+static inline bool isHoldingHeader(const HeaderAccumulator* accumulator) {
+	return accumulator->length > 0;
+}
@@ -53,6 +53,7 @@ int honeywireAttributeID(char* enumString) {
 const char* HONEYWIRE_YAML_KIND[] = {
 		"http-header",
 		"response-code",
+		"http-body",
 };
 int honeywireKindID(char* enumString) {
 	int i = 0;
@@ -68,6 +69,9 @@ int honeywireKindID(char* enumString) {
 const char* HONEYWIRE_OPERATION_YAML_TYPE[] = {
 		"replace-inplace",
 		"replace-status-code",
+		"insert-body",
+		"insert-header",
+		"delete-header",
 };
 int honeywireOperationTypeID(char* enumString) {
 	int i = 0;
@@ -77,5 +81,5 @@ int honeywireOperationTypeID(char* enumString) {
 		}
 		i++;
 	}
-	return HoneywireKind__NIL;
+	return HoneywireOperationType__NIL;
 }
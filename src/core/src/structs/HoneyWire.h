@@ -24,9 +24,9 @@
 #include <stdbool.h>
 
 #define HONEYAML_FILE_CHAR_BUFFER_LENGTH 100
-#define HONEYWIRE_CONFIG_MAX_LENGTH 5
+#define HONEYWIRE_CONFIG_MAX_LENGTH 512
 #define HONEYWIRE_OPERATIONS_MAX_LENGTH 5
-#define HONEYWIRE_OPERATION_CONDITIONS_MAX_LENGTH 5
+#define HONEYWIRE_OPERATION_CONDITIONS_MAX_LENGTH 256
 
 typedef enum {
 	HoneywireYamlParsingError__KEY_NOT_FOUND = -1,
@@ -57,6 +57,7 @@ int honeywireAttributeID(char* enumString);
 typedef enum {
 	HoneywireKind__HTTP_HEADER,
 	HoneywireKind__RESPONSE_CODE, // not implemented: just an additional option for a potential further scenario
+	HoneywireKind__HTTP_BODY,
 	HoneywireKind__NIL,           // NIL have to be the last element since it is not referenceable by HONEYWIRE_YAML_KIND
 } HoneywireKind;
 // The HONEYWIRE_YAML_KIND(i) have to be defined respectively to the enum HoneywireKind(i)
@@ -66,6 +67,9 @@ int honeywireKindID(char* enumString);
 typedef enum {
 	HoneywireOperationType__REPLACE_INPLACE,
 	HoneywireOperationType__REPLACE_STATUS_CODE, // not implemented: just an additional option for a potential further scenario
+	HoneywireOperationType__INSERT_BODY,
+	HoneywireOperationType__INSERT_HEADER,
+	HoneywireOperationType__DELETE_HEADER,
 	HoneywireOperationType__NIL,
 } HoneywireOperationType;
 
@@ -22,6 +22,7 @@
 #include "HoneyWireSharedObjectModel.h"
 
 #include <stdlib.h>
+#include <sys/mman.h>
 
 SO_HW_Model* initSharedObjectHoneywireModel() {
 	SO_HW_Model* so_model = malloc(sizeof(SO_HW_Model));
@@ -32,18 +33,20 @@ SO_HW_Model* initSharedObjectHoneywireModel() {
 
 	SO_HW_recv* recv = malloc(sizeof(SO_HW_recv));
 	recv->enabled = false;
-	recv->matchingPathString = NULL;
+	recv->matchingPaths = NULL;
+	recv->matchingPathStatusCodes = NULL;
+	recv->matchingPathsLength = 0;
+	recv->pathMatcher = NULL;
 	so_model->recvModel = recv;
 
 	SO_HW_send* send = malloc(sizeof(SO_HW_send));
 	send->enabled = false;
-	send->replaceServerStringEnabled = false;
-	send->attributeKey = NULL;
-	send->newServerString = NULL;
-	send->replaceStatusCodeEnabled = false;
-	send->newStatuscodeString = NULL;
+	send->responseProgram = NULL;
 	so_model->sendModel = send;
 
+	so_model->image = NULL;
+	so_model->imageLength = 0;
+
 	return so_model;
 }
 
@@ -55,29 +58,36 @@ void destructor_SO_HW_accept4(SO_HW_accept4* model) {
 
 void destructor_SO_HW_recv(SO_HW_recv* model) {
 	if (model != NULL) {
-
-		if (model->matchingPathString != NULL) {
-			free(model->matchingPathString);
+		for (int i = 0; i < model->matchingPathsLength; i++) {
+			free((char*)model->matchingPaths[i]);
 		}
+		free(model->matchingPaths);
+		free(model->matchingPathStatusCodes);
+		freePathMatcher(model->pathMatcher);
 		free(model);
 	}
 }
 void destructor_SO_HW_send(SO_HW_send* model) {
 	if (model != NULL) {
-		if (model->attributeKey != NULL) {
-			free(model->attributeKey);
-		}
-		if (model->newServerString != NULL) {
-			free(model->newServerString);
-		}
-		if (model->newStatuscodeString != NULL) {
-			free(model->newStatuscodeString);
-		}
+		free(model->responseProgram);
 		free(model);
 	}
 }
 
 void freeSharedObjectHoneywireMapping(SO_HW_Model* sharedObjectHoneywireModel) {
+	if (sharedObjectHoneywireModel->image != NULL) {
+		// only the structs are allocated, everything they point to is part of the image
+		free(sharedObjectHoneywireModel->accept4Model);
+		free(sharedObjectHoneywireModel->recvModel->matchingPaths);
+		free(sharedObjectHoneywireModel->recvModel->pathMatcher);
+		free(sharedObjectHoneywireModel->recvModel);
+		free(sharedObjectHoneywireModel->sendModel->responseProgram);
+		free(sharedObjectHoneywireModel->sendModel);
+		munmap((void*)sharedObjectHoneywireModel->image, sharedObjectHoneywireModel->imageLength);
+		free(sharedObjectHoneywireModel);
+		return;
+	}
+
 	destructor_SO_HW_accept4(sharedObjectHoneywireModel->accept4Model);
 	destructor_SO_HW_recv(sharedObjectHoneywireModel->recvModel);
 	destructor_SO_HW_send(sharedObjectHoneywireModel->sendModel);
@@ -21,7 +21,11 @@
 
 #pragma once
 
+#include "PathMatcher.h"
+#include "ResponseProgram.h"
+
 #include <stdbool.h>
+#include <stddef.h>
 
 typedef struct {
 	bool enabled;
@@ -30,21 +34,22 @@ void destructor_SO_HW_accept4(SO_HW_accept4* model);
 
 typedef struct {
 	bool enabled;
-	const char* matchingPathString;
+
+	// condition paths of the response-code honeywires (e.g. "/admin") and the status code their responses are deceived with
+	const char** matchingPaths;
+	unsigned short* matchingPathStatusCodes;
+	int matchingPathsLength;
+
+	// all matchingPaths compiled into a single automaton, NULL if there is no matching path
+	PathMatcher* pathMatcher;
 } SO_HW_recv;
 void destructor_SO_HW_recv(SO_HW_recv* model);
 
 typedef struct {
 	bool enabled;
 
-	// overwrite "Server:" header attribute variables
-	bool replaceServerStringEnabled;
-	const char* attributeKey;
-	const char* newServerString;
-
-	// overwrite header status-code variables
-	bool replaceStatusCodeEnabled;
-	const char* newStatuscodeString;
+	// status code and header rewrites of all honeywires, run on the first write of every response
+	ResponseProgram* responseProgram;
 } SO_HW_send;
 void destructor_SO_HW_send(SO_HW_send* model);
 
@@ -54,6 +59,10 @@ typedef struct {
 	SO_HW_send* sendModel;
 	// currently getsockname() can be linked with SO_HW_accept4 -> no struct needed yet
 	// currently close()       can be linked with SO_HW_accept4 -> no struct needed yet
+
+	// mapped ModelImage the paths, tables and strings of the models point into (see mapModelImage()), NULL if they are allocated
+	const void* image;
+	size_t imageLength;
 } SO_HW_Model;
 SO_HW_Model* initSharedObjectHoneywireModel();
 void freeSharedObjectHoneywireMapping(SO_HW_Model* sharedObjectHoneywireModel);
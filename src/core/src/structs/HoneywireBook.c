@@ -28,128 +28,214 @@
 
 void freeHoneywiresConfig(HoneywiresConfig* honeywiresConfig);
 void mapHoneywireConfigToSharedObjectModels(HoneywiresConfig* honeywiresConfig, SO_HW_Model* so_hw_model);
+void mapMatchingPaths(HoneywiresConfig* honeywiresConfig, SO_HW_recv* recvModel);
 
-void startWriteLock(HoneywiresBook* honeywiresBook);
-void endWriteLock(HoneywiresBook* honeywiresBook);
+ReaderEpoch* registerReaderEpoch(HoneywiresBook* honeywiresBook);
+void releaseReaderEpoch(void* readerEpoch);
+bool reclaimRetiredModels(HoneywiresBook* honeywiresBook, int timeout);
+
+/**
+ * ReaderEpoch of the current thread. initial-exec is possible since the shared library is always loaded at startup with LD_PRELOAD and
+ * keeps the access to a single instruction instead of a __tls_get_addr() call.
+ */
+static __thread ReaderEpoch* threadReaderEpoch __attribute__((tls_model("initial-exec"))) = NULL;
 
 HoneywiresBook* initHoneywiresBook() {
 	HoneywiresBook* honeywiresBook = malloc(sizeof(HoneywiresBook));
 
 	honeywiresBook->readConfigThread = 0;
 	honeywiresBook->honeyConfigLastUpdated = 0;
+	honeywiresBook->honeyConfigHash = 0;
 
 	HoneywiresConfig* honeywiresConfig = malloc(sizeof(HoneywiresConfig));
 	honeywiresConfig->honeywiresLength = 0;
 	honeywiresBook->honeywiresConfig = honeywiresConfig;
 
 	honeywiresBook->so_hw_model = initSharedObjectHoneywireModel();
-	pthread_mutex_init(&(honeywiresBook->readerWriterMutex), NULL);
-	honeywiresBook->writeQueuedOrInProcess = false;
+	honeywiresBook->epoch = 1;
+	honeywiresBook->readerEpochs = NULL;
+	pthread_key_create(&(honeywiresBook->readerEpochKey), releaseReaderEpoch);
+	honeywiresBook->retiredModels = NULL;
 
-	honeywiresBook->currentReader = 0;
 	honeywiresBook->honeywireConfigUpdateTimeout = 10000; // 10 seconds
+	pthread_mutex_init(&(honeywiresBook->writerMutex), NULL);
 
 	return honeywiresBook;
 }
 
 /**
- * startWriteLock() will safely set writeQueuedOrInProcess to true. This will prevent new request from accessing the HoneywireBook
- * and therefore initiating the update phase by stop further deception (during the update phase).
+ * Claim a released ReaderEpoch of an exited thread or append a new one to the lock-free list of the honeywiresBook.
  */
-void startWriteLock(HoneywiresBook* honeywiresBook) {
-	pthread_mutex_lock(&(honeywiresBook->readerWriterMutex));
-	honeywiresBook->writeQueuedOrInProcess = true;
-	pthread_mutex_unlock(&(honeywiresBook->readerWriterMutex));
-}
+ReaderEpoch* registerReaderEpoch(HoneywiresBook* honeywiresBook) {
+	ReaderEpoch* readerEpoch = __atomic_load_n(&(honeywiresBook->readerEpochs), __ATOMIC_ACQUIRE);
 
-void endWriteLock(HoneywiresBook* honeywiresBook) {
-	pthread_mutex_lock(&(honeywiresBook->readerWriterMutex));
-	honeywiresBook->writeQueuedOrInProcess = false;
-	pthread_mutex_unlock(&(honeywiresBook->readerWriterMutex));
-}
+	while (readerEpoch != NULL) {
+		bool expected = false;
+		if (__atomic_compare_exchange_n(&(readerEpoch->inUse), &expected, true, false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+			break;
+		}
+		readerEpoch = readerEpoch->next;
+	}
+
+	if (readerEpoch == NULL) {
+		if (posix_memalign((void**)&readerEpoch, sizeof(ReaderEpoch), sizeof(ReaderEpoch)) != 0) {
+			return NULL;
+		}
+		readerEpoch->epoch = 0;
+		readerEpoch->nesting = 0;
+		readerEpoch->inUse = true;
+		readerEpoch->next = __atomic_load_n(&(honeywiresBook->readerEpochs), __ATOMIC_RELAXED);
 
-bool increaseReader(HoneywiresBook* honeywiresBook) {
-	bool status = true;
-	pthread_mutex_lock(&(honeywiresBook->readerWriterMutex));
-	if (honeywiresBook->writeQueuedOrInProcess) {
-		status = false;
-	} else {
-		honeywiresBook->currentReader++;
+		while (!__atomic_compare_exchange_n(
+				&(honeywiresBook->readerEpochs), &(readerEpoch->next), readerEpoch, true, __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+		}
 	}
-	pthread_mutex_unlock(&(honeywiresBook->readerWriterMutex));
-	return status;
+
+	threadReaderEpoch = readerEpoch;
+	pthread_setspecific(honeywiresBook->readerEpochKey, readerEpoch);
+
+	return readerEpoch;
+}
+
+/**
+ * pthread_key destructor: hand the ReaderEpoch of an exiting thread over to the next new thread.
+ */
+void releaseReaderEpoch(void* readerEpoch) {
+	ReaderEpoch* entry = readerEpoch;
+
+	entry->nesting = 0;
+	__atomic_store_n(&(entry->epoch), 0, __ATOMIC_RELEASE);
+	__atomic_store_n(&(entry->inUse), false, __ATOMIC_RELEASE);
 }
 
-bool checkFlagAndIncreaseReader(HoneywiresBook* honeywiresBook, bool honeyBookFlag) {
+SO_HW_Model* readerStart(HoneywiresBook* honeywiresBook) {
 	// (honeywiresBook == NULL) if deception isn't allocated or supporting for this process
-	// checked before and after increaseReader to increase performance for processes that aren't supporting deception as well as minimize
-	// usage of currentReader variable within the honeybook
-	if (honeywiresBook == NULL || !honeyBookFlag) {
-		return false;
+	if (honeywiresBook == NULL) {
+		return NULL;
 	}
 
-	if (!increaseReader(honeywiresBook)) {
-		return false;
+	ReaderEpoch* readerEpoch = threadReaderEpoch;
+	if (readerEpoch == NULL && (readerEpoch = registerReaderEpoch(honeywiresBook)) == NULL) {
+		return NULL;
 	}
 
-	// checked again since the state could be changed before increaseReader() was called
-	if (honeywiresBook == NULL || !honeyBookFlag) {
-		readerFinished(honeywiresBook);
-		return false;
+	if (readerEpoch->nesting++ == 0) {
+		// Sequentially consistent store followed by a sequentially consistent load of so_hw_model: either the writer sees this epoch
+		// while waiting for readers, or this reader sees the snapshot the writer published before it started waiting.
+		__atomic_store_n(&(readerEpoch->epoch), __atomic_load_n(&(honeywiresBook->epoch), __ATOMIC_RELAXED), __ATOMIC_SEQ_CST);
 	}
 
-	return true;
+	return __atomic_load_n(&(honeywiresBook->so_hw_model), __ATOMIC_SEQ_CST);
 }
 
 void readerFinished(HoneywiresBook* honeywiresBook) {
-	pthread_mutex_lock(&(honeywiresBook->readerWriterMutex));
-	honeywiresBook->currentReader--;
-	pthread_mutex_unlock(&(honeywiresBook->readerWriterMutex));
+	ReaderEpoch* readerEpoch = threadReaderEpoch;
+
+	if (honeywiresBook == NULL || readerEpoch == NULL) {
+		return;
+	}
+
+	if (--readerEpoch->nesting == 0) {
+		__atomic_store_n(&(readerEpoch->epoch), 0, __ATOMIC_RELEASE);
+	}
 }
 
-bool updateHoneyConfig(HoneywiresBook* honeywiresBook, HoneywiresConfig* newConfig, time_t configLastUpdated) {
-	// will be freed after lock & update of the honeywiresBook
+SO_HW_Model* compileHoneyModel(HoneywiresConfig* honeywiresConfig) {
+	// allocate and map soModel before publishing it, readers will never see a partially mapped model
+	SO_HW_Model* so_hw_model = initSharedObjectHoneywireModel();
+	mapHoneywireConfigToSharedObjectModels(honeywiresConfig, so_hw_model);
+
+	return so_hw_model;
+}
+
+bool updateHoneyConfig(HoneywiresBook* honeywiresBook, HoneywiresConfig* newConfig, SO_HW_Model* so_hw_model, time_t configLastUpdated) {
+	pthread_mutex_lock(&(honeywiresBook->writerMutex));
+
+	// publish the new snapshot, readers entering from now on will use it
+	SO_HW_Model* oldSoModel = __atomic_exchange_n(&(honeywiresBook->so_hw_model), so_hw_model, __ATOMIC_SEQ_CST);
+	unsigned long retireEpoch = __atomic_add_fetch(&(honeywiresBook->epoch), 1, __ATOMIC_SEQ_CST);
+
 	HoneywiresConfig* oldConfigToFree = honeywiresBook->honeywiresConfig;
-	SO_HW_Model* oldSoModelToFree = honeywiresBook->so_hw_model;
+	honeywiresBook->honeywiresConfig = newConfig;
+	honeywiresBook->honeyConfigLastUpdated = configLastUpdated;
+	freeHoneywiresConfig(oldConfigToFree);
 
-	// allocate and map soModel before locking and updating global state
-	SO_HW_Model* so_hw_model = initSharedObjectHoneywireModel();
-	mapHoneywireConfigToSharedObjectModels(newConfig, so_hw_model);
-
-	startWriteLock(honeywiresBook);
-	// Wait until all open connection (reader) stop accessing the resource. If currentReader==0 before timeout, proceed
-	// with updating the honeywiresBook;
-	{
-		const int TIME_OUT = 10; // milliseconds
-		int tryWrite = honeywiresBook->honeywireConfigUpdateTimeout / TIME_OUT;
-
-		// Try for 10 seconds (TIME_OUT * tryWrite) if no open connection (reader) is left. Skip update if time run out.
-		while (honeywiresBook->currentReader > 0) {
-			if (tryWrite-- <= 0) {
-				honeywiresBook->honeyConfigLastUpdated = configLastUpdated;
-				endWriteLock(honeywiresBook);
-				freeHoneywiresConfig(oldConfigToFree);
-				freeSharedObjectHoneywireMapping(oldSoModelToFree);
-				return false;
-			}
+	RetiredModel* retiredModel = malloc(sizeof(RetiredModel));
+	retiredModel->so_hw_model = oldSoModel;
+	retiredModel->retireEpoch = retireEpoch;
+	retiredModel->next = honeywiresBook->retiredModels;
+	honeywiresBook->retiredModels = retiredModel;
+
+	pthread_mutex_unlock(&(honeywiresBook->writerMutex));
+
+	return reclaimRetiredModels(honeywiresBook, honeywiresBook->honeywireConfigUpdateTimeout);
+}
 
-			sleep(TIME_OUT);
+/**
+ * Wait a maximum of @timeout milliseconds until no reader is inside an epoch older than the retireEpoch of the retired snapshots and
+ * free them.
+ * @return true if all retired snapshots were freed
+ */
+bool reclaimRetiredModels(HoneywiresBook* honeywiresBook, int timeout) {
+	const int TIME_OUT = 10; // milliseconds
+	int tryReclaim = timeout / TIME_OUT;
+
+	RetiredModel** retiredModelPosition = &(honeywiresBook->retiredModels);
+
+	pthread_mutex_lock(&(honeywiresBook->writerMutex));
+	while (*retiredModelPosition != NULL) {
+		RetiredModel* retiredModel = *retiredModelPosition;
+		bool readerActive = false;
+
+		ReaderEpoch* readerEpoch = __atomic_load_n(&(honeywiresBook->readerEpochs), __ATOMIC_ACQUIRE);
+		for (; readerEpoch != NULL && !readerActive; readerEpoch = readerEpoch->next) {
+			unsigned long epoch = __atomic_load_n(&(readerEpoch->epoch), __ATOMIC_SEQ_CST);
+			readerActive = epoch != 0 && epoch < retiredModel->retireEpoch;
 		}
 
-		// update honeywiresBook
-		honeywiresBook->honeywiresConfig = newConfig;
-		honeywiresBook->honeyConfigLastUpdated = configLastUpdated;
-		honeywiresBook->so_hw_model = so_hw_model;
+		if (!readerActive) {
+			*retiredModelPosition = retiredModel->next;
+			freeSharedObjectHoneywireMapping(retiredModel->so_hw_model);
+			free(retiredModel);
+		} else if (tryReclaim-- > 0) {
+			// a fork() doesn't wait for the readers
+			pthread_mutex_unlock(&(honeywiresBook->writerMutex));
+			usleep(TIME_OUT * 1000);
+			pthread_mutex_lock(&(honeywiresBook->writerMutex));
+		} else {
+			// keep it for the next update, a reader is still using it
+			retiredModelPosition = &(retiredModel->next);
+		}
 	}
-	endWriteLock(honeywiresBook);
+	bool reclaimed = honeywiresBook->retiredModels == NULL;
+	pthread_mutex_unlock(&(honeywiresBook->writerMutex));
 
-	freeHoneywiresConfig(oldConfigToFree);
-	freeSharedObjectHoneywireMapping(oldSoModelToFree);
+	return reclaimed;
+}
 
-	return true;
+void prepareHoneywiresBookFork(HoneywiresBook* honeywiresBook) {
+	pthread_mutex_lock(&(honeywiresBook->writerMutex));
+}
+
+void parentHoneywiresBookFork(HoneywiresBook* honeywiresBook) {
+	pthread_mutex_unlock(&(honeywiresBook->writerMutex));
+}
+
+void childHoneywiresBookFork(HoneywiresBook* honeywiresBook) {
+	pthread_mutex_unlock(&(honeywiresBook->writerMutex));
+
+	for (ReaderEpoch* readerEpoch = honeywiresBook->readerEpochs; readerEpoch != NULL; readerEpoch = readerEpoch->next) {
+		if (readerEpoch != threadReaderEpoch && readerEpoch->inUse) {
+			releaseReaderEpoch(readerEpoch);
+		}
+	}
 }
 
 void freeHoneywiresConfig(HoneywiresConfig* honeywiresConfig) {
+	if (honeywiresConfig == NULL) {
+		return;
+	}
+
 	for (int i = 0; i < honeywiresConfig->honeywiresLength; i++) {
 		int opLength = honeywiresConfig->honeywires[i]->operationsLength;
 
@@ -163,6 +249,9 @@ void freeHoneywiresConfig(HoneywiresConfig* honeywiresConfig) {
 					// no variable to free
 					break;
 				case HoneywireOperationType__REPLACE_INPLACE:
+				case HoneywireOperationType__INSERT_BODY:
+				case HoneywireOperationType__INSERT_HEADER:
+				case HoneywireOperationType__DELETE_HEADER:
 					free(honeywiresConfig->honeywires[i]->operations[j]->key);
 					free(honeywiresConfig->honeywires[i]->operations[j]->value);
 					break;
@@ -209,25 +298,89 @@ void mapHoneywireConfigToSharedObjectModels(HoneywiresConfig* honeywiresConfig,
 			if (wire->enabled) {
 				so_hw_model->accept4Model->enabled = true;
 				so_hw_model->sendModel->enabled = true;
-
-				so_hw_model->sendModel->replaceServerStringEnabled = true;
-				so_hw_model->sendModel->attributeKey = strdup((char*)wire->operations[0]->key);
-				so_hw_model->sendModel->newServerString = strdup((char*)wire->operations[0]->value);
 			}
 			break;
 		case HoneywireKind__RESPONSE_CODE:
 			if (wire->enabled) {
 				so_hw_model->accept4Model->enabled = true;
 				so_hw_model->recvModel->enabled = true;
-				so_hw_model->recvModel->matchingPathString = strdup((char*)wire->operations[0]->condition[0]->path);
-
 				so_hw_model->sendModel->enabled = true;
-				so_hw_model->sendModel->replaceStatusCodeEnabled = true;
-				so_hw_model->sendModel->newStatuscodeString = strdup((char*)wire->operations[0]->value);
+			}
+			break;
+		case HoneywireKind__HTTP_BODY:
+			if (wire->enabled) {
+				so_hw_model->accept4Model->enabled = true;
+				so_hw_model->sendModel->enabled = true;
 			}
 			break;
 		case HoneywireKind__NIL:
 			break;
 		}
 	}
+
+	mapMatchingPaths(honeywiresConfig, so_hw_model->recvModel);
+	so_hw_model->sendModel->responseProgram = compileResponseProgram(wires, wiresLength);
+
+	// without a program the responses can't be rewritten
+	if (so_hw_model->sendModel->responseProgram == NULL) {
+		so_hw_model->sendModel->enabled = false;
+	}
+}
+
+/**
+ * Collect the condition paths of all enabled response-code honeywires with the status code of their replace-status-code operation and compile them into the
+ * pathMatcher of @recvModel. Paths whose status code isn't a number of three digits are skipped.
+ */
+void mapMatchingPaths(HoneywiresConfig* honeywiresConfig, SO_HW_recv* recvModel) {
+	int maxPathsLength = 0;
+
+	for (int i = 0; i < honeywiresConfig->honeywiresLength; i++) {
+		Honeywire* wire = honeywiresConfig->honeywires[i];
+
+		if (wire->enabled && wire->kind == HoneywireKind__RESPONSE_CODE) {
+			for (int j = 0; j < wire->operationsLength; j++) {
+				if (wire->operations[j]->type == HoneywireOperationType__REPLACE_STATUS_CODE) {
+					maxPathsLength += wire->operations[j]->conditionsLength;
+				}
+			}
+		}
+	}
+
+	if (maxPathsLength == 0) {
+		return;
+	}
+
+	recvModel->matchingPaths = malloc(sizeof(char*) * maxPathsLength);
+	recvModel->matchingPathStatusCodes = malloc(sizeof(unsigned short) * maxPathsLength);
+
+	for (int i = 0; i < honeywiresConfig->honeywiresLength; i++) {
+		Honeywire* wire = honeywiresConfig->honeywires[i];
+
+		if (!wire->enabled || wire->kind != HoneywireKind__RESPONSE_CODE) {
+			continue;
+		}
+
+		for (int j = 0; j < wire->operationsLength; j++) {
+			HoneywireOperation* operation = wire->operations[j];
+			char* statusCodeEnd = NULL;
+			unsigned long statusCode = operation->value != NULL ? strtoul(operation->value, &statusCodeEnd, 10) : 0;
+
+			if (operation->type != HoneywireOperationType__REPLACE_STATUS_CODE || statusCode < 100 || statusCode > 999 ||
+				*statusCodeEnd != '\0') {
+				continue;
+			}
+
+			for (int k = 0; k < operation->conditionsLength; k++) {
+				const char* path = operation->condition[k]->path;
+
+				if (path != NULL && path[0] != '\0') {
+					recvModel->matchingPaths[recvModel->matchingPathsLength] = strdup(path);
+					recvModel->matchingPathStatusCodes[recvModel->matchingPathsLength] = statusCode;
+					recvModel->matchingPathsLength++;
+				}
+			}
+		}
+	}
+
+	recvModel->pathMatcher = compilePathMatcher(recvModel->matchingPaths, recvModel->matchingPathsLength);
 }
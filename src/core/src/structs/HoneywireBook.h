@@ -33,6 +33,41 @@ typedef struct {
 
 } HoneywiresConfig;
 
+/**
+ * Per-thread registration for the epoch based reclamation of published SO_HW_Model snapshots. A reader publishes the global epoch it
+ * observed when entering a read-side critical section (readerStart()) and resets it to 0 (quiescent) when leaving (readerFinished()).
+ * The writer only frees a retired snapshot once no registered reader is still inside an epoch older than the retirement.
+ *
+ * Aligned to a cache line so that readers of different threads never write to the same line.
+ */
+typedef struct ReaderEpoch {
+	/**
+	 * Epoch observed on entering the outermost read-side critical section, 0 if the thread is currently not reading.
+	 */
+	unsigned long epoch;
+
+	/**
+	 * Nesting depth of readerStart() calls, e.g., accept_default() forwarding to accept4_default(). Only accessed by the owning thread.
+	 */
+	int nesting;
+
+	/**
+	 * Set while a thread owns this entry. Entries of exited threads are released and reused by new threads.
+	 */
+	bool inUse;
+
+	struct ReaderEpoch* next;
+} __attribute__((aligned(64))) ReaderEpoch;
+
+/**
+ * A snapshot that was replaced by updateHoneyConfig() but might still be used by readers that entered before retireEpoch.
+ */
+typedef struct RetiredModel {
+	SO_HW_Model* so_hw_model;
+	unsigned long retireEpoch;
+	struct RetiredModel* next;
+} RetiredModel;
+
 typedef struct {
 	/**
 	 * Holds the thread for periodically read and set the global Honeywires based on the HoneYaml.yaml file
@@ -45,7 +80,14 @@ typedef struct {
 	int honeyConfigLastUpdated;
 
 	/**
-	 * Struct that contains the current state of a honeyaml.yaml file.
+	 * Content hash of the HoneYaml.yaml the current honeywiresConfig was parsed from, 0 if none was parsed yet. Only accessed by the
+	 * honeBookThread, so an unchanged file (e.g. only touched or re-linked) is never parsed again.
+	 */
+	unsigned long honeyConfigHash;
+
+	/**
+	 * Struct that contains the current state of a honeyaml.yaml file, NULL if so_hw_model was mapped from a ModelImage. Only accessed by
+	 * the thread calling updateHoneyConfig(), readers use so_hw_model exclusively.
 	 */
 	HoneywiresConfig* honeywiresConfig;
 
@@ -53,7 +95,8 @@ typedef struct {
 	 * A model based on honeywiresConfig containing specifically designed parameter that are needed for quick access and easier handling
 	 * for each overwritten libc-method (located in SharedLibraries.c). The intend of this model is, that each libc-method don't have
 	 * to iterate over the hole honeywiresConfig each time it gets called to be able to act accordingly.
-	 * Model will be initalized and set with initHoneywiresBook() and afterwards should be read-only.
+	 * The model is an immutable snapshot: it is published with an atomic pointer swap by updateHoneyConfig() and must only be accessed
+	 * through the pointer returned by readerStart().
 	 *
 	 * Example:
 	 * Assume a honeywire tells us to intercept calls to /admin. We say this is a "HoneywiresConfig".
@@ -66,52 +109,81 @@ typedef struct {
 	SO_HW_Model* so_hw_model;
 
 	/**
-	 * Needs to be allocated to be able to get currentReader. This enables a read lock during updating of honeywiresConfig by blocking
-	 * readWriteMutex. See usage in getHoneyConfigAndIncreaseReader().
+	 * Global epoch, increased by every publication of a new so_hw_model. Starts at 1 since 0 marks a quiescent ReaderEpoch.
 	 */
-	pthread_mutex_t readerWriterMutex;
+	unsigned long epoch;
 
 	/**
-	 * When an update occurs, the thread detecting it will set this variable to true with the TODO function and wait until the currentReader
-	 * count is set to 0. Then it will update the HoneywireBook and set writeQueuedOrInProcess back to false.  If set to true this includes,
-	 * that no more reader are able to read the current so_hw_model and therefore will skip deception.
+	 * Lock-free list of all ReaderEpoch entries. Entries are never freed, only released and reused.
 	 */
-	bool writeQueuedOrInProcess;
+	ReaderEpoch* readerEpochs;
 
 	/**
-	 * Counting current reader of honeyConfig and should be only increased/decreased with getHoneyConfigAndIncreaseReader() and
-	 * readerFinished()
+	 * Releases the ReaderEpoch of a thread when it exits.
 	 */
-	int currentReader;
+	pthread_key_t readerEpochKey;
+
+	/**
+	 * Snapshots that are replaced but couldn't be freed yet, since a reader was still active when honeywireConfigUpdateTimeout ran
+	 * out. Only accessed by the thread calling updateHoneyConfig().
+	 */
+	RetiredModel* retiredModels;
 
 	// in milliseconds
 	int honeywireConfigUpdateTimeout;
+
+	/**
+	 * Held by updateHoneyConfig() while it changes the honeywiresBook (but not while it waits for readers), so a fork() never copies a
+	 * half updated honeywiresBook into the child (see prepareHoneywiresBookFork()).
+	 */
+	pthread_mutex_t writerMutex;
 } HoneywiresBook;
 
 /**
- * Allocate memory and initialize a Honeywire Book with its process based mutex and initialize its HoneywiresConfig
+ * Allocate memory and initialize a Honeywire Book with an empty (i.e. everything disabled) so_hw_model snapshot and initialize its
+ * HoneywiresConfig
  */
 HoneywiresBook* initHoneywiresBook();
 
 /**
- * Threadsafe increase of currentReader count. Will fail and return false if writeQueuedOrInProcess is set to true.
- * writeQueuedOrInProcess=true implying that no deception is currently possible due to an update in the state.
- * @return True when increaseReader was successful. Therefore readerFinished() needs to be called manually after honeywiresBook resource
- * isn't used anymore.
+ * Lock-free entry of a read-side critical section. Never blocks, also not while updateHoneyConfig() is publishing a new snapshot.
+ * @return The currently published so_hw_model which stays valid until readerFinished() is called, or NULL if the honeywiresBook isn't
+ * allocated for this process. readerFinished() needs to be called manually if (and only if) the return value isn't NULL.
  */
-bool increaseReader(HoneywiresBook* honeywiresBook);
-bool checkFlagAndIncreaseReader(HoneywiresBook* honeywiresBook, bool honeyBookFlag);
+SO_HW_Model* readerStart(HoneywiresBook* honeywiresBook);
 
 /**
- * Decrease the currentReader count (and with that free a single readlock after getHoneyConfigAndIncreaseReader()).
+ * Leave the read-side critical section entered with readerStart(). The returned so_hw_model must not be used afterwards.
  */
 void readerFinished(HoneywiresBook* honeywiresBook);
 
 /**
- * Threadsafe update of honeywiresConfig - blocking
- * Wait a maximum of honeywireConfigUpdateTimeout until no deception uses the honeywiresConfig anymore (currentReader == 0) and then set
- * new and free old honeywiresConfig. If timeout exceed, no update will be made (i.e. skip update) and honeyConfigLastUpdated will be
- * updated to prevent update-loop.
- * @return true if update was successful
+ * Map @honeywiresConfig to a new so_hw_model that can be published with updateHoneyConfig().
+ */
+SO_HW_Model* compileHoneyModel(HoneywiresConfig* honeywiresConfig);
+
+/**
+ * Threadsafe update of honeywiresConfig - blocking for the writer only
+ * Publish @newModel (compiled from @newConfig, which is NULL if the model was mapped from a ModelImage) with an atomic pointer swap,
+ * readers will pick it up with their next readerStart(). Afterwards wait a maximum of honeywireConfigUpdateTimeout until no reader uses a replaced snapshot anymore and free it.
+ * If the timeout exceeds, the replaced snapshot is kept and freed with one of the next updates.
+ * @return true if all replaced snapshots could be freed
+ */
+bool updateHoneyConfig(HoneywiresBook* honeywiresBook, HoneywiresConfig* newConfig, SO_HW_Model* newModel, time_t configLastUpdated);
+
+/**
+ * pthread_atfork() prepare handler: wait until an update of the honeywiresBook in progress is published, so the child inherits a
+ * consistent honeywiresBook whose parsed config and so_hw_model it shares copy-on-write with the parent.
+ */
+void prepareHoneywiresBookFork(HoneywiresBook* honeywiresBook);
+
+/**
+ * pthread_atfork() parent handler, counterpart of prepareHoneywiresBookFork().
+ */
+void parentHoneywiresBookFork(HoneywiresBook* honeywiresBook);
+
+/**
+ * pthread_atfork() child handler: only the forking thread exists in the child, so the ReaderEpochs of all other threads are released
+ * (their readers would otherwise keep every retired snapshot of the child alive).
  */
-bool updateHoneyConfig(HoneywiresBook* honeywiresBook, HoneywiresConfig* newConfig, time_t configLastUpdated);
+void childHoneywiresBookFork(HoneywiresBook* honeywiresBook);
@@ -0,0 +1,172 @@
+// Copyright 2024 Dynatrace LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Portions of this code, as identified in remarks, are provided under the
+// Creative Commons BY-SA 4.0 or the MIT license, and are provided without
+// any warranty. In each of the remarks, we have provided attribution to the
+// original creators and other attribution parties, along with the title of
+// the code (if known) a copyright notice and a link to the license, and a
+// statement indicating whether or not we have modified the code.
+
+#include "HttpRequestParser.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#define CONTENT_LENGTH_HEADER "content-length:"
+#define TRANSFER_ENCODING_HEADER "transfer-encoding:"
+
+void initHttpRequestParser(HttpRequestParser* parser) {
+	parser->state = HttpRequestParserState__REQUEST_LINE;
+	parser->line[0] = '\0';
+	parser->lineLength = 0;
+	parser->lineTruncated = false;
+	parser->contentLength = 0;
+	parser->chunked = false;
+	parser->remaining = 0;
+}
+
+/**
+ * Append the bytes up to (excluding) the next '\n' to the current line.
+ * @return number of consumed bytes including the '\n', or @length if the line isn't complete yet
+ */
+static size_t appendLine(HttpRequestParser* parser, const char* buf, size_t length, bool* lineComplete) {
+	const char* lineEnd = memchr(buf, '\n', length);
+	size_t lineBytes = lineEnd != NULL ? (size_t)(lineEnd - buf) : length;
+	size_t freeBytes = HTTP_REQUEST_LINE_MAX_LENGTH - parser->lineLength;
+
+	if (lineBytes > freeBytes) {
+		parser->lineTruncated = true;
+	}
+	size_t copyBytes = lineBytes < freeBytes ? lineBytes : freeBytes;
+	memcpy(parser->line + parser->lineLength, buf, copyBytes);
+	parser->lineLength += copyBytes;
+
+	*lineComplete = lineEnd != NULL;
+	if (!*lineComplete) {
+		return length;
+	}
+
+	// strip the '\r' of a "\r\n" line ending
+	if (!parser->lineTruncated && parser->lineLength > 0 && parser->line[parser->lineLength - 1] == '\r') {
+		parser->lineLength--;
+	}
+	parser->line[parser->lineLength] = '\0';
+
+	return lineBytes + 1;
+}
+
+static void startNextRequest(HttpRequestParser* parser) {
+	parser->state = HttpRequestParserState__REQUEST_LINE;
+	parser->contentLength = 0;
+	parser->chunked = false;
+}
+
+/**
+ * Case-insensitive search of the "chunked" transfer coding in the '\0' terminated header @value.
+ */
+static bool containsChunkedCoding(const char* value) {
+	for (; *value != '\0'; value++) {
+		if (strncasecmp(value, "chunked", strlen("chunked")) == 0) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static void processHeaderLine(HttpRequestParser* parser) {
+	// empty line: end of the header
+	if (parser->lineLength == 0) {
+		if (parser->chunked) {
+			parser->state = HttpRequestParserState__CHUNK_SIZE_LINE;
+		} else if (parser->contentLength > 0) {
+			parser->state = HttpRequestParserState__BODY;
+			parser->remaining = parser->contentLength;
+		} else {
+			startNextRequest(parser);
+		}
+		return;
+	}
+
+	if (strncasecmp(parser->line, CONTENT_LENGTH_HEADER, strlen(CONTENT_LENGTH_HEADER)) == 0) {
+		parser->contentLength = strtoul(parser->line + strlen(CONTENT_LENGTH_HEADER), NULL, 10);
+	} else if (strncasecmp(parser->line, TRANSFER_ENCODING_HEADER, strlen(TRANSFER_ENCODING_HEADER)) == 0) {
+		parser->chunked = containsChunkedCoding(parser->line + strlen(TRANSFER_ENCODING_HEADER));
+	}
+}
+
+static void processLine(HttpRequestParser* parser, HttpRequestLineHandler handler, void* context) {
+	switch (parser->state) {
+	case HttpRequestParserState__REQUEST_LINE:
+		// empty lines in front of a request line are allowed (RFC 9112 section 2.2)
+		if (parser->lineLength == 0 && !parser->lineTruncated) {
+			break;
+		}
+		parser->state = handler(parser->line, parser->lineLength, parser->lineTruncated, context) ? HttpRequestParserState__HEADER_LINE
+																									: HttpRequestParserState__IGNORE;
+		break;
+	case HttpRequestParserState__HEADER_LINE:
+		processHeaderLine(parser);
+		break;
+	case HttpRequestParserState__CHUNK_SIZE_LINE:
+		parser->remaining = strtoul(parser->line, NULL, 16);
+		parser->state = parser->remaining > 0 ? HttpRequestParserState__CHUNK_DATA : HttpRequestParserState__TRAILER_LINE;
+		break;
+	case HttpRequestParserState__CHUNK_DATA_END_LINE:
+		parser->state = HttpRequestParserState__CHUNK_SIZE_LINE;
+		break;
+	case HttpRequestParserState__TRAILER_LINE:
+		if (parser->lineLength == 0) {
+			startNextRequest(parser);
+		}
+		break;
+	default:
+		break;
+	}
+
+	parser->lineLength = 0;
+	parser->lineTruncated = false;
+}
+
+void parseHttpRequests(HttpRequestParser* parser, const char* buf, size_t length, HttpRequestLineHandler handler, void* context) {
+	size_t position = 0;
+
+	while (position < length && parser->state != HttpRequestParserState__IGNORE) {
+		size_t available = length - position;
+
+		if (parser->state == HttpRequestParserState__BODY || parser->state == HttpRequestParserState__CHUNK_DATA) {
+			size_t skip = parser->remaining < available ? parser->remaining : available;
+			parser->remaining -= skip;
+			position += skip;
+
+			if (parser->remaining == 0) {
+				if (parser->state == HttpRequestParserState__BODY) {
+					startNextRequest(parser);
+				} else {
+					parser->state = HttpRequestParserState__CHUNK_DATA_END_LINE;
+				}
+			}
+			continue;
+		}
+
+		bool lineComplete;
+		position += appendLine(parser, buf + position, available, &lineComplete);
+
+		if (lineComplete) {
+			processLine(parser, handler, context);
+		}
+	}
+}
@@ -0,0 +1,85 @@
+// Copyright 2024 Dynatrace LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Portions of this code, as identified in remarks, are provided under the
+// Creative Commons BY-SA 4.0 or the MIT license, and are provided without
+// any warranty. In each of the remarks, we have provided attribution to the
+// original creators and other attribution parties, along with the title of
+// the code (if known) a copyright notice and a link to the license, and a
+// statement indicating whether or not we have modified the code.
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * Number of bytes of a request line (and of the beginning of a header line) kept by the HttpRequestParser. Longer request lines are
+ * still tracked as a request, but handed to the HttpRequestLineHandler as truncated.
+ */
+#define HTTP_REQUEST_LINE_MAX_LENGTH 256
+
+typedef enum {
+	HttpRequestParserState__REQUEST_LINE,
+	HttpRequestParserState__HEADER_LINE,
+	HttpRequestParserState__BODY,
+	HttpRequestParserState__CHUNK_SIZE_LINE,
+	HttpRequestParserState__CHUNK_DATA,
+	HttpRequestParserState__CHUNK_DATA_END_LINE,
+	HttpRequestParserState__TRAILER_LINE,
+	// the connection doesn't carry supported HTTP requests, all further bytes are ignored
+	HttpRequestParserState__IGNORE,
+} HttpRequestParserState;
+
+/**
+ * Resumable parser of the HTTP/1.x requests received on a connection. Bytes are fed in the order they are received, in chunks of any
+ * size, so request lines split across several reads and several pipelined requests within one read are both handled. Each byte is
+ * looked at once (bodies are skipped as a whole), and each request line is handed to the HttpRequestLineHandler exactly once.
+ */
+typedef struct {
+	HttpRequestParserState state;
+
+	/**
+	 * Bytes of the current line, '\0' terminated. lineLength counts the kept bytes only.
+	 */
+	char line[HTTP_REQUEST_LINE_MAX_LENGTH + 1];
+	int lineLength;
+	bool lineTruncated;
+
+	/**
+	 * Framing of the body of the current request, taken from its Content-Length and Transfer-Encoding headers.
+	 */
+	unsigned long contentLength;
+	bool chunked;
+
+	/**
+	 * Bytes left of the current body (HttpRequestParserState__BODY) or chunk (HttpRequestParserState__CHUNK_DATA).
+	 */
+	unsigned long remaining;
+} HttpRequestParser;
+
+/**
+ * Called for every complete request line (without the line ending). @truncated is set if the line was longer than
+ * HTTP_REQUEST_LINE_MAX_LENGTH and only its beginning is available.
+ * @return false if the line isn't a supported HTTP request line, the parser ignores the rest of the connection in that case
+ */
+typedef bool (*HttpRequestLineHandler)(char* requestLine, int length, bool truncated, void* context);
+
+void initHttpRequestParser(HttpRequestParser* parser);
+
+/**
+ * Feed the next @length received bytes of the connection to the @parser, @handler is called with @context for each request line that
+ * is completed within @buf.
+ */
+void parseHttpRequests(HttpRequestParser* parser, const char* buf, size_t length, HttpRequestLineHandler handler, void* context);
@@ -0,0 +1,123 @@
+// Copyright 2024 Dynatrace LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Portions of this code, as identified in remarks, are provided under the
+// Creative Commons BY-SA 4.0 or the MIT license, and are provided without
+// any warranty. In each of the remarks, we have provided attribution to the
+// original creators and other attribution parties, along with the title of
+// the code (if known) a copyright notice and a link to the license, and a
+// statement indicating whether or not we have modified the code.
+
+#include "LogRing.h"
+
+#include <linux/futex.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+LogRing* initLogRing() {
+	// mmap instead of malloc: the ring is allocated once per process and shouldn't share pages with allocations of the application
+	LogRing* logRing = mmap(NULL, sizeof(LogRing), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (logRing == MAP_FAILED) {
+		return NULL;
+	}
+
+	for (unsigned long i = 0; i < LOG_RING_LENGTH; i++) {
+		logRing->records[i].sequence = i;
+	}
+	logRing->head = 0;
+	logRing->dropCount = 0;
+	logRing->consumerSleeping = 0;
+	logRing->tail = 0;
+	pthread_mutex_init(&(logRing->consumerMutex), NULL);
+
+	return logRing;
+}
+
+bool pushLogRecord(LogRing* logRing, const char* text, int length) {
+	unsigned long ticket = __atomic_load_n(&(logRing->head), __ATOMIC_RELAXED);
+	LogRecord* record;
+
+	while (1) {
+		record = &(logRing->records[ticket & (LOG_RING_LENGTH - 1)]);
+		long difference = (long)(__atomic_load_n(&(record->sequence), __ATOMIC_ACQUIRE) - ticket);
+
+		if (difference == 0) {
+			// slot is free for this ticket, on failure ticket is reloaded with the current head
+			if (__atomic_compare_exchange_n(&(logRing->head), &ticket, ticket + 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+				break;
+			}
+		} else if (difference < 0) {
+			// slot still holds a record of the previous round: ring is full
+			__atomic_add_fetch(&(logRing->dropCount), 1, __ATOMIC_RELAXED);
+			return false;
+		} else {
+			ticket = __atomic_load_n(&(logRing->head), __ATOMIC_RELAXED);
+		}
+	}
+
+	if (length > LOG_RECORD_MAX_LENGTH) {
+		length = LOG_RECORD_MAX_LENGTH;
+	}
+	memcpy(record->text, text, length);
+	record->length = length;
+	__atomic_store_n(&(record->sequence), ticket + 1, __ATOMIC_RELEASE);
+
+	// pairs with the fence of waitForLogRecords(): either the consumer sees the record or this producer sees the consumer sleeping
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	if (__atomic_load_n(&(logRing->consumerSleeping), __ATOMIC_RELAXED) != 0 &&
+		__atomic_exchange_n(&(logRing->consumerSleeping), 0, __ATOMIC_RELAXED) != 0) {
+		syscall(SYS_futex, &(logRing->consumerSleeping), FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+	}
+
+	return true;
+}
+
+LogRecord* peekLogRecord(LogRing* logRing, int offset) {
+	unsigned long ticket = logRing->tail + offset;
+	LogRecord* record = &(logRing->records[ticket & (LOG_RING_LENGTH - 1)]);
+
+	if (__atomic_load_n(&(record->sequence), __ATOMIC_ACQUIRE) != ticket + 1) {
+		return NULL;
+	}
+
+	return record;
+}
+
+void releaseLogRecords(LogRing* logRing, int count) {
+	for (int i = 0; i < count; i++) {
+		LogRecord* record = &(logRing->records[logRing->tail & (LOG_RING_LENGTH - 1)]);
+		__atomic_store_n(&(record->sequence), logRing->tail + LOG_RING_LENGTH, __ATOMIC_RELEASE);
+		logRing->tail++;
+	}
+}
+
+void waitForLogRecords(LogRing* logRing, int timeoutMs) {
+	__atomic_store_n(&(logRing->consumerSleeping), 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+	// the tail is only advanced by the consumer itself, so the ring is empty if the record at the tail isn't readable
+	LogRecord* record = &(logRing->records[logRing->tail & (LOG_RING_LENGTH - 1)]);
+	if (__atomic_load_n(&(record->sequence), __ATOMIC_ACQUIRE) == logRing->tail + 1) {
+		__atomic_store_n(&(logRing->consumerSleeping), 0, __ATOMIC_RELAXED);
+		return;
+	}
+
+	// returns right away if a producer reset the word in between
+	struct timespec timeout = {timeoutMs / 1000, (timeoutMs % 1000) * 1000000L};
+	syscall(SYS_futex, &(logRing->consumerSleeping), FUTEX_WAIT_PRIVATE, 1, &timeout, NULL, 0);
+	__atomic_store_n(&(logRing->consumerSleeping), 0, __ATOMIC_RELAXED);
+}
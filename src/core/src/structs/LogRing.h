@@ -0,0 +1,112 @@
+// Copyright 2024 Dynatrace LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Portions of this code, as identified in remarks, are provided under the
+// Creative Commons BY-SA 4.0 or the MIT license, and are provided without
+// any warranty. In each of the remarks, we have provided attribution to the
+// original creators and other attribution parties, along with the title of
+// the code (if known) a copyright notice and a link to the license, and a
+// statement indicating whether or not we have modified the code.
+
+#pragma once
+
+#include <pthread.h>
+#include <stdbool.h>
+
+/**
+ * Number of records of the LogRing, has to be a power of 2.
+ */
+#define LOG_RING_LENGTH 1024
+
+/**
+ * Maximum length of a single formatted log line, longer lines are truncated.
+ */
+#define LOG_RECORD_MAX_LENGTH 256
+
+/**
+ * A pre-formatted log line within the LogRing.
+ */
+typedef struct {
+	/**
+	 * Sequence number of the slot: equal to the ticket of the next producer if the slot is free, ticket + 1 once the record is written
+	 * and readable by the consumer.
+	 */
+	unsigned long sequence;
+
+	int length;
+
+	char text[LOG_RECORD_MAX_LENGTH];
+} LogRecord;
+
+/**
+ * Bounded multi-producer single-consumer ring buffer for log lines. Producers (the threads calling simpleLogger()) claim a slot with a
+ * CAS on head and never block: if the ring is full the line is dropped and counted in dropCount. The single consumer (the logger
+ * thread) drains the records in order and sleeps on a futex while the ring is empty, the first record pushed into the empty ring wakes it.
+ */
+typedef struct {
+	/**
+	 * Ticket of the next producer. On its own cache line since all producers update it.
+	 */
+	unsigned long head __attribute__((aligned(64)));
+
+	/**
+	 * Number of log lines dropped because the ring was full.
+	 */
+	unsigned long dropCount __attribute__((aligned(64)));
+
+	/**
+	 * Futex word, 1 while the consumer sleeps in waitForLogRecords() (or is about to), reset by the producer that wakes it.
+	 */
+	int consumerSleeping __attribute__((aligned(64)));
+
+	/**
+	 * Ticket of the next record read by the consumer. Only accessed while holding consumerMutex.
+	 */
+	unsigned long tail;
+
+	/**
+	 * Serializes the consumer side, e.g. the logger thread and the final flush on process exit.
+	 */
+	pthread_mutex_t consumerMutex;
+
+	LogRecord records[LOG_RING_LENGTH];
+} LogRing;
+
+/**
+ * @return a new empty LogRing or NULL if it couldn't be allocated
+ */
+LogRing* initLogRing();
+
+/**
+ * Copy the log line @text of @length bytes into a free slot of the @logRing without blocking.
+ * @return false if the ring is full and the line was dropped
+ */
+bool pushLogRecord(LogRing* logRing, const char* text, int length);
+
+/**
+ * Consumer side: @return the next readable record or NULL if the ring is empty. @offset is the position relative to the tail, so a
+ * batch of records can be peeked before they are released with releaseLogRecords(). Has to be called with consumerMutex held.
+ */
+LogRecord* peekLogRecord(LogRing* logRing, int offset);
+
+/**
+ * Consumer side: hand the next @count peeked records back to the producers. Has to be called with consumerMutex held.
+ */
+void releaseLogRecords(LogRing* logRing, int count);
+
+/**
+ * Consumer side: block until a record is pushed into the empty @logRing or @timeoutMs milliseconds passed. Returns right away if the
+ * ring isn't empty. Has to be called by the single consumer without holding consumerMutex.
+ */
+void waitForLogRecords(LogRing* logRing, int timeoutMs);
@@ -0,0 +1,399 @@
+// Copyright 2024 Dynatrace LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Portions of this code, as identified in remarks, are provided under the
+// Creative Commons BY-SA 4.0 or the MIT license, and are provided without
+// any warranty. In each of the remarks, we have provided attribution to the
+// original creators and other attribution parties, along with the title of
+// the code (if known) a copyright notice and a link to the license, and a
+// statement indicating whether or not we have modified the code.
+
+#include "ModelImage.h"
+
+#include "BodyInjection.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+/**
+ * Growing buffer the image is serialized into. Only offsets are handed out, so the buffer can move while it grows.
+ */
+typedef struct {
+	char* bytes;
+	size_t length;
+	size_t capacity;
+	bool failed;
+} ImageWriter;
+
+/**
+ * Append @length bytes of @source (zeros if NULL) aligned to 8 bytes.
+ * @return offset of the appended bytes, 0 if the writer failed
+ */
+static uint32_t appendImageBytes(ImageWriter* writer, const void* source, size_t length) {
+	size_t offset = (writer->length + 7) & ~(size_t)7;
+
+	if (writer->failed || offset + length > MODEL_IMAGE_MAX_LENGTH) {
+		writer->failed = true;
+		return 0;
+	}
+	if (offset + length > writer->capacity) {
+		size_t capacity = writer->capacity * 2 > offset + length ? writer->capacity * 2 : offset + length;
+		char* bytes = realloc(writer->bytes, capacity);
+		if (bytes == NULL) {
+			writer->failed = true;
+			return 0;
+		}
+		writer->bytes = bytes;
+		writer->capacity = capacity;
+	}
+
+	memset(writer->bytes + writer->length, 0, offset - writer->length);
+	if (source != NULL) {
+		memcpy(writer->bytes + offset, source, length);
+	} else {
+		memset(writer->bytes + offset, 0, length);
+	}
+	writer->length = offset + length;
+
+	return offset;
+}
+
+static ModelImageString appendImageString(ImageWriter* writer, const char* string, int length) {
+	ModelImageString imageString = {0, 0};
+
+	if (string != NULL) {
+		imageString.offset = appendImageBytes(writer, NULL, length + 1);
+		imageString.length = length;
+		if (!writer->failed) {
+			memcpy(writer->bytes + imageString.offset, string, length);
+		}
+	}
+
+	return imageString;
+}
+
+uint64_t hashBytes(const void* bytes, size_t length) {
+	uint64_t hash = 14695981039346656037ULL;
+
+	for (size_t i = 0; i < length; i++) {
+		hash ^= ((const unsigned char*)bytes)[i];
+		hash *= 1099511628211ULL;
+	}
+
+	return hash;
+}
+
+/**
+ * Checksum of the bytes of @image behind its header.
+ */
+static uint64_t checksumModelImage(const ModelImage* image, size_t length) {
+	return hashBytes((const char*)image + sizeof(ModelImage), length - sizeof(ModelImage));
+}
+
+static void writeRecvModel(ImageWriter* writer, const SO_HW_recv* recvModel) {
+	ModelImage* header = (ModelImage*)writer->bytes;
+	header->recvEnabled = recvModel->enabled;
+
+	const PathMatcher* matcher = recvModel->pathMatcher;
+	if (matcher == NULL) {
+		return;
+	}
+
+	int pathsLength = recvModel->matchingPathsLength;
+	uint32_t pathsOffset = appendImageBytes(writer, NULL, sizeof(ModelImageString) * pathsLength);
+	uint32_t statusCodesOffset = appendImageBytes(writer, recvModel->matchingPathStatusCodes, sizeof(uint16_t) * pathsLength);
+	uint32_t transitionsOffset =
+			appendImageBytes(writer, matcher->transitions, sizeof(int32_t) * matcher->statesLength * matcher->classesLength);
+	uint32_t matchesOffset = appendImageBytes(writer, matcher->matches, sizeof(int32_t) * matcher->statesLength);
+
+	for (int i = 0; i < pathsLength; i++) {
+		ModelImageString path = appendImageString(writer, recvModel->matchingPaths[i], strlen(recvModel->matchingPaths[i]));
+		if (!writer->failed) {
+			((ModelImageString*)(writer->bytes + pathsOffset))[i] = path;
+		}
+	}
+	if (writer->failed) {
+		return;
+	}
+
+	header = (ModelImage*)writer->bytes;
+	header->pathsLength = pathsLength;
+	header->pathsOffset = pathsOffset;
+	header->pathStatusCodesOffset = statusCodesOffset;
+	memcpy(header->byteClasses, matcher->byteClasses, sizeof(header->byteClasses));
+	header->classesLength = matcher->classesLength;
+	header->statesLength = matcher->statesLength;
+	header->transitionsOffset = transitionsOffset;
+	header->matchesOffset = matchesOffset;
+}
+
+static void writeSendModel(ImageWriter* writer, const SO_HW_send* sendModel) {
+	ModelImage* header = (ModelImage*)writer->bytes;
+	header->sendEnabled = sendModel->enabled;
+
+	const ResponseProgram* program = sendModel->responseProgram;
+	if (program == NULL) {
+		return;
+	}
+
+	ModelImageString bodyValue = appendImageString(writer, program->bodyValue, program->bodyValueLength);
+	ModelImageString bodyAnchor = appendImageString(writer, program->bodyAnchor, program->bodyAnchorLength);
+	ModelImageString insertedHeaders = appendImageString(writer, program->insertedHeaders, program->insertedHeadersLength);
+	uint32_t instructionsOffset = appendImageBytes(writer, NULL, sizeof(ModelImageInstruction) * program->instructionsLength);
+
+	for (int i = 0; i < program->instructionsLength; i++) {
+		const ResponseInstruction* instruction = &(program->instructions[i]);
+		ModelImageInstruction imageInstruction;
+
+		imageInstruction.type = instruction->type;
+		imageInstruction.key = appendImageString(writer, instruction->key, instruction->keyLength);
+		imageInstruction.value = appendImageString(writer, instruction->value, instruction->valueLength);
+		if (!writer->failed) {
+			((ModelImageInstruction*)(writer->bytes + instructionsOffset))[i] = imageInstruction;
+		}
+	}
+	if (writer->failed) {
+		return;
+	}
+
+	header = (ModelImage*)writer->bytes;
+	header->hasResponseProgram = true;
+	header->replaceStatusCode = program->replaceStatusCode;
+	memcpy(header->keyInitials, program->keyInitials, sizeof(header->keyInitials));
+	header->keyLengths = program->keyLengths;
+	header->bodyValue = bodyValue;
+	header->bodyAnchor = bodyAnchor;
+	header->insertedHeaders = insertedHeaders;
+	header->instructionsLength = program->instructionsLength;
+	header->instructionsOffset = instructionsOffset;
+}
+
+ModelImage* buildModelImage(const SO_HW_Model* model, uint64_t sourceHash, uint64_t generation) {
+	ImageWriter writer = {NULL, 0, 0, false};
+
+	appendImageBytes(&writer, NULL, sizeof(ModelImage));
+	if (writer.failed) {
+		return NULL;
+	}
+
+	ModelImage* header = (ModelImage*)writer.bytes;
+	header->magic = MODEL_IMAGE_MAGIC;
+	header->version = MODEL_IMAGE_VERSION;
+	header->sourceHash = sourceHash;
+	header->generation = generation;
+	header->accept4Enabled = model->accept4Model->enabled;
+
+	writeRecvModel(&writer, model->recvModel);
+	writeSendModel(&writer, model->sendModel);
+	if (writer.failed) {
+		free(writer.bytes);
+		return NULL;
+	}
+
+	header = (ModelImage*)writer.bytes;
+	header->length = writer.length;
+	header->checksum = checksumModelImage(header, writer.length);
+
+	return header;
+}
+
+/**
+ * @return true if @count elements of @size bytes at @offset are within the image of @length bytes and behind its header
+ */
+static bool isImageRange(size_t length, uint32_t offset, size_t count, size_t size) {
+	return offset >= sizeof(ModelImage) && offset % 8 == 0 && offset <= length && count <= (length - offset) / size;
+}
+
+/**
+ * @return true if @string is NULL or a '\0' terminated string of at most @maxLength bytes within the image
+ */
+static bool isImageString(const ModelImage* image, ModelImageString string, uint32_t maxLength) {
+	if (string.offset == 0) {
+		return string.length == 0;
+	}
+
+	return string.length <= maxLength && isImageRange(image->length, string.offset, string.length + 1, 1) &&
+		((const char*)image)[string.offset + string.length] == '\0';
+}
+
+static bool validateImagePathMatcher(const ModelImage* image) {
+	if (image->pathsLength == 0) {
+		return true;
+	}
+	if (image->classesLength == 0 || image->classesLength > 256 || image->statesLength == 0 ||
+		image->statesLength > MODEL_IMAGE_MAX_LENGTH / image->classesLength ||
+		!isImageRange(image->length, image->pathsOffset, image->pathsLength, sizeof(ModelImageString)) ||
+		!isImageRange(image->length, image->pathStatusCodesOffset, image->pathsLength, sizeof(uint16_t)) ||
+		!isImageRange(image->length, image->transitionsOffset, (size_t)image->statesLength * image->classesLength, sizeof(int32_t)) ||
+		!isImageRange(image->length, image->matchesOffset, image->statesLength, sizeof(int32_t))) {
+		return false;
+	}
+
+	const ModelImageString* paths = (const ModelImageString*)((const char*)image + image->pathsOffset);
+	for (uint32_t i = 0; i < image->pathsLength; i++) {
+		if (paths[i].offset == 0 || !isImageString(image, paths[i], UINT32_MAX - 1)) {
+			return false;
+		}
+	}
+
+	for (int byte = 0; byte < 256; byte++) {
+		if (image->byteClasses[byte] >= image->classesLength) {
+			return false;
+		}
+	}
+
+	// matchPath() follows the tables without any check
+	const int32_t* transitions = (const int32_t*)((const char*)image + image->transitionsOffset);
+	for (size_t i = 0; i < (size_t)image->statesLength * image->classesLength; i++) {
+		if (transitions[i] < 0 || (uint32_t)transitions[i] >= image->statesLength) {
+			return false;
+		}
+	}
+
+	const int32_t* matches = (const int32_t*)((const char*)image + image->matchesOffset);
+	for (uint32_t i = 0; i < image->statesLength; i++) {
+		if (matches[i] < -1 || matches[i] >= (int32_t)image->pathsLength) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static bool validateImageResponseProgram(const ModelImage* image) {
+	if (!image->hasResponseProgram) {
+		return true;
+	}
+	if (!isImageString(image, image->bodyValue, BODY_INJECTION_VALUE_MAX_LENGTH) ||
+		!isImageString(image, image->bodyAnchor, BODY_INJECTION_ANCHOR_MAX_LENGTH) ||
+		!isImageString(image, image->insertedHeaders, RESPONSE_PROGRAM_REPLACEMENT_MAX_LENGTH) ||
+		!isImageRange(image->length, image->instructionsOffset, image->instructionsLength, sizeof(ModelImageInstruction))) {
+		return false;
+	}
+
+	const ModelImageInstruction* instructions = (const ModelImageInstruction*)((const char*)image + image->instructionsOffset);
+	for (uint32_t i = 0; i < image->instructionsLength; i++) {
+		if ((instructions[i].type != ResponseInstructionType__REPLACE_HEADER && instructions[i].type != ResponseInstructionType__DELETE_HEADER) ||
+			instructions[i].key.offset == 0 || instructions[i].value.offset == 0 || !isImageString(image, instructions[i].key, INT32_MAX) ||
+			!isImageString(image, instructions[i].value, RESPONSE_PROGRAM_REPLACEMENT_MAX_LENGTH)) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool validateModelImage(const ModelImage* image, size_t length) {
+	if (length < sizeof(ModelImage) || length > MODEL_IMAGE_MAX_LENGTH || image->magic != MODEL_IMAGE_MAGIC ||
+		image->version != MODEL_IMAGE_VERSION || image->length != length) {
+		return false;
+	}
+
+	return image->checksum == checksumModelImage(image, length) && validateImagePathMatcher(image) && validateImageResponseProgram(image);
+}
+
+static const char* imageString(const ModelImage* image, ModelImageString string) {
+	return string.offset != 0 ? (const char*)image + string.offset : NULL;
+}
+
+static bool mapImageRecvModel(const ModelImage* image, SO_HW_recv* recvModel) {
+	recvModel->enabled = image->recvEnabled;
+	if (image->pathsLength == 0) {
+		return true;
+	}
+
+	const ModelImageString* paths = (const ModelImageString*)((const char*)image + image->pathsOffset);
+	recvModel->matchingPaths = malloc(sizeof(char*) * image->pathsLength);
+	recvModel->pathMatcher = malloc(sizeof(PathMatcher));
+	if (recvModel->matchingPaths == NULL || recvModel->pathMatcher == NULL) {
+		return false;
+	}
+
+	for (uint32_t i = 0; i < image->pathsLength; i++) {
+		recvModel->matchingPaths[i] = imageString(image, paths[i]);
+	}
+	recvModel->matchingPathStatusCodes = (unsigned short*)((const char*)image + image->pathStatusCodesOffset);
+	recvModel->matchingPathsLength = image->pathsLength;
+
+	PathMatcher* matcher = recvModel->pathMatcher;
+	memcpy(matcher->byteClasses, image->byteClasses, sizeof(matcher->byteClasses));
+	matcher->classesLength = image->classesLength;
+	matcher->statesLength = image->statesLength;
+	matcher->transitions = (int*)((const char*)image + image->transitionsOffset);
+	matcher->matches = (int*)((const char*)image + image->matchesOffset);
+
+	return true;
+}
+
+static bool mapImageSendModel(const ModelImage* image, SO_HW_send* sendModel) {
+	sendModel->enabled = image->sendEnabled;
+	if (!image->hasResponseProgram) {
+		return true;
+	}
+
+	ResponseProgram* program = malloc(sizeof(ResponseProgram) + sizeof(ResponseInstruction) * image->instructionsLength);
+	if (program == NULL) {
+		return false;
+	}
+	sendModel->responseProgram = program;
+
+	program->replaceStatusCode = image->replaceStatusCode;
+	program->rejectedOperationsLength = 0;
+	program->bodyValue = imageString(image, image->bodyValue);
+	program->bodyValueLength = image->bodyValue.length;
+	program->bodyAnchor = imageString(image, image->bodyAnchor);
+	program->bodyAnchorLength = image->bodyAnchor.length;
+	program->insertedHeaders = imageString(image, image->insertedHeaders);
+	program->insertedHeadersLength = image->insertedHeaders.length;
+	program->keyLengths = image->keyLengths;
+	memcpy(program->keyInitials, image->keyInitials, sizeof(program->keyInitials));
+
+	const ModelImageInstruction* instructions = (const ModelImageInstruction*)((const char*)image + image->instructionsOffset);
+	program->instructionsLength = image->instructionsLength;
+	for (uint32_t i = 0; i < image->instructionsLength; i++) {
+		program->instructions[i].type = instructions[i].type;
+		program->instructions[i].key = imageString(image, instructions[i].key);
+		program->instructions[i].keyLength = instructions[i].key.length;
+		program->instructions[i].value = imageString(image, instructions[i].value);
+		program->instructions[i].valueLength = instructions[i].value.length;
+	}
+
+	return true;
+}
+
+SO_HW_Model* mapModelImage(const ModelImage* image, size_t length) {
+	SO_HW_Model* model = initSharedObjectHoneywireModel();
+	if (model == NULL) {
+		return NULL;
+	}
+	model->image = image;
+	model->imageLength = length;
+	model->accept4Model->enabled = image->accept4Enabled;
+
+	if (!mapImageRecvModel(image, model->recvModel) || !mapImageSendModel(image, model->sendModel)) {
+		// keep the mapping for the caller
+		model->image = NULL;
+		free(model->recvModel->matchingPaths);
+		free(model->recvModel->pathMatcher);
+		free(model->sendModel->responseProgram);
+		free(model->recvModel);
+		free(model->sendModel);
+		free(model->accept4Model);
+		free(model);
+		return NULL;
+	}
+
+	return model;
+}
@@ -0,0 +1,138 @@
+// Copyright 2024 Dynatrace LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Portions of this code, as identified in remarks, are provided under the
+// Creative Commons BY-SA 4.0 or the MIT license, and are provided without
+// any warranty. In each of the remarks, we have provided attribution to the
+// original creators and other attribution parties, along with the title of
+// the code (if known) a copyright notice and a link to the license, and a
+// statement indicating whether or not we have modified the code.
+
+#pragma once
+
+#include "HoneyWireSharedObjectModel.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * "HWMI" in the byte order of the writing process, an image of a host with another byte order is rejected.
+ */
+#define MODEL_IMAGE_MAGIC 0x494d5748u
+
+/**
+ * Increased with every change of the layout below, images of another version are rejected (and compiled again).
+ */
+#define MODEL_IMAGE_VERSION 1
+
+/**
+ * Upper bound of the length of an image that is mapped, larger files are rejected without reading them.
+ */
+#define MODEL_IMAGE_MAX_LENGTH (64 << 20)
+
+/**
+ * A string within a ModelImage: @length bytes followed by a '\0' at @offset, offset 0 (the header) for NULL.
+ */
+typedef struct {
+	uint32_t offset;
+	uint32_t length;
+} ModelImageString;
+
+typedef struct {
+	uint32_t type; // ResponseInstructionType
+	ModelImageString key;
+	ModelImageString value;
+} ModelImageInstruction;
+
+/**
+ * Compiled SO_HW_Model in a single position-independent block: every reference is a byte offset from the start of the header, so the
+ * image can be written to a file and mapped read-only by any number of processes at any address. The tables and strings are used in
+ * place, a process only allocates the small SO_HW_Model structs that point into its mapping (see mapModelImage()).
+ */
+typedef struct {
+	uint32_t magic;
+	uint32_t version;
+
+	/**
+	 * Bytes of the whole image including this header.
+	 */
+	uint64_t length;
+
+	/**
+	 * 64-bit FNV-1a hash of the bytes following this header.
+	 */
+	uint64_t checksum;
+
+	/**
+	 * Content hash of the HoneYamlFile the image was compiled from.
+	 */
+	uint64_t sourceHash;
+
+	/**
+	 * Number of images published to the same file before, including this one.
+	 */
+	uint64_t generation;
+
+	uint8_t accept4Enabled;
+	uint8_t recvEnabled;
+	uint8_t sendEnabled;
+	uint8_t hasResponseProgram;
+
+	// SO_HW_recv: ModelImageString[pathsLength] and uint16_t[pathsLength]
+	uint32_t pathsLength;
+	uint32_t pathsOffset;
+	uint32_t pathStatusCodesOffset;
+
+	// PathMatcher of the paths if pathsLength > 0: int32_t[statesLength * classesLength] and int32_t[statesLength]
+	uint8_t byteClasses[256];
+	uint32_t classesLength;
+	uint32_t statesLength;
+	uint32_t transitionsOffset;
+	uint32_t matchesOffset;
+
+	// ResponseProgram if hasResponseProgram: ModelImageInstruction[instructionsLength]
+	uint8_t replaceStatusCode;
+	uint32_t keyInitials[8];
+	uint64_t keyLengths;
+	ModelImageString bodyValue;
+	ModelImageString bodyAnchor;
+	ModelImageString insertedHeaders;
+	uint32_t instructionsLength;
+	uint32_t instructionsOffset;
+} ModelImage;
+
+/**
+ * 64-bit FNV-1a hash of @length @bytes, used as checksum of a ModelImage and as content hash of a HoneYamlFile (see sourceHash).
+ */
+uint64_t hashBytes(const void* bytes, size_t length);
+
+/**
+ * Serialize @model into a new ModelImage, free it with free().
+ * @return NULL if an allocation failed or the image would exceed MODEL_IMAGE_MAX_LENGTH
+ */
+ModelImage* buildModelImage(const SO_HW_Model* model, uint64_t sourceHash, uint64_t generation);
+
+/**
+ * Check that the @length bytes at @image are a complete ModelImage of this version: the checksum matches and every offset, table entry
+ * and string stays within the image. Images are read from files, so nothing of them is trusted before.
+ */
+bool validateModelImage(const ModelImage* image, size_t length);
+
+/**
+ * Create a SO_HW_Model that uses the tables and strings of the validated @image in place. @image has to be an mmap()ed region of
+ * @length bytes, it's unmapped by freeSharedObjectHoneywireMapping() of the model.
+ * @return NULL if an allocation failed (@image stays mapped)
+ */
+SO_HW_Model* mapModelImage(const ModelImage* image, size_t length);
@@ -0,0 +1,192 @@
+// Copyright 2024 Dynatrace LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Portions of this code, as identified in remarks, are provided under the
+// Creative Commons BY-SA 4.0 or the MIT license, and are provided without
+// any warranty. In each of the remarks, we have provided attribution to the
+// original creators and other attribution parties, along with the title of
+// the code (if known) a copyright notice and a link to the license, and a
+// statement indicating whether or not we have modified the code.
+
+#include "PathMatcher.h"
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Assign a column of the transition table to every byte that occurs in a path, all other bytes share column 0. Keeps the table small,
+ * since paths only use a fraction of the 256 byte values.
+ */
+static void assignByteClasses(PathMatcher* matcher, const char* const* paths, int pathsLength) {
+	memset(matcher->byteClasses, 0, sizeof(matcher->byteClasses));
+	matcher->classesLength = 1;
+
+	for (int i = 0; i < pathsLength; i++) {
+		for (const unsigned char* byte = (const unsigned char*)paths[i]; *byte != '\0'; byte++) {
+			if (matcher->byteClasses[*byte] == 0) {
+				matcher->byteClasses[*byte] = matcher->classesLength++;
+			}
+		}
+	}
+}
+
+/**
+ * Insert all paths into the trie of @matcher, transitions not part of the trie are -1 afterwards.
+ */
+static void buildTrie(PathMatcher* matcher, const char* const* paths, int pathsLength) {
+	int classesLength = matcher->classesLength;
+
+	matcher->statesLength = 1;
+	matcher->matches[0] = -1;
+
+	for (int i = 0; i < pathsLength; i++) {
+		int state = 0;
+
+		for (const unsigned char* byte = (const unsigned char*)paths[i]; *byte != '\0'; byte++) {
+			int* transition = &(matcher->transitions[state * classesLength + matcher->byteClasses[*byte]]);
+
+			if (*transition == -1) {
+				*transition = matcher->statesLength;
+				matcher->matches[matcher->statesLength] = -1;
+				matcher->statesLength++;
+			}
+			state = *transition;
+		}
+
+		// duplicated paths: the first one wins
+		if (matcher->matches[state] == -1) {
+			matcher->matches[state] = i;
+		}
+	}
+}
+
+/**
+ * Turn the trie into the DFA: breadth first, every missing transition of a state is the transition of its failure state (the longest
+ * proper suffix that is a trie state), and every state inherits the match of its failure state.
+ * @return false if an allocation failed
+ */
+static bool linkFailureStates(PathMatcher* matcher) {
+	int classesLength = matcher->classesLength;
+	int* failureStates = malloc(sizeof(int) * matcher->statesLength);
+	int* queue = malloc(sizeof(int) * matcher->statesLength);
+
+	if (failureStates == NULL || queue == NULL) {
+		free(failureStates);
+		free(queue);
+		return false;
+	}
+
+	int queueHead = 0;
+	int queueTail = 0;
+
+	for (int byteClass = 0; byteClass < classesLength; byteClass++) {
+		int* transition = &(matcher->transitions[byteClass]);
+
+		if (*transition == -1) {
+			*transition = 0;
+		} else {
+			failureStates[*transition] = 0;
+			queue[queueTail++] = *transition;
+		}
+	}
+
+	while (queueHead < queueTail) {
+		int state = queue[queueHead++];
+		int failureState = failureStates[state];
+		int failureMatch = matcher->matches[failureState];
+
+		if (failureMatch != -1 && (matcher->matches[state] == -1 || failureMatch < matcher->matches[state])) {
+			matcher->matches[state] = failureMatch;
+		}
+
+		for (int byteClass = 0; byteClass < classesLength; byteClass++) {
+			int* transition = &(matcher->transitions[state * classesLength + byteClass]);
+			int failureTransition = matcher->transitions[failureState * classesLength + byteClass];
+
+			if (*transition == -1) {
+				*transition = failureTransition;
+			} else {
+				failureStates[*transition] = failureTransition;
+				queue[queueTail++] = *transition;
+			}
+		}
+	}
+
+	free(failureStates);
+	free(queue);
+	return true;
+}
+
+PathMatcher* compilePathMatcher(const char* const* paths, int pathsLength) {
+	if (pathsLength <= 0) {
+		return NULL;
+	}
+
+	PathMatcher* matcher = malloc(sizeof(PathMatcher));
+	if (matcher == NULL) {
+		return NULL;
+	}
+
+	assignByteClasses(matcher, paths, pathsLength);
+
+	// a trie has at most one state per path byte plus the root
+	size_t maxStatesLength = 1;
+	for (int i = 0; i < pathsLength; i++) {
+		maxStatesLength += strlen(paths[i]);
+	}
+
+	matcher->transitions = malloc(sizeof(int) * maxStatesLength * matcher->classesLength);
+	matcher->matches = malloc(sizeof(int) * maxStatesLength);
+	if (matcher->transitions == NULL || matcher->matches == NULL) {
+		freePathMatcher(matcher);
+		return NULL;
+	}
+	memset(matcher->transitions, -1, sizeof(int) * maxStatesLength * matcher->classesLength);
+
+	buildTrie(matcher, paths, pathsLength);
+	if (!linkFailureStates(matcher)) {
+		freePathMatcher(matcher);
+		return NULL;
+	}
+
+	return matcher;
+}
+
+int matchPath(const PathMatcher* matcher, const char* buf, size_t length) {
+	const int* transitions = matcher->transitions;
+	const int* matches = matcher->matches;
+	int classesLength = matcher->classesLength;
+	int state = 0;
+	int match = -1;
+
+	// a path ending first in @buf isn't necessarily the one configured first (e.g. "/admin" before "/admin/secret")
+	for (size_t i = 0; i < length && match != 0; i++) {
+		state = transitions[state * classesLength + matcher->byteClasses[(unsigned char)buf[i]]];
+
+		if (matches[state] != -1 && (match == -1 || matches[state] < match)) {
+			match = matches[state];
+		}
+	}
+
+	return match;
+}
+
+void freePathMatcher(PathMatcher* matcher) {
+	if (matcher != NULL) {
+		free(matcher->transitions);
+		free(matcher->matches);
+		free(matcher);
+	}
+}
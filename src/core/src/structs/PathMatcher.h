@@ -0,0 +1,62 @@
+// Copyright 2024 Dynatrace LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Portions of this code, as identified in remarks, are provided under the
+// Creative Commons BY-SA 4.0 or the MIT license, and are provided without
+// any warranty. In each of the remarks, we have provided attribution to the
+// original creators and other attribution parties, along with the title of
+// the code (if known) a copyright notice and a link to the license, and a
+// statement indicating whether or not we have modified the code.
+
+#pragma once
+
+#include <stddef.h>
+
+/**
+ * Aho-Corasick automaton of the condition paths of all honeywires, compiled once per SO_HW_Model snapshot. Every byte of a request
+ * line is matched with a single table lookup, independent of the number of paths.
+ */
+typedef struct {
+	/**
+	 * Column of every byte in the transition table, 0 for all bytes that aren't part of any path.
+	 */
+	unsigned char byteClasses[256];
+	int classesLength;
+
+	/**
+	 * Dense transition table of the DFA: next state of state s for byte b is transitions[s * classesLength + byteClasses[b]].
+	 */
+	int* transitions;
+
+	/**
+	 * Index of the path matched when entering a state (the lowest index if several paths end in it), -1 if no path ends in the state.
+	 */
+	int* matches;
+	int statesLength;
+} PathMatcher;
+
+/**
+ * Compile the @pathsLength @paths (non-empty, '\0' terminated) into a PathMatcher. The paths are not referenced afterwards.
+ * @return NULL if @pathsLength is 0 or an allocation failed
+ */
+PathMatcher* compilePathMatcher(const char* const* paths, int pathsLength);
+
+/**
+ * Search @length bytes of @buf for any path of @matcher (substring match, e.g. "/admin" matches "GET /admin HTTP/1.1").
+ * @return the lowest index of all paths contained in @buf, so the path configured first wins if several paths match (e.g. "/admin" and
+ * "/admin/secret" for "GET /admin/secret"), -1 if no path is contained
+ */
+int matchPath(const PathMatcher* matcher, const char* buf, size_t length);
+
+void freePathMatcher(PathMatcher* matcher);
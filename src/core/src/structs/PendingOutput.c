@@ -0,0 +1,163 @@
+// Copyright 2024 Dynatrace LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Portions of this code, as identified in remarks, are provided under the
+// Creative Commons BY-SA 4.0 or the MIT license, and are provided without
+// any warranty. In each of the remarks, we have provided attribution to the
+// original creators and other attribution parties, along with the title of
+// the code (if known) a copyright notice and a link to the license, and a
+// statement indicating whether or not we have modified the code.
+
+#include "PendingOutput.h"
+
+#include <string.h>
+
+void startPendingOutput(PendingOutput* pending, size_t originalLength) {
+	pending->originalLength = originalLength;
+	pending->splicesLength = 0;
+	pending->replacementsLength = 0;
+}
+
+bool startPendingInsertion(PendingOutput* pending, const struct iovec* segments, int segmentsLength, size_t replacedLength) {
+	size_t length = 0;
+	for (int i = 0; i < segmentsLength; i++) {
+		length += segments[i].iov_len;
+	}
+	if (length > PENDING_OUTPUT_REPLACEMENTS_LENGTH) {
+		return false;
+	}
+
+	startPendingOutput(pending, replacedLength);
+
+	for (int i = 0; i < segmentsLength; i++) {
+		memcpy(pending->replacements + pending->replacementsLength, segments[i].iov_base, segments[i].iov_len);
+		pending->replacementsLength += segments[i].iov_len;
+	}
+	pending->splices[0] = (PendingSplice){0, replacedLength, 0, length};
+	pending->splicesLength = 1;
+
+	return true;
+}
+
+int resumePendingOutput(const PendingOutput* pending, ResponseRewrite* rewrite) {
+	truncateResponseRewrite(rewrite, pending->originalLength);
+
+	int resumed = 0;
+	for (; resumed < pending->splicesLength; resumed++) {
+		const PendingSplice* splice = &(pending->splices[resumed]);
+
+		// a range at the start of a call that is shorter than the range is replaced in parts, its replacement is sent with the first one
+		size_t replacedLength = splice->replacedLength;
+		if (splice->offset == 0 && replacedLength > rewrite->originalLength) {
+			replacedLength = rewrite->originalLength;
+		}
+
+		if (splice->offset + replacedLength > rewrite->originalLength ||
+			!spliceResponseReference(rewrite, splice->offset, replacedLength, pending->replacements + splice->replacementOffset,
+					splice->replacementLength)) {
+			// the call is sent up to the splice, which is left to the next call
+			truncateResponseRewrite(rewrite, splice->offset);
+			break;
+		}
+	}
+
+	return resumed;
+}
+
+/**
+ * Append a splice to @pending, its replacement is moved behind the replacements of the splices in front of it. @replacement can be part of
+ * the replacements of @pending behind them (see savePendingOutput()).
+ * @return false if the splices or the replacements of @pending are exhausted
+ */
+static bool addPendingSplice(
+		PendingOutput* pending, size_t offset, size_t replacedLength, const char* replacement, size_t replacementLength) {
+	if (pending->splicesLength == PENDING_OUTPUT_MAX_SPLICES ||
+		replacementLength > sizeof(pending->replacements) - pending->replacementsLength) {
+		return false;
+	}
+
+	PendingSplice* splice = &(pending->splices[pending->splicesLength++]);
+	splice->offset = offset;
+	splice->replacedLength = replacedLength;
+	splice->replacementOffset = pending->replacementsLength;
+	splice->replacementLength = replacementLength;
+
+	memmove(pending->replacements + pending->replacementsLength, replacement, replacementLength);
+	pending->replacementsLength += replacementLength;
+	return true;
+}
+
+bool savePendingOutput(PendingOutput* pending, const ResponseRewrite* rewrite, int resumed, size_t consumedLength, size_t* reported) {
+	size_t originalLength = pending->originalLength - consumedLength;
+	int splicesLength = pending->splicesLength;
+
+	// a replacement can be inserted right at the end of the original buffer, the application wouldn't call again for it
+	*reported = consumedLength;
+	bool repeatLastByte = consumedLength > 0 && originalLength == 0 && (resumed < splicesLength || hasUnsentReplacements(rewrite));
+	if (repeatLastByte) {
+		(*reported)--;
+		originalLength = 1;
+	}
+
+	// a range of @pending that is replaced in parts (see resumePendingOutput())
+	size_t restOffset = 0;
+	size_t restLength = 0;
+	if (resumed > 0) {
+		const PendingSplice* splice = &(pending->splices[resumed - 1]);
+
+		if (splice->offset + splice->replacedLength > rewrite->originalLength) {
+			restOffset = rewrite->originalLength - *reported;
+			restLength = splice->offset + splice->replacedLength - rewrite->originalLength;
+		}
+	}
+
+	// the splices of @pending that aren't resumed are moved behind the new ones in front of them, their replacements stay in place until
+	// they are compacted: the replacements of the new splices are either outside of @pending or in front of them (see
+	// resumePendingOutput())
+	int newSplicesLength = (repeatLastByte ? 1 : 0) + (restLength > 0 ? 1 : 0);
+	for (int i = rewrite->sentSegments; i < rewrite->segmentsLength; i++) {
+		newSplicesLength += rewrite->replacements[i] ? 1 : 0;
+	}
+	if (newSplicesLength + splicesLength - resumed > PENDING_OUTPUT_MAX_SPLICES) {
+		return false;
+	}
+	memmove(pending->splices + newSplicesLength, pending->splices + resumed, sizeof(PendingSplice) * (splicesLength - resumed));
+
+	pending->originalLength = originalLength;
+	pending->splicesLength = 0;
+	pending->replacementsLength = 0;
+	bool saved = !repeatLastByte || addPendingSplice(pending, 0, 1, "", 0);
+
+	// position within the original buffer of the first unsent segment
+	size_t position = consumedLength;
+	for (int i = rewrite->sentSegments; saved && i < rewrite->segmentsLength; i++) {
+		if (rewrite->replacements[i]) {
+			saved = addPendingSplice(pending, position - *reported, rewrite->replacedLengths[i], rewrite->segments[i].iov_base,
+					rewrite->segments[i].iov_len);
+		}
+		position += rewrite->replacedLengths[i];
+	}
+
+	if (saved && restLength > 0) {
+		saved = addPendingSplice(pending, restOffset, restLength, "", 0);
+	}
+
+	for (int i = newSplicesLength; saved && i < newSplicesLength + splicesLength - resumed; i++) {
+		PendingSplice splice = pending->splices[i];
+		const char* replacement = pending->replacements + splice.replacementOffset;
+		saved = addPendingSplice(pending, splice.offset - *reported, splice.replacedLength, replacement, splice.replacementLength);
+	}
+
+	return saved;
+}
@@ -0,0 +1,110 @@
+// Copyright 2024 Dynatrace LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Portions of this code, as identified in remarks, are provided under the
+// Creative Commons BY-SA 4.0 or the MIT license, and are provided without
+// any warranty. In each of the remarks, we have provided attribution to the
+// original creators and other attribution parties, along with the title of
+// the code (if known) a copyright notice and a link to the license, and a
+// statement indicating whether or not we have modified the code.
+
+#pragma once
+
+#include "HeaderAccumulator.h"
+#include "ResponseRewrite.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * Maximal number of splices of a PendingOutput: the replacements of a ResponseRewrite and the range at its end the application repeats
+ * although it is already sent.
+ */
+#define PENDING_OUTPUT_MAX_SPLICES (RESPONSE_REWRITE_MAX_SEGMENTS + 1)
+
+/**
+ * Bytes available for the replacements of a PendingOutput: the replacements of a ResponseRewrite or the rest of a flushed header (see
+ * startPendingInsertion()), which is rewritten from up to HEADER_ACCUMULATOR_MAX_LENGTH held bytes.
+ */
+#define PENDING_OUTPUT_REPLACEMENTS_LENGTH (HEADER_ACCUMULATOR_MAX_LENGTH + RESPONSE_REWRITE_SCRATCH_LENGTH)
+
+/**
+ * A replacement of a PendingOutput, relative to the first byte the application repeats.
+ */
+typedef struct {
+	size_t offset;
+	size_t replacedLength;
+
+	/**
+	 * Position of the replacement in the replacements buffer of the PendingOutput.
+	 */
+	size_t replacementOffset;
+	size_t replacementLength;
+} PendingSplice;
+
+/**
+ * The rest of a rewritten response that isn't sent yet, e.g. because a non-blocking socket took only a part of it (EAGAIN). The
+ * application considers the original bytes in front of it as sent and repeats the others with its next call, which is rewritten with the
+ * pending splices instead of being rewritten as new bytes of the response. Only the replacements are copied, never the original bytes.
+ */
+typedef struct {
+	/**
+	 * Bytes the application repeats that belong to the rewritten response, a call isn't rewritten beyond them.
+	 */
+	size_t originalLength;
+
+	PendingSplice splices[PENDING_OUTPUT_MAX_SPLICES];
+	int splicesLength;
+
+	char replacements[PENDING_OUTPUT_REPLACEMENTS_LENGTH];
+	size_t replacementsLength;
+} PendingOutput;
+
+/**
+ * Start @pending for the @originalLength bytes of a rewritten response, without any splice yet (see savePendingOutput()).
+ */
+void startPendingOutput(PendingOutput* pending, size_t originalLength);
+
+/**
+ * Start @pending sending the @segmentsLength @segments in place of the first @replacedLength bytes of the next call of the application,
+ * e.g. the rest of a held header the application already considers as sent. With @replacedLength 0 they are inserted in front of the next
+ * call, which is sent up to them only (i.e. nothing of it is reported as sent).
+ * @return false if the segments exceed PENDING_OUTPUT_REPLACEMENTS_LENGTH
+ */
+bool startPendingInsertion(PendingOutput* pending, const struct iovec* segments, int segmentsLength, size_t replacedLength);
+
+/**
+ * Splice the pending replacements into @rewrite, a call of the application that repeats the bytes from the first unsent one on. The
+ * rewrite is truncated to the bytes of @pending (i.e. a short write), the rest of the call is rewritten as new bytes of the response. The
+ * replacements are referenced, so @pending mustn't change until @rewrite is sent.
+ * @return number of splices of @pending that are part of @rewrite, to be passed to savePendingOutput()
+ */
+int resumePendingOutput(const PendingOutput* pending, ResponseRewrite* rewrite);
+
+/**
+ * Replace the splices of @pending by the replacements of @rewrite that aren't sent and the splices of @pending behind the first @resumed
+ * ones, once the application considers @consumedLength bytes of @rewrite as sent. @pending is compacted in place, the replacements of
+ * @rewrite can reference it (see resumePendingOutput()). If no original byte is left to be repeated but a replacement is, the last original
+ * byte is reported as unsent again, so the application repeats it and the replacement isn't stuck. @reported is set to the bytes of the
+ * original buffer the application has to consider as sent.
+ * @return false if the splices or the replacements of @pending are exhausted, the rest of the response can't be sent then
+ */
+bool savePendingOutput(PendingOutput* pending, const ResponseRewrite* rewrite, int resumed, size_t consumedLength, size_t* reported);
+
+/**
+ * @return true if nothing of the rewritten response is pending anymore
+ */
+static inline bool isPendingOutputDone(const PendingOutput* pending) {
+	return pending->originalLength == 0 && pending->splicesLength == 0;
+}
@@ -0,0 +1,213 @@
+// Copyright 2024 Dynatrace LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Portions of this code, as identified in remarks, are provided under the
+// Creative Commons BY-SA 4.0 or the MIT license, and are provided without
+// any warranty. In each of the remarks, we have provided attribution to the
+// original creators and other attribution parties, along with the title of
+// the code (if known) a copyright notice and a link to the license, and a
+// statement indicating whether or not we have modified the code.
+
+#include "ResponseProgram.h"
+
+#include "BodyInjection.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @return true if @string can be part of a header line, i.e. it doesn't end the line
+ */
+static bool isHeaderLineText(const char* string) {
+	return strpbrk(string, "\r\n") == NULL;
+}
+
+/**
+ * Map the operation @operation of @wire to the ResponseInstructionType of its instruction.
+ * @return false if the operation isn't an instruction (e.g. replace-status-code or insert-header), misses its key or value, its value
+ * exceeds RESPONSE_PROGRAM_REPLACEMENT_MAX_LENGTH or @wire is disabled
+ */
+static bool instructionType(const Honeywire* wire, const HoneywireOperation* operation, ResponseInstructionType* type) {
+	if (!wire->enabled || wire->kind != HoneywireKind__HTTP_HEADER || operation->key == NULL) {
+		return false;
+	}
+
+	switch (operation->type) {
+	case HoneywireOperationType__REPLACE_INPLACE:
+		*type = ResponseInstructionType__REPLACE_HEADER;
+		return operation->value != NULL && isHeaderLineText(operation->value) &&
+			strlen(operation->value) <= RESPONSE_PROGRAM_REPLACEMENT_MAX_LENGTH;
+	case HoneywireOperationType__DELETE_HEADER:
+		*type = ResponseInstructionType__DELETE_HEADER;
+		return true;
+	default:
+		return false;
+	}
+}
+
+/**
+ * @return true if @operation of @wire is an insert-header operation whose key and value form a valid header line
+ */
+static bool isInsertedHeader(const Honeywire* wire, const HoneywireOperation* operation) {
+	return wire->enabled && wire->kind == HoneywireKind__HTTP_HEADER && operation->type == HoneywireOperationType__INSERT_HEADER &&
+		operation->key != NULL && operation->key[0] != '\0' && strpbrk(operation->key, ": \t\r\n") == NULL && operation->value != NULL &&
+		isHeaderLineText(operation->value);
+}
+
+/**
+ * @return true if @operation of @wire is an insert-body operation whose anchor (key, empty if missing) and decoy (value) fit into a
+ * BodyInjection
+ */
+static bool isBodyInjection(const Honeywire* wire, const HoneywireOperation* operation) {
+	return wire->enabled && wire->kind == HoneywireKind__HTTP_BODY && operation->type == HoneywireOperationType__INSERT_BODY &&
+		operation->value != NULL && operation->value[0] != '\0' && strlen(operation->value) <= BODY_INJECTION_VALUE_MAX_LENGTH &&
+		(operation->key == NULL || strlen(operation->key) <= BODY_INJECTION_ANCHOR_MAX_LENGTH);
+}
+
+/**
+ * Bytes of the header line "<key>: <value>\r\n" of the insert-header operation @operation.
+ */
+static size_t insertedHeaderLength(const HoneywireOperation* operation) {
+	return strlen(operation->key) + strlen(": ") + strlen(operation->value) + strlen("\r\n");
+}
+
+/**
+ * @return true if the header line of the insert-header operation @operation of @wire is inserted behind the @insertedHeadersLength bytes
+ * of the header lines of the operations in front of it, i.e. all of them fit into RESPONSE_PROGRAM_REPLACEMENT_MAX_LENGTH
+ */
+static bool isInsertedHeaderFitting(const Honeywire* wire, const HoneywireOperation* operation, size_t insertedHeadersLength) {
+	return isInsertedHeader(wire, operation) &&
+		insertedHeadersLength + insertedHeaderLength(operation) <= RESPONSE_PROGRAM_REPLACEMENT_MAX_LENGTH;
+}
+
+/**
+ * @return true if @operation of @wire is a valid replace-inplace operation whose value exceeds RESPONSE_PROGRAM_REPLACEMENT_MAX_LENGTH
+ */
+static bool isReplacementTooLong(const Honeywire* wire, const HoneywireOperation* operation) {
+	return wire->enabled && wire->kind == HoneywireKind__HTTP_HEADER && operation->type == HoneywireOperationType__REPLACE_INPLACE &&
+		operation->key != NULL && operation->value != NULL && isHeaderLineText(operation->value) &&
+		strlen(operation->value) > RESPONSE_PROGRAM_REPLACEMENT_MAX_LENGTH;
+}
+
+ResponseProgram* compileResponseProgram(Honeywire* const* wires, int wiresLength) {
+	int instructionsLength = 0;
+	size_t stringsLength = 0;
+	size_t insertedHeadersLength = 0;
+	int rejectedOperationsLength = 0;
+	bool replaceStatusCode = false;
+	const HoneywireOperation* bodyInjection = NULL;
+	ResponseInstructionType type;
+
+	for (int i = 0; i < wiresLength; i++) {
+		for (int j = 0; j < wires[i]->operationsLength; j++) {
+			const HoneywireOperation* operation = wires[i]->operations[j];
+
+			if (wires[i]->enabled && wires[i]->kind == HoneywireKind__RESPONSE_CODE &&
+				operation->type == HoneywireOperationType__REPLACE_STATUS_CODE) {
+				replaceStatusCode = true;
+			} else if (bodyInjection == NULL && isBodyInjection(wires[i], operation)) {
+				bodyInjection = operation;
+				stringsLength += (operation->key != NULL ? strlen(operation->key) : 0) + 1 + strlen(operation->value) + 1;
+			} else if (isInsertedHeaderFitting(wires[i], operation, insertedHeadersLength)) {
+				insertedHeadersLength += insertedHeaderLength(operation);
+			} else if (instructionType(wires[i], operation, &type)) {
+				instructionsLength++;
+				stringsLength += strlen(operation->key) + 1 + (type == ResponseInstructionType__REPLACE_HEADER ? strlen(operation->value) : 0) + 1;
+			} else if (isInsertedHeader(wires[i], operation) || isReplacementTooLong(wires[i], operation)) {
+				rejectedOperationsLength++;
+			}
+		}
+	}
+	stringsLength += insertedHeadersLength + 1;
+
+	ResponseProgram* program = malloc(sizeof(ResponseProgram) + sizeof(ResponseInstruction) * instructionsLength + stringsLength);
+	if (program == NULL) {
+		return NULL;
+	}
+	program->replaceStatusCode = replaceStatusCode;
+	program->rejectedOperationsLength = rejectedOperationsLength;
+	program->instructionsLength = 0;
+	program->keyLengths = 0;
+	memset(program->keyInitials, 0, sizeof(program->keyInitials));
+
+	char* strings = (char*)(program->instructions + instructionsLength);
+
+	program->bodyValue = NULL;
+	program->bodyValueLength = 0;
+	program->bodyAnchor = NULL;
+	program->bodyAnchorLength = 0;
+	if (bodyInjection != NULL) {
+		const char* anchor = bodyInjection->key != NULL ? bodyInjection->key : "";
+
+		program->bodyAnchorLength = strlen(anchor);
+		program->bodyAnchor = strings;
+		memcpy(strings, anchor, program->bodyAnchorLength + 1);
+		strings += program->bodyAnchorLength + 1;
+
+		program->bodyValueLength = strlen(bodyInjection->value);
+		program->bodyValue = strings;
+		memcpy(strings, bodyInjection->value, program->bodyValueLength + 1);
+		strings += program->bodyValueLength + 1;
+	}
+
+	// the header lines of all insert-header operations in a row, so they are inserted with a single splice
+	program->insertedHeaders = insertedHeadersLength > 0 ? strings : NULL;
+	program->insertedHeadersLength = insertedHeadersLength;
+	size_t insertedLength = 0;
+	for (int i = 0; i < wiresLength; i++) {
+		for (int j = 0; j < wires[i]->operationsLength; j++) {
+			const HoneywireOperation* operation = wires[i]->operations[j];
+
+			if (isInsertedHeaderFitting(wires[i], operation, insertedLength)) {
+				size_t lineLength = insertedHeaderLength(operation);
+				snprintf(strings + insertedLength, lineLength + 1, "%s: %s\r\n", operation->key, operation->value);
+				insertedLength += lineLength;
+			}
+		}
+	}
+	strings += insertedLength;
+	*strings++ = '\0';
+
+	for (int i = 0; i < wiresLength; i++) {
+		for (int j = 0; j < wires[i]->operationsLength; j++) {
+			const HoneywireOperation* operation = wires[i]->operations[j];
+
+			if (!instructionType(wires[i], operation, &type)) {
+				continue;
+			}
+
+			ResponseInstruction* instruction = &(program->instructions[program->instructionsLength++]);
+			instruction->type = type;
+
+			instruction->keyLength = strlen(operation->key);
+			instruction->key = strings;
+			memcpy(strings, operation->key, instruction->keyLength + 1);
+			strings += instruction->keyLength + 1;
+
+			instruction->valueLength = type == ResponseInstructionType__REPLACE_HEADER ? strlen(operation->value) : 0;
+			instruction->value = strings;
+			memcpy(strings, type == ResponseInstructionType__REPLACE_HEADER ? operation->value : "", instruction->valueLength + 1);
+			strings += instruction->valueLength + 1;
+
+			// a header line is only compared with the keys if its name passes the filter
+			program->keyLengths |= 1ull << (instruction->keyLength < 63 ? instruction->keyLength : 63);
+			unsigned char initial = tolower((unsigned char)instruction->key[0]);
+			program->keyInitials[initial / 32] |= 1u << (initial % 32);
+		}
+	}
+
+	return program;
+}
@@ -0,0 +1,100 @@
+// Copyright 2024 Dynatrace LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Portions of this code, as identified in remarks, are provided under the
+// Creative Commons BY-SA 4.0 or the MIT license, and are provided without
+// any warranty. In each of the remarks, we have provided attribution to the
+// original creators and other attribution parties, along with the title of
+// the code (if known) a copyright notice and a link to the license, and a
+// statement indicating whether or not we have modified the code.
+
+#pragma once
+
+#include "HoneyWire.h"
+#include "ResponseRewrite.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * Maximal bytes of all inserted header lines together and of every replaced header value. They are copied into the scratch buffer of a
+ * ResponseRewrite, which also holds the status line and the Content-Length of a BodyInjection.
+ */
+#define RESPONSE_PROGRAM_REPLACEMENT_MAX_LENGTH (RESPONSE_REWRITE_SCRATCH_LENGTH / 2)
+
+typedef enum {
+	// replace the value of the header lines of key with value
+	ResponseInstructionType__REPLACE_HEADER,
+	// delete the header lines of key
+	ResponseInstructionType__DELETE_HEADER,
+} ResponseInstructionType;
+
+typedef struct {
+	ResponseInstructionType type;
+	const char* key;
+	int keyLength;
+	const char* value;
+	int valueLength;
+} ResponseInstruction;
+
+/**
+ * Rewrite of the responses compiled from all honeywires of a HoneywiresConfig: a flat list of instructions that the send()/write() hooks
+ * run in a single pass over the header block, followed by the inserted header lines. A ResponseProgram is one immutable allocation, the strings of the instructions follow the
+ * instructions (or are part of the ModelImage the program was mapped from). The path set that selects the deceived status code is part of SO_HW_recv (see PathMatcher).
+ */
+typedef struct {
+	/**
+	 * Replace the status code of responses to requests of a matching path.
+	 */
+	bool replaceStatusCode;
+
+	/**
+	 * Decoy inserted into the bodies of textual responses behind the first occurrence of bodyAnchor (see BodyInjection), NULL if no
+	 * insert-body operation of an http-body honeywire is enabled. Only the first insert-body operation is used.
+	 */
+	const char* bodyValue;
+	int bodyValueLength;
+	const char* bodyAnchor;
+	int bodyAnchorLength;
+
+	/**
+	 * Header lines of all insert-header operations ("<key>: <value>\r\n" each), inserted with a single splice at the end of the header
+	 * block, NULL if there are none.
+	 */
+	const char* insertedHeaders;
+	int insertedHeadersLength;
+
+	/**
+	 * Filter of the header lines the instructions can match, so the header lines of a response are rejected without comparing them with
+	 * every key: bit n of keyLengths is set for keys of n bytes (bit 63 for longer ones), bit c of keyInitials for keys starting with the
+	 * (lowercase) byte c.
+	 */
+	uint64_t keyLengths;
+	uint32_t keyInitials[8];
+
+	/**
+	 * Number of insert-header and replace-inplace operations left out, since they exceed RESPONSE_PROGRAM_REPLACEMENT_MAX_LENGTH.
+	 */
+	int rejectedOperationsLength;
+
+	int instructionsLength;
+	ResponseInstruction instructions[];
+} ResponseProgram;
+
+/**
+ * Compile the operations of all enabled wires of the @wiresLength @wires into a ResponseProgram, free it with free(). Insert-header
+ * operations are taken in order as long as their header lines fit into RESPONSE_PROGRAM_REPLACEMENT_MAX_LENGTH, replace-inplace
+ * operations if their value does (see rejectedOperationsLength).
+ */
+ResponseProgram* compileResponseProgram(Honeywire* const* wires, int wiresLength);
@@ -0,0 +1,150 @@
+// Copyright 2024 Dynatrace LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Portions of this code, as identified in remarks, are provided under the
+// Creative Commons BY-SA 4.0 or the MIT license, and are provided without
+// any warranty. In each of the remarks, we have provided attribution to the
+// original creators and other attribution parties, along with the title of
+// the code (if known) a copyright notice and a link to the license, and a
+// statement indicating whether or not we have modified the code.
+
+#include "ResponseRewrite.h"
+
+#include <string.h>
+
+void initResponseRewrite(ResponseRewrite* rewrite, const void* original, size_t originalLength) {
+	rewrite->original = original;
+	rewrite->originalLength = originalLength;
+	rewrite->originalOffset = 0;
+	rewrite->segmentsLength = 0;
+	rewrite->scratchLength = 0;
+	rewrite->sentSegments = 0;
+	rewrite->consumedLength = 0;
+	rewrite->sentLength = 0;
+}
+
+static void appendSegment(ResponseRewrite* rewrite, const char* data, size_t length, size_t replacedLength, bool replacement) {
+	rewrite->segments[rewrite->segmentsLength].iov_base = (void*)data;
+	rewrite->segments[rewrite->segmentsLength].iov_len = length;
+	rewrite->replacedLengths[rewrite->segmentsLength] = replacedLength;
+	rewrite->replacements[rewrite->segmentsLength] = replacement;
+	rewrite->segmentsLength++;
+}
+
+char* reserveResponseScratch(ResponseRewrite* rewrite, size_t length) {
+	if (length > RESPONSE_REWRITE_SCRATCH_LENGTH - rewrite->scratchLength) {
+		return NULL;
+	}
+
+	char* reserved = rewrite->scratch + rewrite->scratchLength;
+	rewrite->scratchLength += length;
+	return reserved;
+}
+
+static bool splice(
+		ResponseRewrite* rewrite, size_t offset, size_t replacedLength, const char* replacement, size_t replacementLength, bool copy) {
+	if (offset < rewrite->originalOffset || offset > rewrite->originalLength || replacedLength > rewrite->originalLength - offset) {
+		return false;
+	}
+
+	// original bytes in front of the splice, the replacement and the final rest of the original (see finishResponseRewrite())
+	int neededSegments = (offset > rewrite->originalOffset ? 1 : 0) + 1 + 1;
+	if (rewrite->segmentsLength + neededSegments > RESPONSE_REWRITE_MAX_SEGMENTS) {
+		return false;
+	}
+
+	// replacements built with reserveResponseScratch() are already in place
+	const char* scratchReplacement = replacement;
+	if (copy && (replacement < rewrite->scratch || replacement >= rewrite->scratch + RESPONSE_REWRITE_SCRATCH_LENGTH)) {
+		char* reserved = reserveResponseScratch(rewrite, replacementLength);
+		if (reserved == NULL) {
+			return false;
+		}
+		memcpy(reserved, replacement, replacementLength);
+		scratchReplacement = reserved;
+	}
+
+	if (offset > rewrite->originalOffset) {
+		size_t length = offset - rewrite->originalOffset;
+		appendSegment(rewrite, rewrite->original + rewrite->originalOffset, length, length, false);
+	}
+	appendSegment(rewrite, scratchReplacement, replacementLength, replacedLength, true);
+	rewrite->originalOffset = offset + replacedLength;
+
+	return true;
+}
+
+bool spliceResponse(ResponseRewrite* rewrite, size_t offset, size_t replacedLength, const char* replacement, size_t replacementLength) {
+	return splice(rewrite, offset, replacedLength, replacement, replacementLength, true);
+}
+
+bool spliceResponseReference(
+		ResponseRewrite* rewrite, size_t offset, size_t replacedLength, const char* replacement, size_t replacementLength) {
+	return splice(rewrite, offset, replacedLength, replacement, replacementLength, false);
+}
+
+void truncateResponseRewrite(ResponseRewrite* rewrite, size_t length) {
+	if (length >= rewrite->originalOffset && length < rewrite->originalLength) {
+		rewrite->originalLength = length;
+	}
+}
+
+bool finishResponseRewrite(ResponseRewrite* rewrite) {
+	if (rewrite->segmentsLength == 0) {
+		return false;
+	}
+
+	if (rewrite->originalOffset < rewrite->originalLength) {
+		size_t length = rewrite->originalLength - rewrite->originalOffset;
+		appendSegment(rewrite, rewrite->original + rewrite->originalOffset, length, length, false);
+		rewrite->originalOffset = rewrite->originalLength;
+	}
+
+	return true;
+}
+
+void advanceResponseRewrite(ResponseRewrite* rewrite, size_t sent) {
+	rewrite->sentLength += sent;
+
+	while (rewrite->sentSegments < rewrite->segmentsLength) {
+		int index = rewrite->sentSegments;
+		struct iovec* segment = &(rewrite->segments[index]);
+
+		if (sent >= segment->iov_len) {
+			sent -= segment->iov_len;
+			rewrite->consumedLength += rewrite->replacedLengths[index];
+			rewrite->sentSegments++;
+			continue;
+		}
+
+		// partially sent: the original bytes are consumed right away, a replacement only stands for its range once it is sent completely
+		if (!rewrite->replacements[index]) {
+			rewrite->consumedLength += sent;
+			rewrite->replacedLengths[index] -= sent;
+		}
+		segment->iov_base = (char*)segment->iov_base + sent;
+		segment->iov_len -= sent;
+		break;
+	}
+}
+
+bool hasUnsentReplacements(const ResponseRewrite* rewrite) {
+	for (int i = rewrite->sentSegments; i < rewrite->segmentsLength; i++) {
+		if (rewrite->replacements[i]) {
+			return true;
+		}
+	}
+
+	return false;
+}
@@ -0,0 +1,116 @@
+// Copyright 2024 Dynatrace LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Portions of this code, as identified in remarks, are provided under the
+// Creative Commons BY-SA 4.0 or the MIT license, and are provided without
+// any warranty. In each of the remarks, we have provided attribution to the
+// original creators and other attribution parties, along with the title of
+// the code (if known) a copyright notice and a link to the license, and a
+// statement indicating whether or not we have modified the code.
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <sys/uio.h>
+
+/**
+ * Maximal number of segments of a ResponseRewrite, i.e. of the iovec handed to sendmsg().
+ */
+#define RESPONSE_REWRITE_MAX_SEGMENTS 32
+
+/**
+ * Bytes available for the replacements of a ResponseRewrite (e.g. status line and header values).
+ */
+#define RESPONSE_REWRITE_SCRATCH_LENGTH 1024
+
+/**
+ * A response of the application rewritten without copying it: the segments alternate between ranges of the original buffer and
+ * replacements, which can be longer or shorter than the range they replace (an empty range inserts, an empty replacement deletes).
+ * Replacements are copied into the scratch buffer, so the ResponseRewrite doesn't reference the SO_HW_Model snapshot while it is sent.
+ */
+typedef struct {
+	const char* original;
+	size_t originalLength;
+
+	/**
+	 * Bytes of the original buffer covered by the segments so far, every splice has to start at or after it.
+	 */
+	size_t originalOffset;
+
+	struct iovec segments[RESPONSE_REWRITE_MAX_SEGMENTS];
+	/**
+	 * Bytes of the original buffer a segment stands for: its own length for original segments, the replaced range for replacements.
+	 */
+	size_t replacedLengths[RESPONSE_REWRITE_MAX_SEGMENTS];
+	bool replacements[RESPONSE_REWRITE_MAX_SEGMENTS];
+	int segmentsLength;
+
+	char scratch[RESPONSE_REWRITE_SCRATCH_LENGTH];
+	size_t scratchLength;
+
+	/**
+	 * Progress of sending: index of the first segment that isn't sent completely (its iovec is advanced past the sent bytes), the bytes
+	 * of the original buffer the application has to consider as sent and the bytes of the segments that are sent.
+	 */
+	int sentSegments;
+	size_t consumedLength;
+	size_t sentLength;
+} ResponseRewrite;
+
+void initResponseRewrite(ResponseRewrite* rewrite, const void* original, size_t originalLength);
+
+/**
+ * Replace the @replacedLength bytes at @offset of the original buffer with the @replacementLength bytes of @replacement.
+ * @return false (and the ResponseRewrite is unchanged) if the range starts before the end of the previous splice or exceeds the original
+ * buffer, or if the segments or the scratch buffer are exhausted
+ */
+bool spliceResponse(ResponseRewrite* rewrite, size_t offset, size_t replacedLength, const char* replacement, size_t replacementLength);
+
+/**
+ * spliceResponse() without copying @replacement into the scratch buffer, it has to stay valid until the ResponseRewrite is sent (e.g. the
+ * replacements of a PendingOutput, which can exceed the scratch buffer).
+ */
+bool spliceResponseReference(
+		ResponseRewrite* rewrite, size_t offset, size_t replacedLength, const char* replacement, size_t replacementLength);
+
+/**
+ * Reserve @length bytes of the scratch buffer for a replacement that is written by the caller and spliced afterwards.
+ * @return NULL if the scratch buffer is exhausted
+ */
+char* reserveResponseScratch(ResponseRewrite* rewrite, size_t length);
+
+/**
+ * Leave the original bytes from @length on to the next call of the application (i.e. a short write), @length mustn't be in front of the
+ * end of the previous splice.
+ */
+void truncateResponseRewrite(ResponseRewrite* rewrite, size_t length);
+
+/**
+ * Append the rest of the original buffer as the last segment.
+ * @return true if the response was changed by any splice
+ */
+bool finishResponseRewrite(ResponseRewrite* rewrite);
+
+/**
+ * Account @sent bytes of the unsent segments (e.g. the result of sendmsg() of segments[sentSegments..segmentsLength]).
+ */
+void advanceResponseRewrite(ResponseRewrite* rewrite, size_t sent);
+
+/**
+ * A replacement that isn't sent completely has no equivalent in the original buffer: if the application repeated the rest of its buffer,
+ * the original bytes would be sent instead. So sending may only stop early once no replacement is left.
+ * @return true if a replacement segment isn't sent completely yet
+ */
+bool hasUnsentReplacements(const ResponseRewrite* rewrite);
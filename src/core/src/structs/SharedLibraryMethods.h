@@ -22,6 +22,8 @@
 #pragma once
 
 #include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/uio.h>
 
 #ifndef __USE_GNU
 #	define __USE_GNU
@@ -36,6 +38,13 @@ typedef int (*func_accept4_t)(int, struct sockaddr*, socklen_t*, int);
 typedef int (*func_getsockname_t)(int, struct sockaddr*, socklen_t* restrict);
 typedef ssize_t (*func_recv_t)(int, void*, size_t, int);
 typedef ssize_t (*func_send_t)(int, const void*, size_t, int);
+typedef ssize_t (*func_readv_t)(int, const struct iovec*, int);
+typedef ssize_t (*func_recvmsg_t)(int, struct msghdr*, int);
+typedef ssize_t (*func_recvfrom_t)(int, void*, size_t, int, struct sockaddr*, socklen_t*);
+typedef ssize_t (*func_writev_t)(int, const struct iovec*, int);
+typedef ssize_t (*func_sendmsg_t)(int, const struct msghdr*, int);
+typedef ssize_t (*func_sendto_t)(int, const void*, size_t, int, const struct sockaddr*, socklen_t);
+typedef ssize_t (*func_sendfile_t)(int, int, off_t*, size_t);
 typedef ssize_t (*func_read_t)(int, void*, size_t);
 typedef ssize_t (*func_write_t)(int, const void*, size_t);
 typedef int (*func_close_t)(int);
@@ -51,5 +60,12 @@ typedef struct {
 	func_send_t send_global;
 	func_read_t read_global;
 	func_write_t write_global;
+	func_readv_t readv_global;
+	func_recvmsg_t recvmsg_global;
+	func_recvfrom_t recvfrom_global;
+	func_writev_t writev_global;
+	func_sendmsg_t sendmsg_global;
+	func_sendto_t sendto_global;
+	func_sendfile_t sendfile_global;
 	func_close_t close_global;
 } SharedLibraryMethods;
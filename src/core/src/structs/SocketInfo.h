@@ -21,9 +21,177 @@
 
 #pragma once
 
-enum RequestOption { NONE, ADMIN_PATH };
+#include "BodyInjection.h"
+#include "HeaderAccumulator.h"
+#include "HttpRequestParser.h"
+#include "PendingOutput.h"
 
-typedef struct {
-	enum RequestOption requestMode;
-	int socketProgress;
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * Maximal number of pipelined requests of a connection whose response hasn't started yet.
+ */
+#define SOCKET_INFO_PENDING_REQUESTS_LENGTH 16
+
+/**
+ * Per-connection state of a traced socket. SocketInfos are handed out by the SocketInfoPool when the first data of a connection is
+ * received and returned to the pool on close().
+ */
+typedef struct SocketInfo {
+	/**
+	 * Request boundaries of the received bytes, e.g. for keep-alive connections and pipelined requests.
+	 */
+	HttpRequestParser requestParser;
+
+	/**
+	 * Status code the responses of the requests that are received but whose response hasn't started yet are deceived with (0 keeps the
+	 * original status code), oldest first (ring buffer).
+	 */
+	uint16_t pendingRequests[SOCKET_INFO_PENDING_REQUESTS_LENGTH];
+	/**
+	 * Bit i is set if pendingRequests[i] is a HEAD request, whose response has no body.
+	 */
+	uint16_t pendingHeadRequests;
+	uint8_t pendingRequestsHead;
+	uint8_t pendingRequestsCount;
+
+	/**
+	 * Status code the response that is currently written is deceived with, 0 keeps the original status code.
+	 */
+	uint16_t deceivedStatusCode;
+
+	/**
+	 * The response that is currently written answers a HEAD request.
+	 */
+	bool headResponse;
+
+	/**
+	 * The response that is currently written took deceivedStatusCode and headResponse from pendingRequests (see untrackResponseWrite()).
+	 */
+	bool requestTaken;
+
+	/**
+	 * Number of write()/send() calls of the current response.
+	 */
+	unsigned int socketProgress;
+
+	/**
+	 * Header of the current response while it is written with several write()/send() calls.
+	 */
+	HeaderAccumulator headerAccumulator;
+
+	/**
+	 * Decoy that is inserted into the body of the current response, NULL if none is pending.
+	 */
+	BodyInjection* bodyInjection;
+
+	/**
+	 * Rest of a rewritten response the application repeats with its next write()/send(), NULL if none is pending.
+	 */
+	PendingOutput* pendingOutput;
+
+	/**
+	 * Next free SocketInfo while the SocketInfo is part of the free-list of the SocketInfoPool, NULL while it is in use.
+	 */
+	struct SocketInfo* next;
 } SocketInfo;
+
+/**
+ * Reset @socketInfo for a new connection.
+ */
+static inline void resetSocketInfo(SocketInfo* socketInfo) {
+	initHttpRequestParser(&(socketInfo->requestParser));
+	socketInfo->pendingHeadRequests = 0;
+	socketInfo->pendingRequestsHead = 0;
+	socketInfo->pendingRequestsCount = 0;
+	socketInfo->deceivedStatusCode = 0;
+	socketInfo->headResponse = false;
+	socketInfo->requestTaken = false;
+	socketInfo->socketProgress = 0;
+	initHeaderAccumulator(&(socketInfo->headerAccumulator));
+	socketInfo->bodyInjection = NULL;
+	socketInfo->pendingOutput = NULL;
+}
+
+/**
+ * Queue the status code the response of a received request is deceived with (0 for none) until its response starts. If too many
+ * requests are pipelined, the request is dropped and its response keeps the original status code.
+ */
+static inline void pushPendingRequest(SocketInfo* socketInfo, uint16_t deceivedStatusCode, bool headRequest) {
+	if (socketInfo->pendingRequestsCount == SOCKET_INFO_PENDING_REQUESTS_LENGTH) {
+		return;
+	}
+
+	int index = (socketInfo->pendingRequestsHead + socketInfo->pendingRequestsCount) % SOCKET_INFO_PENDING_REQUESTS_LENGTH;
+	socketInfo->pendingRequests[index] = deceivedStatusCode;
+	if (headRequest) {
+		socketInfo->pendingHeadRequests |= (uint16_t)(1u << index);
+	} else {
+		socketInfo->pendingHeadRequests &= (uint16_t) ~(1u << index);
+	}
+	socketInfo->pendingRequestsCount++;
+}
+
+/**
+ * @return true if the @length bytes of @buf start with the status line of an interim response (1xx, e.g. "100 Continue" for a request with
+ * "Expect: 100-continue"), which precedes the final response of the same request. "101 Switching Protocols" is the last HTTP response of
+ * the connection, so it counts as final.
+ */
+static inline bool isInterimResponse(const char* buf, size_t length) {
+	// "HTTP/1.1 1xx": the status code follows the version
+	size_t statusCode = strlen("HTTP/1.1 ");
+	if (length < statusCode + 3 || buf[statusCode - 1] != ' ' || buf[statusCode] != '1') {
+		return false;
+	}
+
+	return buf[statusCode + 1] >= '0' && buf[statusCode + 1] <= '9' && buf[statusCode + 2] >= '0' && buf[statusCode + 2] <= '9' &&
+		   !(buf[statusCode + 1] == '0' && buf[statusCode + 2] == '1');
+}
+
+/**
+ * Track the response side of the connection for a write of @length bytes of @buf: a write starting with a HTTP status line while
+ * requests are pending starts the response of the oldest pending request, i.e. the request boundary of the response. Interim responses
+ * (see isInterimResponse()) are written as they are and leave the request pending for its final response.
+ * @return true if the write is the first one of the current response (i.e. the one holding the status line and header)
+ */
+static inline bool trackResponseWrite(SocketInfo* socketInfo, const char* buf, size_t length) {
+	if (length >= strlen("HTTP/") && memcmp(buf, "HTTP/", strlen("HTTP/")) == 0) {
+		if (isInterimResponse(buf, length)) {
+			return false;
+		}
+
+		if (socketInfo->pendingRequestsCount > 0) {
+			socketInfo->deceivedStatusCode = socketInfo->pendingRequests[socketInfo->pendingRequestsHead];
+			socketInfo->headResponse = (socketInfo->pendingHeadRequests & (1u << socketInfo->pendingRequestsHead)) != 0;
+			socketInfo->pendingRequestsHead = (socketInfo->pendingRequestsHead + 1) % SOCKET_INFO_PENDING_REQUESTS_LENGTH;
+			socketInfo->pendingRequestsCount--;
+			socketInfo->requestTaken = true;
+			socketInfo->socketProgress = 0;
+		}
+	}
+
+	return socketInfo->socketProgress++ == 0;
+}
+
+/**
+ * Undo trackResponseWrite() of the first write of the current response, which failed before any byte of it was sent (e.g. EAGAIN of a
+ * non-blocking socket): the application repeats the write, which has to start the response of the same request again.
+ */
+static inline void untrackResponseWrite(SocketInfo* socketInfo) {
+	if (socketInfo->requestTaken && socketInfo->pendingRequestsCount < SOCKET_INFO_PENDING_REQUESTS_LENGTH) {
+		int index = (socketInfo->pendingRequestsHead + SOCKET_INFO_PENDING_REQUESTS_LENGTH - 1) % SOCKET_INFO_PENDING_REQUESTS_LENGTH;
+		socketInfo->pendingRequests[index] = socketInfo->deceivedStatusCode;
+		if (socketInfo->headResponse) {
+			socketInfo->pendingHeadRequests |= (uint16_t)(1u << index);
+		} else {
+			socketInfo->pendingHeadRequests &= (uint16_t) ~(1u << index);
+		}
+		socketInfo->pendingRequestsHead = index;
+		socketInfo->pendingRequestsCount++;
+	}
+
+	socketInfo->requestTaken = false;
+	socketInfo->socketProgress = 0;
+}
@@ -0,0 +1,147 @@
+// Copyright 2024 Dynatrace LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Portions of this code, as identified in remarks, are provided under the
+// Creative Commons BY-SA 4.0 or the MIT license, and are provided without
+// any warranty. In each of the remarks, we have provided attribution to the
+// original creators and other attribution parties, along with the title of
+// the code (if known) a copyright notice and a link to the license, and a
+// statement indicating whether or not we have modified the code.
+
+#include "SocketInfoPool.h"
+
+#include <stdbool.h>
+#include <stdlib.h>
+
+/**
+ * Allocate a new slab and push all its SocketInfos to the free-list. Has to be called with the pool mutex held.
+ */
+static bool allocateSocketInfoSlab(SocketInfoPool* pool) {
+	SocketInfo* slab = malloc(SOCKET_INFO_SLAB_LENGTH * sizeof(SocketInfo));
+	if (slab == NULL) {
+		return false;
+	}
+
+	for (int i = 0; i < SOCKET_INFO_SLAB_LENGTH; i++) {
+		slab[i].next = pool->freeList;
+		pool->freeList = &(slab[i]);
+	}
+	__atomic_add_fetch(&(pool->allocationCount), 1, __ATOMIC_RELAXED);
+
+	return true;
+}
+
+SocketInfo* acquireSocketInfo(SocketInfoPool* pool) {
+	pthread_mutex_lock(&(pool->mutex));
+
+	if (pool->freeList == NULL && !allocateSocketInfoSlab(pool)) {
+		pthread_mutex_unlock(&(pool->mutex));
+		return NULL;
+	}
+
+	SocketInfo* socketInfo = pool->freeList;
+	pool->freeList = socketInfo->next;
+	__atomic_add_fetch(&(pool->inUseCount), 1, __ATOMIC_RELAXED);
+
+	pthread_mutex_unlock(&(pool->mutex));
+
+	socketInfo->next = NULL;
+	resetSocketInfo(socketInfo);
+
+	return socketInfo;
+}
+
+void releaseSocketInfo(SocketInfoPool* pool, SocketInfo* socketInfo) {
+	releaseHeaderBuffer(pool, socketInfo->headerAccumulator.buffer);
+	initHeaderAccumulator(&(socketInfo->headerAccumulator));
+	releaseBodyInjection(pool, socketInfo->bodyInjection);
+	socketInfo->bodyInjection = NULL;
+	releasePendingOutput(pool, socketInfo->pendingOutput);
+	socketInfo->pendingOutput = NULL;
+
+	pthread_mutex_lock(&(pool->mutex));
+
+	socketInfo->next = pool->freeList;
+	pool->freeList = socketInfo;
+	__atomic_sub_fetch(&(pool->inUseCount), 1, __ATOMIC_RELAXED);
+
+	pthread_mutex_unlock(&(pool->mutex));
+}
+
+/**
+ * Take a buffer of @bufferLength bytes from the free-list @freeBuffers of @pool, allocating a new slab of SOCKET_BUFFER_SLAB_LENGTH
+ * buffers if it is empty.
+ * @return NULL if no slab could be allocated
+ */
+static void* acquireBuffer(SocketInfoPool* pool, void** freeBuffers, size_t bufferLength) {
+	pthread_mutex_lock(&(pool->mutex));
+
+	if (*freeBuffers == NULL) {
+		char* slab = malloc(SOCKET_BUFFER_SLAB_LENGTH * bufferLength);
+		if (slab == NULL) {
+			pthread_mutex_unlock(&(pool->mutex));
+			return NULL;
+		}
+
+		for (int i = 0; i < SOCKET_BUFFER_SLAB_LENGTH; i++) {
+			*(void**)(slab + i * bufferLength) = *freeBuffers;
+			*freeBuffers = slab + i * bufferLength;
+		}
+		__atomic_add_fetch(&(pool->allocationCount), 1, __ATOMIC_RELAXED);
+	}
+
+	void* buffer = *freeBuffers;
+	*freeBuffers = *(void**)buffer;
+
+	pthread_mutex_unlock(&(pool->mutex));
+	return buffer;
+}
+
+/**
+ * Return @buffer (NULL is ignored) to the free-list @freeBuffers of @pool.
+ */
+static void releaseBuffer(SocketInfoPool* pool, void** freeBuffers, void* buffer) {
+	if (buffer == NULL) {
+		return;
+	}
+
+	pthread_mutex_lock(&(pool->mutex));
+	*(void**)buffer = *freeBuffers;
+	*freeBuffers = buffer;
+	pthread_mutex_unlock(&(pool->mutex));
+}
+
+char* acquireHeaderBuffer(SocketInfoPool* pool) {
+	return acquireBuffer(pool, &(pool->freeHeaderBuffers), HEADER_ACCUMULATOR_MAX_LENGTH);
+}
+
+void releaseHeaderBuffer(SocketInfoPool* pool, char* buffer) {
+	releaseBuffer(pool, &(pool->freeHeaderBuffers), buffer);
+}
+
+BodyInjection* acquireBodyInjection(SocketInfoPool* pool) {
+	return acquireBuffer(pool, &(pool->freeBodyInjections), sizeof(BodyInjection));
+}
+
+void releaseBodyInjection(SocketInfoPool* pool, BodyInjection* injection) {
+	releaseBuffer(pool, &(pool->freeBodyInjections), injection);
+}
+
+PendingOutput* acquirePendingOutput(SocketInfoPool* pool) {
+	return acquireBuffer(pool, &(pool->freePendingOutputs), sizeof(PendingOutput));
+}
+
+void releasePendingOutput(SocketInfoPool* pool, PendingOutput* pending) {
+	releaseBuffer(pool, &(pool->freePendingOutputs), pending);
+}
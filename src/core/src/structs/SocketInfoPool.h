@@ -0,0 +1,116 @@
+// Copyright 2024 Dynatrace LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Portions of this code, as identified in remarks, are provided under the
+// Creative Commons BY-SA 4.0 or the MIT license, and are provided without
+// any warranty. In each of the remarks, we have provided attribution to the
+// original creators and other attribution parties, along with the title of
+// the code (if known) a copyright notice and a link to the license, and a
+// statement indicating whether or not we have modified the code.
+
+#pragma once
+
+#include "SocketInfo.h"
+
+#include <pthread.h>
+
+/**
+ * Number of SocketInfos allocated at once when the free-list of the SocketInfoPool is empty.
+ */
+#define SOCKET_INFO_SLAB_LENGTH 64
+
+/**
+ * Number of header buffers, BodyInjections or PendingOutputs allocated at once when their free-list is empty. They are only needed by
+ * the connections whose response is currently rewritten, so their slabs are smaller.
+ */
+#define SOCKET_BUFFER_SLAB_LENGTH 8
+
+/**
+ * Fixed-size slab allocator with a free-list for SocketInfos and for the buffers a SocketInfo needs while its response is rewritten
+ * (HeaderAccumulator buffers, BodyInjections and PendingOutputs). Slabs are never freed: once the pool holds enough of them for the
+ * maximum number of concurrent HTTP connections of the process, the acquire and release functions don't allocate anymore.
+ */
+typedef struct {
+	pthread_mutex_t mutex;
+
+	/**
+	 * SocketInfos that can be handed out without allocating.
+	 */
+	SocketInfo* freeList;
+
+	/**
+	 * Number of slab allocations (malloc calls) of the pool, of all kinds. Stays constant under a sustained load with a steady number of
+	 * concurrent connections. Updated with atomic operations, so it can be read without holding the mutex.
+	 */
+	unsigned long allocationCount;
+
+	/**
+	 * Number of SocketInfos currently handed out. Updated with atomic operations, so it can be read without holding the mutex.
+	 */
+	unsigned long inUseCount;
+
+	/**
+	 * Buffers of HEADER_ACCUMULATOR_MAX_LENGTH bytes, BodyInjections and PendingOutputs that can be handed out without allocating, each
+	 * linked by its first bytes.
+	 */
+	void* freeHeaderBuffers;
+	void* freeBodyInjections;
+	void* freePendingOutputs;
+} SocketInfoPool;
+
+#define SOCKET_INFO_POOL_INITIALIZER {PTHREAD_MUTEX_INITIALIZER, NULL, 0, 0, NULL, NULL, NULL}
+
+/**
+ * Take a reset SocketInfo from the pool, allocating a new slab if the free-list is empty.
+ * @return NULL if no slab could be allocated
+ */
+SocketInfo* acquireSocketInfo(SocketInfoPool* pool);
+
+/**
+ * Return @socketInfo to the free-list of the pool, together with the buffers it holds.
+ */
+void releaseSocketInfo(SocketInfoPool* pool, SocketInfo* socketInfo);
+
+/**
+ * Take a buffer of HEADER_ACCUMULATOR_MAX_LENGTH bytes for the HeaderAccumulator of a SocketInfo.
+ * @return NULL if no slab could be allocated
+ */
+char* acquireHeaderBuffer(SocketInfoPool* pool);
+
+/**
+ * Return @buffer (NULL is ignored) to the pool.
+ */
+void releaseHeaderBuffer(SocketInfoPool* pool, char* buffer);
+
+/**
+ * Take a BodyInjection, to be started with startBodyInjection().
+ * @return NULL if no slab could be allocated
+ */
+BodyInjection* acquireBodyInjection(SocketInfoPool* pool);
+
+/**
+ * Return @injection (NULL is ignored) to the pool.
+ */
+void releaseBodyInjection(SocketInfoPool* pool, BodyInjection* injection);
+
+/**
+ * Take a PendingOutput, to be started with startPendingOutput() or startPendingInsertion().
+ * @return NULL if no slab could be allocated
+ */
+PendingOutput* acquirePendingOutput(SocketInfoPool* pool);
+
+/**
+ * Return @pending (NULL is ignored) to the pool.
+ */
+void releasePendingOutput(SocketInfoPool* pool, PendingOutput* pending);
@@ -21,45 +21,739 @@
 
 #include "SharedLibraries_Default.h"
 
+#include "../../core/src/ByteScan.h"
 #include "../../core/src/HoneBookThread.h"
 #include "../../core/src/Utils.h"
 #include "../../core/src/structs/GlobalVariables.h"
 
+#include <errno.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
 #include <arpa/inet.h>
 #include <stdint.h>
 
+/**
+ * Fast path of the overwritten read/write methods: a single relaxed load of the per-fd classification in globals.fdTable decides if a fd
+ * needs any deception handling. Untraced fds (files, pipes, sockets of not deceived ports) go straight to the original method without
+ * entering the honeywiresBook.
+ */
+static inline bool isTracedFd(int fd) {
+	return isTracedFdState(&(globals.fdTable), fd);
+}
+
+/**
+ * @return the SocketInfo of the traced connection @fd, taken from globals.socketInfoPool when the connection receives its first data, or
+ * NULL if no SocketInfo could be allocated
+ */
+static SocketInfo* connectionSocketInfo(int fd) {
+	FdState* state = fdState(&(globals.fdTable), fd);
+
+	if (state->socketInfo == NULL) {
+		SocketInfoPool* pool = &(globals.socketInfoPool);
+		unsigned long allocationCount = __atomic_load_n(&(pool->allocationCount), __ATOMIC_RELAXED);
+
+		state->socketInfo = acquireSocketInfo(pool);
+
+		// a growing allocation count under a steady load would indicate leaked SocketInfos
+		if (__atomic_load_n(&(pool->allocationCount), __ATOMIC_RELAXED) != allocationCount) {
+			simpleLogger(
+					LoggerPriority__INFO,
+					"  |- SocketInfoPool: slab allocated (allocations: %lu, in use: %lu)\n",
+					__atomic_load_n(&(pool->allocationCount), __ATOMIC_RELAXED),
+					__atomic_load_n(&(pool->inUseCount), __ATOMIC_RELAXED));
+		}
+	}
+
+	return state->socketInfo;
+}
+
+/**
+ * Context of classifyHttpRequestLine() for the bytes of a single read()/recv() call.
+ */
+typedef struct {
+	SocketInfo* socketInfo;
+	const SO_HW_recv* recvModel;
+	const char* methodName;
+	int fd;
+} RequestLineContext;
+
+/**
+ * HttpRequestLineHandler of the traced connections: queue the deceived status code of each received request until its response starts.
+ */
+static bool classifyHttpRequestLine(char* requestLine, int length, bool truncated, void* context) {
+	RequestLineContext* requestLineContext = context;
+	const SO_HW_recv* recvModel = requestLineContext->recvModel;
+	// the response of a HEAD request has no body, even if it has a Content-Length
+	bool headRequest = length >= (int)strlen("HEAD ") && memcmp(requestLine, "HEAD ", strlen("HEAD ")) == 0;
+
+	// the HTTP version of a truncated line is cut off, the request is only tracked to keep requests and responses in order
+	if (truncated) {
+		pushPendingRequest(requestLineContext->socketInfo, 0, headRequest);
+		return true;
+	}
+	if (isSupportedHttpVersion(requestLine, length) == -1) {
+		return false;
+	}
+
+	uint16_t deceivedStatusCode = 0;
+	int matchingPath = recvModel->enabled && recvModel->pathMatcher != NULL ? matchPath(recvModel->pathMatcher, requestLine, length) : -1;
+	if (matchingPath != -1) {
+		deceivedStatusCode = recvModel->matchingPathStatusCodes[matchingPath];
+
+		simpleLogger(
+				LoggerPriority__INFO,
+				" [-] %s(fd: %d) detected path \"%s\"\n",
+				requestLineContext->methodName,
+				requestLineContext->fd,
+				recvModel->matchingPaths[matchingPath]);
+	}
+	pushPendingRequest(requestLineContext->socketInfo, deceivedStatusCode, headRequest);
+
+	return true;
+}
+
+/**
+ * Feed the @bytesRead bytes received by @methodName on the traced connection @fd into the @iovLength segments of @iov to the request parser
+ * of the connection. The segments are parsed in place one after the other, the parser resumes request lines that are split between them.
+ * Every byte has to pass the parser exactly once and in order, so request boundaries are tracked even while the recvModel is disabled.
+ */
+static void trackReceivedRequests(int fd, const struct iovec* iov, int iovLength, size_t bytesRead, const char* methodName) {
+	SO_HW_Model* so_hw_model = readerStart(globals.honeywiresBook);
+	if (so_hw_model == NULL) {
+		return;
+	}
+
+	SocketInfo* socketInfo = connectionSocketInfo(fd);
+	if (socketInfo != NULL) {
+		RequestLineContext context = {socketInfo, so_hw_model->recvModel, methodName, fd};
+
+		for (int i = 0; i < iovLength && bytesRead > 0; i++) {
+			size_t length = iov[i].iov_len < bytesRead ? iov[i].iov_len : bytesRead;
+
+			parseHttpRequests(&(socketInfo->requestParser), iov[i].iov_base, length, classifyHttpRequestLine, &context);
+			bytesRead -= length;
+		}
+	}
+
+	readerFinished(globals.honeywiresBook);
+}
+
+/**
+ * @return index of the supported HTTP version of the status line at the start of the @length bytes of @buf (see statusLineLength() and
+ * isSupportedHttpVersion()), -1 if it isn't supported or doesn't end within @buf
+ */
+static int statusLineHttpVersion(const char* buf, size_t length) {
+	int lineLength = statusLineLength(buf, length);
+
+	return lineLength != -1 ? isSupportedHttpVersion((char*)buf, lineLength) : -1;
+}
+
+/**
+ * Return the BodyInjection of @socketInfo (if any) to globals.socketInfoPool, e.g. once its decoy is inserted.
+ */
+static void dropBodyInjection(SocketInfo* socketInfo) {
+	releaseBodyInjection(&(globals.socketInfoPool), socketInfo->bodyInjection);
+	socketInfo->bodyInjection = NULL;
+}
+
+/**
+ * Return the PendingOutput of @socketInfo (if any) to globals.socketInfoPool, e.g. once nothing of the response is pending anymore.
+ */
+static void dropPendingOutput(SocketInfo* socketInfo) {
+	releasePendingOutput(&(globals.socketInfoPool), socketInfo->pendingOutput);
+	socketInfo->pendingOutput = NULL;
+}
+
+/**
+ * Take a buffer from globals.socketInfoPool for the HeaderAccumulator of @socketInfo, unless it has one already. It is kept until the
+ * connection is closed (see releaseSocketInfo()).
+ * @return the HeaderAccumulator of @socketInfo, it holds no bytes if no buffer could be allocated
+ */
+static HeaderAccumulator* attachHeaderBuffer(SocketInfo* socketInfo) {
+	HeaderAccumulator* accumulator = &(socketInfo->headerAccumulator);
+
+	if (accumulator->buffer == NULL) {
+		accumulator->buffer = acquireHeaderBuffer(&(globals.socketInfoPool));
+	}
+	return accumulator;
+}
+
+/**
+ * Splice the deceived status code of the current response of @socketInfo into @rewrite and run the response program of @sendModel on it.
+ * Starts the BodyInjection of @socketInfo if the program inserts a decoy into the body of the response (see
+ * startResponseBodyInjection()), the body itself is rewritten by sendResponse().
+ */
+static void rewriteResponse(
+		const SO_HW_send* sendModel, SocketInfo* socketInfo, int httpVersion, ResponseRewrite* rewrite, const char* methodName) {
+	const ResponseProgram* program = sendModel->responseProgram;
+
+	if (program->replaceStatusCode && socketInfo != NULL && socketInfo->deceivedStatusCode != 0) {
+		char statusCodeResponse[sizeof("65535")];
+		snprintf(statusCodeResponse, sizeof(statusCodeResponse), "%u", socketInfo->deceivedStatusCode);
+
+		if (overWriteStatusCode(rewrite, globals.SUPPORTED_HTTP_VERSIONS[httpVersion], statusCodeResponse)) {
+			simpleLogger(LoggerPriority__INFO, "  |+ %s: status code was overwrite\n", methodName);
+		} else {
+			simpleLogger(
+					LoggerPriority__INFO, "  !-- %s(): error while generating new status code! Original status code will be sent.\n", methodName);
+		}
+	}
+
+	ResponseInstruction contentLength = {0};
+	char contentLengthValue[CONTENT_LENGTH_VALUE_LENGTH];
+	int overridesLength = 0;
+	if (socketInfo != NULL) {
+		// left over by a flush of the held back header that failed before sending (the application repeats it)
+		dropBodyInjection(socketInfo);
+
+		socketInfo->bodyInjection = startResponseBodyInjection(
+				program, rewrite->original, rewrite->originalLength, socketInfo->headResponse, &contentLength, contentLengthValue);
+		if (socketInfo->bodyInjection != NULL) {
+			simpleLogger(LoggerPriority__INFO, "  |+ %s: insert the decoy into the body of the response\n", methodName);
+			overridesLength = socketInfo->bodyInjection->framing == BodyFraming__CONTENT_LENGTH ? 1 : 0;
+		}
+	}
+
+	// the decoy would overrun the announced length of the body if the Content-Length isn't replaced
+	if (!runResponseProgram(program, &contentLength, overridesLength, rewrite) && socketInfo != NULL && socketInfo->bodyInjection != NULL) {
+		simpleLogger(LoggerPriority__INFO, "  !-- %s(): can't replace the Content-Length, the body is sent without decoy\n", methodName);
+		dropBodyInjection(socketInfo);
+	}
+}
+
+/**
+ * Send the segments of @rewrite on the stream socket @fd with sendmsg(), so the response of the application is never copied. Stops once no
+ * replacement is left (see hasUnsentReplacements()) or once the socket doesn't take more bytes (e.g. EAGAIN of a non-blocking socket).
+ * @return bytes of the original buffer the application has to consider as sent, -1 if none (errno is kept, EAGAIN if only replacements
+ * are sent)
+ */
+static ssize_t sendRewrittenResponse(int fd, ResponseRewrite* rewrite, int flags) {
+	while (hasUnsentReplacements(rewrite)) {
+		struct msghdr message = {0};
+		message.msg_iov = rewrite->segments + rewrite->sentSegments;
+		message.msg_iovlen = rewrite->segmentsLength - rewrite->sentSegments;
+
+		ssize_t sent = globals.originalSharedLibraryMethods.sendmsg_global(fd, &message, flags);
+
+		if (sent >= 0) {
+			advanceResponseRewrite(rewrite, sent);
+		} else if (errno != EINTR) {
+			return rewrite->consumedLength > 0 ? (ssize_t)rewrite->consumedLength : -1;
+		}
+	}
+
+	if (rewrite->consumedLength == 0 && rewrite->originalLength > 0) {
+		errno = EAGAIN;
+		return -1;
+	}
+	return rewrite->consumedLength;
+}
+
+/**
+ * Shut the traced connection @fd down, since the rest of its response can't be kept (see keepPendingOutput()) and can't be sent without
+ * blocking the caller, rather than sending a corrupted response. @sent is the result of sending the call of the application.
+ * @return @sent, -1 if nothing is sent (errno is ENOBUFS)
+ */
+static ssize_t shutDownResponse(int fd, SocketInfo* socketInfo, ssize_t sent) {
+	dropPendingOutput(socketInfo);
+	shutdown(fd, SHUT_RDWR);
+
+	if (sent <= 0) {
+		errno = ENOBUFS;
+		return -1;
+	}
+	return sent;
+}
+
+/**
+ * Keep the replacements of @rewrite that aren't sent as PendingOutput of @socketInfo, which is resumed by the next call of the application
+ * instead of blocking the caller until the socket takes them. @sent is the result of sending @rewrite, whose first @resumed splices are
+ * those of the PendingOutput, for a call of @callLength bytes. If no PendingOutput can be allocated or the rest of the response exceeds it,
+ * the connection is shut down (see shutDownResponse()).
+ * @return bytes of the original buffer the application has to consider as sent, -1 if none (errno is kept)
+ */
+static ssize_t keepPendingOutput(int fd, SocketInfo* socketInfo, ResponseRewrite* rewrite, int resumed, ssize_t sent, size_t callLength) {
+	if (socketInfo->pendingOutput == NULL) {
+		socketInfo->pendingOutput = acquirePendingOutput(&(globals.socketInfoPool));
+
+		if (socketInfo->pendingOutput == NULL) {
+			simpleLogger(
+					LoggerPriority__ERROR, "  !-- keepPendingOutput(): can't allocate the pending output of sockfd %d, shut it down!\n", fd);
+			return shutDownResponse(fd, socketInfo, sent);
+		}
+		startPendingOutput(socketInfo->pendingOutput, rewrite->originalLength);
+		simpleLogger(LoggerPriority__INFO, "  |+ the rest of the response of sockfd %d is pending until the next call\n", fd);
+	}
+
+	int error = errno;
+	size_t reported;
+	if (!savePendingOutput(socketInfo->pendingOutput, rewrite, resumed, sent > 0 ? sent : 0, &reported)) {
+		simpleLogger(LoggerPriority__ERROR, "  !-- keepPendingOutput(): the rest of the response of sockfd %d overflows, shut down!\n", fd);
+		return shutDownResponse(fd, socketInfo, sent);
+	}
+	if (isPendingOutputDone(socketInfo->pendingOutput)) {
+		dropPendingOutput(socketInfo);
+	}
+
+	// e.g. only the pending rest of a flushed header is sent in front of the call (see flushHeldHeader())
+	if (reported == 0 && callLength > 0) {
+		errno = sent == -1 ? error : EAGAIN;
+		return -1;
+	}
+	return reported;
+}
+
+/**
+ * Send the response bytes of @rewrite on the traced stream socket @fd. A pending output of @socketInfo is resumed with them, otherwise
+ * the pending BodyInjection of @socketInfo is spliced into them and advanced by the bytes the application has to consider as sent, it is
+ * freed once it is done.
+ * @return bytes of the original buffer that are sent, -1 on error (errno is kept)
+ */
+static ssize_t sendResponse(int fd, SocketInfo* socketInfo, ResponseRewrite* rewrite, int flags) {
+	bool resuming = socketInfo != NULL && socketInfo->pendingOutput != NULL;
+	BodyInjection* injection = socketInfo != NULL && !resuming ? socketInfo->bodyInjection : NULL;
+	BodyInjectionState previousState;
+	int resumed = 0;
+	size_t callLength = rewrite->originalLength;
+
+	if (resuming) {
+		// the pending bytes were passed by the BodyInjection when they were rewritten at first
+		resumed = resumePendingOutput(socketInfo->pendingOutput, rewrite);
+	} else if (injection != NULL) {
+		previousState = injection->state;
+		rewriteResponseBody(injection, rewrite);
+	}
+
+	// the BodyInjection or the PendingOutput can leave a part of the buffer to the next call of the application (short write)
+	size_t length = rewrite->originalLength;
+	ssize_t sent;
+	if (finishResponseRewrite(rewrite)) {
+		sent = sendRewrittenResponse(fd, rewrite, flags);
+	} else {
+		sent = globals.originalSharedLibraryMethods.send_global(fd, rewrite->original, length, flags);
+	}
+
+	// the replacements that aren't sent are resumed by the next call of the application, which repeats the rest of the buffer
+	if (resuming || (rewrite->sentLength > 0 && hasUnsentReplacements(rewrite))) {
+		// nothing is sent, the application repeats the call
+		if (sent == -1 && rewrite->sentLength == 0) {
+			return -1;
+		}
+		sent = keepPendingOutput(fd, socketInfo, rewrite, resumed, sent, callLength);
+
+		// the BodyInjection already passed the bytes of the pending output
+		if (injection != NULL && socketInfo->pendingOutput != NULL) {
+			injection = NULL;
+		}
+	}
+
+	if (injection != NULL) {
+		// the application repeats the bytes that aren't sent, so only the sent ones are passed
+		if (sent != (ssize_t)length) {
+			injection->state = previousState;
+
+			if (sent > 0) {
+				advanceResponseBody(injection, rewrite->original, sent);
+			}
+		}
+		if (isBodyInjectionDone(injection)) {
+			dropBodyInjection(socketInfo);
+		}
+	}
+
+	return sent;
+}
+
+/**
+ * Undo the start of the current response of @socketInfo by its first write, which failed before any byte was sent (e.g. EAGAIN of a
+ * non-blocking socket): the application repeats the write, which starts the response of the same request and its BodyInjection again.
+ */
+static void restartResponse(SocketInfo* socketInfo) {
+	untrackResponseWrite(socketInfo);
+	dropBodyInjection(socketInfo);
+}
+
+/**
+ * Send @count bytes of @buf that continue the current response of @socketInfo, whose PendingOutput or BodyInjection is pending, on the
+ * traced stream socket @fd.
+ * @return bytes of @buf that are sent, -1 on error (errno is kept)
+ */
+static ssize_t sendPendingResponse(int fd, SocketInfo* socketInfo, const void* buf, size_t count, int flags) {
+	ResponseRewrite rewrite;
+	initResponseRewrite(&rewrite, buf, count);
+
+	return sendResponse(fd, socketInfo, &rewrite, flags);
+}
+
+/**
+ * @return true if the next write of the application continues a response of @socketInfo that is rewritten (see sendPendingResponse())
+ */
+static inline bool isResponsePending(const SocketInfo* socketInfo) {
+	return socketInfo != NULL && (socketInfo->pendingOutput != NULL || socketInfo->bodyInjection != NULL);
+}
+
+/**
+ * Send the @iovLength segments of @iov without their first @skippedLength bytes, which continue the current response of @socketInfo, on
+ * the traced stream socket @fd: while its PendingOutput or BodyInjection is pending, the segments are rewritten one after the other like
+ * consecutive calls of the application (ResponseRewrite addresses a single buffer), with MSG_MORE in front of the last one, so the peer
+ * still gets full packets. The remaining segments are sent as they are with a single sendmsg(). Only a socket that doesn't take more bytes
+ * (e.g. EAGAIN of a non-blocking socket) leaves the rest to the application (short write). The rewritten segments are copies of the
+ * replacements that don't outlive the call, so they can't be sent with MSG_ZEROCOPY.
+ * @return bytes of @iov behind @skippedLength that are sent, -1 on error (errno is kept)
+ */
+static ssize_t sendResponseSegments(
+		int fd, SocketInfo* socketInfo, const struct iovec* iov, int iovLength, size_t skippedLength, int flags) {
+	flags &= ~MSG_ZEROCOPY;
+
+	int lastIndex = iovLength - 1;
+	while (lastIndex >= 0 && iov[lastIndex].iov_len == 0) {
+		lastIndex--;
+	}
+
+	size_t sentLength = 0;
+	int index = 0;
+	size_t offset = 0;
+	size_t advance = skippedLength;
+	for (;;) {
+		// the position moves past the skipped or sent bytes and the empty segments
+		for (; index <= lastIndex && offset + advance >= iov[index].iov_len; index++) {
+			advance -= iov[index].iov_len - offset;
+			offset = 0;
+		}
+		if (index > lastIndex) {
+			return sentLength;
+		}
+		offset += advance;
+
+		ssize_t sent;
+		int segmentFlags = index < lastIndex ? flags | MSG_MORE : flags;
+		if (isResponsePending(socketInfo)) {
+			sent = sendPendingResponse(fd, socketInfo, (char*)iov[index].iov_base + offset, iov[index].iov_len - offset, segmentFlags);
+		} else if (offset > 0) {
+			sent = globals.originalSharedLibraryMethods.send_global(
+					fd, (char*)iov[index].iov_base + offset, iov[index].iov_len - offset, segmentFlags);
+		} else {
+			struct msghdr message = {0};
+			message.msg_iov = (struct iovec*)(iov + index);
+			message.msg_iovlen = lastIndex + 1 - index;
+			sent = globals.originalSharedLibraryMethods.sendmsg_global(fd, &message, flags);
+		}
+
+		if (sent <= 0) {
+			return sentLength > 0 ? (ssize_t)sentLength : sent;
+		}
+		sentLength += sent;
+		advance = sent;
+	}
+}
+
+/**
+ * Send the rest of the @count bytes of @buf behind the @sentLength bytes sent by the first sendResponse() of a write() or send(), e.g. the
+ * part of the body that the BodyInjection left to the next call, with sendResponseSegments().
+ * @return bytes of the rest that are sent, 0 if the socket doesn't take more bytes
+ */
+static size_t sendResponseRest(int fd, SocketInfo* socketInfo, const void* buf, size_t count, size_t sentLength, int flags) {
+	struct iovec segment = {(void*)buf, count};
+	ssize_t sent = sendResponseSegments(fd, socketInfo, &segment, 1, sentLength, flags);
+
+	return sent > 0 ? sent : 0;
+}
+
+/**
+ * Maximal number of segments of the application sent together with a flushed header, the caller sends further segments with
+ * sendResponseSegments().
+ */
+#define HELD_HEADER_REST_MAX_SEGMENTS 64
+
+/**
+ * Send the header held back by @socketInfo, rewritten with @sendModel, together with the @restLength segments of @rest (the segments of
+ * the current call behind the header, the first one starting @restOffset bytes into it) in a single vectored write. The held bytes are
+ * already reported as written to the application (except for the @heldLength bytes of the current call), so they are sent completely:
+ * if the socket doesn't take all of them (e.g. EAGAIN of a non-blocking socket), the rest is kept as PendingOutput of @socketInfo, which
+ * is sent in place of the last held byte of the current call once the application repeats it (or in front of its next call if none of
+ * the held bytes belong to the current call). Finishes the reader of globals.honeywiresBook before sending. If the response starts a
+ * BodyInjection, @rest is left to the caller, which rewrites it as body.
+ * @return bytes of the current call that are sent or held, -1 on error (errno is kept), the header is still held if the error occurred
+ * before any byte is sent
+ */
+static ssize_t flushHeldHeader(
+		int fd,
+		SocketInfo* socketInfo,
+		const SO_HW_send* sendModel,
+		size_t heldLength,
+		const struct iovec* rest,
+		int restLength,
+		size_t restOffset,
+		int flags,
+		const char* methodName) {
+	HeaderAccumulator* accumulator = &(socketInfo->headerAccumulator);
+
+	// nothing is held if the buffer of the HeaderAccumulator couldn't be allocated
+	int httpVersion = accumulator->length > 0 ? statusLineHttpVersion(accumulator->buffer, accumulator->length) : -1;
+
+	ResponseRewrite rewrite;
+	initResponseRewrite(&rewrite, accumulator->buffer, accumulator->length);
+	bool rewritten = false;
+	if (sendModel->enabled && httpVersion != -1) {
+		rewriteResponse(sendModel, socketInfo, httpVersion, &rewrite, methodName);
+
+		// the held bytes end with the header block, i.e. they are only passed by the BodyInjection (or get a decoy as empty body)
+		if (socketInfo->bodyInjection != NULL) {
+			rewriteResponseBody(socketInfo->bodyInjection, &rewrite);
+			restLength = 0;
+		}
+		rewritten = finishResponseRewrite(&rewrite);
+	}
+
+	// the rewrite holds copies of the replacements, so the snapshot isn't needed while the send is running
+	readerFinished(globals.honeywiresBook);
+
+	struct iovec segments[RESPONSE_REWRITE_MAX_SEGMENTS + HELD_HEADER_REST_MAX_SEGMENTS];
+	int headerSegmentsLength = 0;
+	size_t headerLength = 0;
+	if (rewritten) {
+		for (; headerSegmentsLength < rewrite.segmentsLength; headerSegmentsLength++) {
+			segments[headerSegmentsLength] = rewrite.segments[headerSegmentsLength];
+			headerLength += rewrite.segments[headerSegmentsLength].iov_len;
+		}
+	} else if (accumulator->length > 0) {
+		segments[headerSegmentsLength++] = (struct iovec){accumulator->buffer, accumulator->length};
+		headerLength = accumulator->length;
+	}
+	int segmentsLength = headerSegmentsLength;
+	for (int i = 0; i < restLength && i < HELD_HEADER_REST_MAX_SEGMENTS; i++) {
+		size_t skipped = i == 0 ? restOffset : 0;
+
+		if (rest[i].iov_len > skipped) {
+			segments[segmentsLength++] = (struct iovec){(char*)rest[i].iov_base + skipped, rest[i].iov_len - skipped};
+		}
+	}
+
+	struct iovec* unsent = segments;
+	size_t sentLength = 0;
+	do {
+		struct msghdr message = {0};
+		message.msg_iov = unsent;
+		message.msg_iovlen = segmentsLength - (unsent - segments);
+
+		ssize_t sent = globals.originalSharedLibraryMethods.sendmsg_global(fd, &message, flags);
+
+		if (sent >= 0) {
+			sentLength += sent;
+
+			for (; sent > 0 && (size_t)sent >= unsent->iov_len; unsent++) {
+				sent -= unsent->iov_len;
+			}
+			if (sent > 0) {
+				unsent->iov_base = (char*)unsent->iov_base + sent;
+				unsent->iov_len -= sent;
+			}
+		} else if (sentLength == 0) {
+			// nothing is sent yet, so the header is still held and the application repeats the call
+			return -1;
+		} else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+			// the application waits for the socket itself instead of being blocked here, it repeats the last held byte
+			size_t replacedLength = heldLength > 0 ? 1 : 0;
+			socketInfo->pendingOutput = acquirePendingOutput(&(globals.socketInfoPool));
+			if (socketInfo->pendingOutput != NULL &&
+				!startPendingInsertion(socketInfo->pendingOutput, unsent, headerSegmentsLength - (unsent - segments), replacedLength)) {
+				dropPendingOutput(socketInfo);
+			}
+			accumulator->length = 0;
+
+			if (socketInfo->pendingOutput == NULL) {
+				simpleLogger(LoggerPriority__ERROR, "  !-- flushHeldHeader(): can't keep the rest of the header of sockfd %d!\n", fd);
+				replacedLength = 0;
+			}
+			if (heldLength == replacedLength) {
+				errno = EAGAIN;
+				return -1;
+			}
+			return heldLength - replacedLength;
+		} else if (errno != EINTR) {
+			accumulator->length = 0;
+			return -1;
+		}
+	} while (sentLength < headerLength);
+
+	accumulator->length = 0;
+
+	return heldLength + (sentLength - headerLength);
+}
+
+/**
+ * Add the @iovLength segments of @iov written by @methodName to the header held back by @socketInfo, up to the end of the header block.
+ * Once the end of the header block is written or the HeaderAccumulator is exhausted, the header is flushed together with the rest of the
+ * segments (see flushHeldHeader()), so only the bytes of the header are copied. Finishes the reader of globals.honeywiresBook.
+ * @return bytes of @iov that are sent or held, -1 on error (errno is kept)
+ */
+static ssize_t writeHeldHeader(
+		int fd, SocketInfo* socketInfo, const SO_HW_send* sendModel, const struct iovec* iov, int iovLength, int flags, const char* methodName) {
+	HeaderAccumulator* accumulator = attachHeaderBuffer(socketInfo);
+	size_t previousLength = accumulator->length;
+	const char* headerEnd = NULL;
+
+	// position behind the held bytes within the segments
+	int index = 0;
+	size_t offset = 0;
+	while (index < iovLength) {
+		// the end of the header block can be split between two segments or writes
+		size_t searchStart = accumulator->length > strlen(HEADER_BLOCK_END) ? accumulator->length - strlen(HEADER_BLOCK_END) + 1 : 0;
+		size_t held = holdHeaderBytes(accumulator, iov[index].iov_base, iov[index].iov_len);
+
+		headerEnd = findSubstring(
+				accumulator->buffer + searchStart, accumulator->length - searchStart, HEADER_BLOCK_END, strlen(HEADER_BLOCK_END));
+
+		if (headerEnd != NULL) {
+			// the bytes behind the header block are sent from the segment
+			size_t headerLength = headerEnd + strlen(HEADER_BLOCK_END) - accumulator->buffer;
+			offset = held - (accumulator->length - headerLength);
+			accumulator->length = headerLength;
+			break;
+		}
+		if (held < iov[index].iov_len) {
+			offset = held;
+			break;
+		}
+
+		index++;
+	}
+
+	size_t heldLength = accumulator->length - previousLength;
+	if (headerEnd == NULL && index == iovLength && !isHeaderAccumulatorExhausted(accumulator)) {
+		readerFinished(globals.honeywiresBook);
+		return heldLength;
+	}
+
+	ssize_t sent = flushHeldHeader(fd, socketInfo, sendModel, heldLength, iov + index, iovLength - index, offset, flags, methodName);
+	if (sent == -1) {
+		if (isHoldingHeader(accumulator)) {
+			// the application repeats the call with the bytes that are held again
+			accumulator->length = previousLength;
+
+			if (previousLength == 0) {
+				restartResponse(socketInfo);
+			}
+		}
+		return -1;
+	}
+
+	// the segments behind the sent bytes (e.g. a body that gets a decoy) follow like a repeated call of the application
+	ssize_t restSent = sendResponseSegments(fd, socketInfo, iov, iovLength, sent, flags);
+	if (restSent == -1 && sent == 0) {
+		return -1;
+	}
+	return sent + (restSent > 0 ? restSent : 0);
+}
+
+/**
+ * @return true if rewriteResponse() can change the response of @socketInfo whose status line is tracked already: a deceived status code,
+ * header instructions or a decoy for the body. The header of other responses is never held back.
+ */
+static bool hasResponseRewrite(const SO_HW_send* sendModel, const SocketInfo* socketInfo) {
+	const ResponseProgram* program = sendModel->responseProgram;
+
+	return (program->replaceStatusCode && socketInfo->deceivedStatusCode != 0) || program->instructionsLength > 0 ||
+		   program->insertedHeaders != NULL || (program->bodyValue != NULL && !socketInfo->headResponse);
+}
+
+/**
+ * Start holding back the header of the response of @socketInfo if its first write() / send() of @count bytes of @buf doesn't contain the
+ * end of the header block, e.g. servers that write the status line and each header attribute on their own. Only a header that is
+ * rewritten is held, since a held header only reaches the peer with the next call of the application (see HEADER_ACCUMULATOR_TIMEOUT_MS).
+ * @return true if @buf is held
+ */
+static bool holdResponseHeader(const SO_HW_send* sendModel, SocketInfo* socketInfo, const void* buf, size_t count) {
+	if (socketInfo == NULL || !hasResponseRewrite(sendModel, socketInfo) || count < strlen(HTTP_VERSION_PREFIX) ||
+		count >= HEADER_ACCUMULATOR_MAX_LENGTH ||
+		memcmp(buf, HTTP_VERSION_PREFIX, strlen(HTTP_VERSION_PREFIX)) != 0 ||
+		findSubstring(buf, count, HEADER_BLOCK_END, strlen(HEADER_BLOCK_END)) != NULL) {
+		return false;
+	}
+
+	return holdHeaderBytes(attachHeaderBuffer(socketInfo), buf, count) == count;
+}
+
+/**
+ * Flush the header held back for the traced connection @fd before @methodName waits for the peer or closes the connection, since a
+ * header whose end isn't written yet would never reach the peer otherwise.
+ */
+static void flushHeldHeaderOf(int fd, const char* methodName) {
+	SocketInfo* socketInfo = fdState(&(globals.fdTable), fd)->socketInfo;
+	if (socketInfo == NULL || !isHoldingHeader(&(socketInfo->headerAccumulator))) {
+		return;
+	}
+
+	SO_HW_Model* so_hw_model = readerStart(globals.honeywiresBook);
+	if (so_hw_model == NULL) {
+		return;
+	}
+
+	simpleLogger(LoggerPriority__INFO, "  |+ %s: flush the held back header of sockfd %d\n", methodName, fd);
+
+	// the application doesn't write at the moment, so a closed peer mustn't raise SIGPIPE
+	flushHeldHeader(fd, socketInfo, so_hw_model->sendModel, 0, NULL, 0, 0, MSG_NOSIGNAL, methodName);
+}
+
+/**
+ * Append the rest of the body injection of the traced connection @fd in front of closing it, i.e. the decoy of a close delimited body
+ * whose anchor didn't occur (see finishResponseBody()). It's written only behind the whole output of the application and without waiting
+ * for the peer.
+ */
+static void finishResponseBodyOf(int fd) {
+	SocketInfo* socketInfo = fdState(&(globals.fdTable), fd)->socketInfo;
+	if (socketInfo == NULL || socketInfo->bodyInjection == NULL || socketInfo->pendingOutput != NULL ||
+			isHoldingHeader(&(socketInfo->headerAccumulator))) {
+		return;
+	}
+
+	const char* rest;
+	size_t restLength = finishResponseBody(socketInfo->bodyInjection, &rest);
+	if (restLength > 0) {
+		simpleLogger(LoggerPriority__INFO, "  |+ close: append the decoy to the body of sockfd %d\n", fd);
+		globals.originalSharedLibraryMethods.send_global(fd, rest, restLength, MSG_DONTWAIT | MSG_NOSIGNAL);
+	}
+}
+
 int bind_default(int sockfd, const struct sockaddr* address, socklen_t address_len) {
 	int success = globals.originalSharedLibraryMethods.bind_global(sockfd, address, address_len);
 
-	// no increaseReader() needed, since bind() will not interact with globals.honeywiresBook.honeywiresConfig
+	// no readerStart() needed, since bind() will not interact with globals.honeywiresBook.so_hw_model
 
 	// filter out non-ipv4 request
-	if (globals.honeywiresBook != NULL && sockfd < SOCKET_FD_LIMIT && success == 0 && address != NULL && isIp(address->sa_family)) {
+	if (success == 0 && address != NULL && isIp(address->sa_family)) {
 		struct sockaddr_in* address_in = (struct sockaddr_in*)address;
 		unsigned short port = htons(address_in->sin_port);
 
 		simpleLogger(LoggerPriority__INFO, " [-] bind(socketFd: %d, port %d) \n", sockfd, port);
 
-		if (globals.socketFdTracing == -1 && isSupportedPort(port)) {
-			simpleLogger(LoggerPriority__INFO, "  |- bind -> socketFdTracing is set to: %d\n", sockfd);
-
-			globals.socketFdTracing = sockfd;
-		}
+		trackBoundSocket(sockfd, port, "bind");
 	}
 
 	return success;
 }
 
 int accept_default(int socket, struct sockaddr* restrict address, socklen_t* restrict address_len) {
-	if (globals.honeywiresBook != NULL && globals.honeywiresBook->so_hw_model->accept4Model->enabled) {
-		simpleLogger(LoggerPriority__INFO, " [>] accept() -> forward to accept4()\n");
+	// guards clauses: only connections accepted on listening sockets of deceived ports are traced
+	if (listenerDeceivedPort(&(globals.fdTable), socket) == 0) {
+		return globals.originalSharedLibraryMethods.accept_global(socket, address, address_len);
+	}
+
+	SO_HW_Model* so_hw_model = readerStart(globals.honeywiresBook);
+
+	if (so_hw_model != NULL) {
+		bool accept4Enabled = so_hw_model->accept4Model->enabled;
+		readerFinished(globals.honeywiresBook);
+
+		if (accept4Enabled) {
+			simpleLogger(LoggerPriority__INFO, " [>] accept() -> forward to accept4()\n");
 
-		return accept4_default(socket, address, address_len, 0);
+			return accept4_default(socket, address, address_len, 0);
+		}
 	}
 
 	return globals.originalSharedLibraryMethods.accept_global(socket, address, address_len);
@@ -68,24 +762,43 @@ int accept_default(int socket, struct sockaddr* restrict address, socklen_t* res
 int accept4_default(int sockfd, struct sockaddr* address, socklen_t* addrlen, int flags) {
 	int newSockfd = globals.originalSharedLibraryMethods.accept4_global(sockfd, address, addrlen, flags);
 
-	// guards clauses: check if deception is active and currently possible for this process
-	if (!checkFlagAndIncreaseReader(globals.honeywiresBook, globals.honeywiresBook->so_hw_model->accept4Model->enabled)) {
+	// guards clauses: only connections accepted on listening sockets of deceived ports are traced, a single lookup for any number of them
+	uint8_t deceivedPort = newSockfd >= 0 ? listenerDeceivedPort(&(globals.fdTable), sockfd) : 0;
+	if (deceivedPort == 0) {
 		return newSockfd;
 	}
 
-	// if (newSockfdPort will be an open IPv4 connection and is within the socketTracedToPort.length (= SOCKET_FD_LIMIT))
-	if (sockfd < SOCKET_FD_LIMIT && newSockfd < SOCKET_FD_LIMIT && address != NULL && isIp(address->sa_family)) {
+	// guards clauses: check if deception is active for this process
+	SO_HW_Model* so_hw_model = readerStart(globals.honeywiresBook);
+	if (so_hw_model == NULL) {
+		return newSockfd;
+	}
+	if (!so_hw_model->accept4Model->enabled) {
+		readerFinished(globals.honeywiresBook);
+		return newSockfd;
+	}
+
+	// if (newSockfdPort will be an open IPv4 connection)
+	if (address != NULL && isIp(address->sa_family)) {
 		struct sockaddr_in* address_in = (struct sockaddr_in*)address;
 		unsigned short newSockfdPort = htons(address_in->sin_port);
 
 		// valid port
-		if (newSockfdPort > 1 && sockfd == globals.socketFdTracing) {
-			globals.socketTracedToPort[newSockfd] = 1;
+		if (newSockfdPort > 1) {
+			int type = SOCK_STREAM;
+			socklen_t olen = sizeof(type);
+			getsockopt(newSockfd, SOL_SOCKET, SO_TYPE, &type, &olen);
+
+			SocketInfo* staleSocketInfo = traceFdState(&(globals.fdTable), newSockfd, type, deceivedPort);
+			if (staleSocketInfo != NULL) {
+				releaseSocketInfo(&(globals.socketInfoPool), staleSocketInfo);
+			}
 			simpleLogger(
 					LoggerPriority__INFO,
-					" [-] accept4: new relevant request detected on newSockFd: %d (linked to sockfd %d) \n",
+					" [-] accept4: new relevant request detected on newSockFd: %d (linked to sockfd %d, port %u) \n",
 					newSockfd,
-					sockfd);
+					sockfd,
+					globals.DECEIVED_PORTS[deceivedPort - 1]);
 		}
 	}
 
@@ -96,84 +809,92 @@ int accept4_default(int sockfd, struct sockaddr* address, socklen_t* addrlen, in
 int getsockname_default(int socket, struct sockaddr* restrict address, socklen_t* restrict address_len) {
 	int success = globals.originalSharedLibraryMethods.getsockname_global(socket, address, address_len);
 
-	// no increaseReader() needed, since getsockname() will not interact with globals.honeywiresBook.honeywiresConfig
+	// no readerStart() needed, since getsockname() will not interact with globals.honeywiresBook.so_hw_model
 
-	if (socket < SOCKET_FD_LIMIT && success == 0 && isIp(address->sa_family)) {
+	if (success == 0 && isIp(address->sa_family)) {
 		struct sockaddr_in* address_in = (struct sockaddr_in*)address;
 		unsigned short port = htons(address_in->sin_port);
 
-		if (globals.socketFdTracing == -1 && isSupportedPort(port)) {
-			globals.socketFdTracing = socket; // initial main python process socket which can be linked to all
-											  // incoming request though accept
-
-			simpleLogger(LoggerPriority__INFO, "  |- getsockname -> socketFdTracing is set to: %d\n", socket);
-		}
+		// e.g. the listening socket of python, which can be bound before the deception is active
+		trackBoundSocket(socket, port, "getsockname");
 	}
 
 	return success;
 }
 
 ssize_t read_default(int fd, void* buf, size_t count) {
+	if (isTracedFd(fd)) {
+		flushHeldHeaderOf(fd, "read");
+	}
+
 	ssize_t bytesRead = globals.originalSharedLibraryMethods.read_global(fd, buf, count);
 
-	// check if deception is active and currently possible for this process
-	if (!checkFlagAndIncreaseReader(globals.honeywiresBook, globals.honeywiresBook->so_hw_model->recvModel->enabled)) {
+	// guards clauses: only traced sockets that received data are relevant
+	if (bytesRead <= 0 || !isTracedFd(fd)) {
 		return bytesRead;
 	}
 
-	if (fd < SOCKET_FD_LIMIT && globals.socketTracedToPort[fd] != 0) {
-		if (isSupportedHttpVersion(buf, count)) {
-			SocketInfo* newSocketInfo = malloc(sizeof(SocketInfo));
-			newSocketInfo->requestMode = NONE;
-			newSocketInfo->socketProgress = 0;
-			globals.socketInfos[fd] = newSocketInfo;
+	struct iovec segment = {buf, bytesRead};
+	trackReceivedRequests(fd, &segment, 1, bytesRead, "read");
 
-			if (isSupportedHttpVersionAndMatchingPath(buf, count)) {
-				newSocketInfo->requestMode = ADMIN_PATH;
+	return bytesRead;
+}
+
+ssize_t write_default(int fd, const void* buf, size_t count) {
+	// guards clauses: check if deception is relevant for this fd
+	if (!isTracedFd(fd)) {
+		return globals.originalSharedLibraryMethods.write_global(fd, buf, count);
+	}
 
-				globals.socketInfos[fd] = newSocketInfo;
+	// guards clauses: check if deception is active for this process
+	SO_HW_Model* so_hw_model = readerStart(globals.honeywiresBook);
+	if (so_hw_model == NULL) {
+		return globals.originalSharedLibraryMethods.write_global(fd, buf, count);
+	}
 
-				simpleLogger(
-						LoggerPriority__INFO,
-						" [-] read(fd: %d, buf-length %zu, bytesRead: %zd) detected path \"%s\"\n",
-						fd,
-						count,
-						bytesRead,
-						globals.honeywiresBook->so_hw_model->recvModel->matchingPathString);
-			}
-		}
+	// the header of the current response is written with several write() calls (even if the sendModel got disabled meanwhile)
+	FdState* state = fdState(&(globals.fdTable), fd);
+	SocketInfo* socketInfo = state->socketInfo;
+	if (socketInfo != NULL && isHoldingHeader(&(socketInfo->headerAccumulator))) {
+		struct iovec segment = {(void*)buf, count};
+		return writeHeldHeader(fd, socketInfo, so_hw_model->sendModel, &segment, 1, 0, "write");
 	}
 
-	readerFinished(globals.honeywiresBook);
-	return bytesRead;
-}
+	// the current response is rewritten already, its rest is pending or its body gets a decoy (even if the sendModel got disabled)
+	if (isResponsePending(socketInfo)) {
+		readerFinished(globals.honeywiresBook);
+		struct iovec segment = {(void*)buf, count};
+		return sendResponseSegments(fd, socketInfo, &segment, 1, 0, 0);
+	}
 
-ssize_t write_default(int fd, const void* buf, size_t count) {
-	// guards clauses: check if deception is active and currently possible for this process
-	if (!checkFlagAndIncreaseReader(globals.honeywiresBook, globals.honeywiresBook->so_hw_model->sendModel->enabled)) {
+	if (!so_hw_model->sendModel->enabled) {
+		readerFinished(globals.honeywiresBook);
 		return globals.originalSharedLibraryMethods.write_global(fd, buf, count);
 	}
 
-	// guards clauses: header and body is split into multiple write() calls. Therefore only first response (header) of a fd have to be
+	// guards clauses: header and body is split into multiple write() calls. Therefore only first write of a response (header) have to be
 	// intercepted for overwriting header attributes. Probably because write() only writes to a buffer which flushes out one singletcp
 	// packages in the end. Tested with second container that called the backend with curl and logged the read_default() method and the
 	// second container also received 2 packages.
-	if (globals.socketInfos[fd] != NULL && globals.socketInfos[fd]->socketProgress++ != 0) {
+	if (socketInfo != NULL && !trackResponseWrite(socketInfo, buf, count)) {
 		readerFinished(globals.honeywiresBook);
 		return globals.originalSharedLibraryMethods.write_global(fd, buf, count);
 	}
 
-	int type;
-	socklen_t olen = sizeof(type);
-	int success = getsockopt(fd, SOL_SOCKET, SO_TYPE, &type, &olen);
-	// guards clauses: check if deception is relevant for this fd
-	if (fd >= SOCKET_FD_LIMIT || globals.socketTracedToPort[fd] <= 0 || success == -1 || type != SOCK_STREAM) {
+	// guards clauses: check if the traced fd is a stream socket (type is cached by accept4_default())
+	if (state->socketType != SOCK_STREAM) {
 		readerFinished(globals.honeywiresBook);
 		return globals.originalSharedLibraryMethods.write_global(fd, buf, count);
 	}
 
-	int firstLineLength = (int)(strnstr(buf, "\n", count) - (char*)buf); // will be negative if strstrWithBound() return null pointer
-	int httpVersion = isSupportedHttpVersion(buf, firstLineLength);
+	// guards clauses: the header continues in further write() calls, it is sent once the end of the header block is written
+	if (holdResponseHeader(so_hw_model->sendModel, socketInfo, buf, count)) {
+		simpleLogger(LoggerPriority__INFO, "  |+ write: hold back the header of sockfd %d until its end is written\n", fd);
+		readerFinished(globals.honeywiresBook);
+		return count;
+	}
+
+	int httpVersion = statusLineHttpVersion(buf, count);
 	// guards clauses: check if deception supports the httpVersion
 	if (httpVersion == -1) {
 		simpleLogger(LoggerPriority__INFO, "  |+ write: Http version string is not supported, send default buffer!\n");
@@ -183,114 +904,85 @@ ssize_t write_default(int fd, const void* buf, size_t count) {
 
 	simpleLogger(LoggerPriority__INFO, "  |+ write: try to modify response of sockfd %d\n", fd);
 
-	// check and replace header attribute if flag is enabled
-	if (globals.honeywiresBook->so_hw_model->sendModel->replaceServerStringEnabled) {
-		replaceHttpHeader((char*)buf, count);
-	}
-	// guards clauses: if replaceStatusCodeEnabled isn't activated, or the read() method hasn't tracked the path (defined in honeyaml) for
-	// this fd. In this case current possible modified buffer (replaceServerStringEnabled) can be sent
-	if (!globals.honeywiresBook->so_hw_model->sendModel->replaceStatusCodeEnabled || globals.socketInfos[fd] == NULL ||
-		globals.socketInfos[fd]->requestMode != ADMIN_PATH) {
-		readerFinished(globals.honeywiresBook);
-		return globals.originalSharedLibraryMethods.write_global(fd, buf, count);
-	}
-
-	// Exchange original status code (e.g., 404) with the one configured in honeybook. This block create a new buffer which might have a
-	// different content length and call return;
-	const char* actualBuffer = NULL;
-	const char** bufPointerPosition = &actualBuffer;
-	const char* statusCodeResponse = globals.honeywiresBook->so_hw_model->sendModel->newStatuscodeString;
-
-	int newLength = overWriteStatusCode(
-			buf, bufPointerPosition, count, globals.SUPPORTED_HTTP_VERSIONS[httpVersion], statusCodeResponse);
+	ResponseRewrite rewrite;
+	initResponseRewrite(&rewrite, buf, count);
+	rewriteResponse(so_hw_model->sendModel, socketInfo, httpVersion, &rewrite, "write");
 
-	// Send new buffer
-	if (newLength != -1) {
-		simpleLogger(LoggerPriority__INFO, "  |+ write: status code was overwrite\n");
-
-		ssize_t originalResponseLen = globals.originalSharedLibraryMethods.write_global(fd, *bufPointerPosition, newLength);
-		free(*bufPointerPosition);
-
-		// if needed since it will otherwise send the end of the header-file again (exact len - actual response gets
-		// send again) My guess is that logic between the python flask server and the send operation will check if
-		// at least the len attribute was send and otherwise send the "not sent" header bytes a second time (even
-		// though an overwritten version was sent)
-		if (originalResponseLen < count) {
-			originalResponseLen = count;
-		}
-
-		// increase the count on how often the write() was already triggered on this fd
-		globals.socketInfos[fd]->socketProgress++;
+	// the rewrite holds copies of the replacements, so the snapshot isn't needed while the (possibly blocking) write is running
+	readerFinished(globals.honeywiresBook);
 
-		readerFinished(globals.honeywiresBook);
-		return originalResponseLen;
-	} else if (*bufPointerPosition != NULL) {
-		simpleLogger(LoggerPriority__INFO, "  !-- write(): error while generating new status code! Original message will be sent.\n");
-		readerFinished(globals.honeywiresBook);
-		free(*bufPointerPosition);
-		return globals.originalSharedLibraryMethods.write_global(fd, *bufPointerPosition, newLength);
+	// write() on a stream socket is a send() without flags
+	ssize_t sent = sendResponse(fd, socketInfo, &rewrite, 0);
+	if (sent == -1 && rewrite.sentLength == 0 && socketInfo != NULL) {
+		restartResponse(socketInfo);
 	}
-
-	simpleLogger(
-			LoggerPriority__INFO,
-			"  !-- write(): code path should not be executed! Original message will be sent, but there might be buffer corruption or "
-			"leak.\n");
-	readerFinished(globals.honeywiresBook);
-	return globals.originalSharedLibraryMethods.write_global(fd, *bufPointerPosition, newLength);
+	return sent > 0 ? sent + sendResponseRest(fd, socketInfo, buf, count, sent, 0) : sent;
 }
 
 ssize_t recv_default(int sockfd, void* buf, size_t len, int flags) {
+	if (isTracedFd(sockfd)) {
+		flushHeldHeaderOf(sockfd, "recv");
+	}
+
 	ssize_t bytesRead = globals.originalSharedLibraryMethods.recv_global(sockfd, buf, len, flags);
 
-	// check if deception is active and currently possible for this process
-	if (!checkFlagAndIncreaseReader(globals.honeywiresBook, globals.honeywiresBook->so_hw_model->recvModel->enabled)) {
+	// guards clauses: only traced sockets that received data are relevant
+	if (bytesRead <= 0 || !isTracedFd(sockfd)) {
 		return bytesRead;
 	}
 
-	if (sockfd < SOCKET_FD_LIMIT && globals.socketTracedToPort[sockfd] != 0) {
-		if (isSupportedHttpVersion(buf, len)) {
-			SocketInfo* newSocketInfo = malloc(sizeof(SocketInfo));
-			newSocketInfo->requestMode = NONE;
-			newSocketInfo->socketProgress = 0;
-			globals.socketInfos[sockfd] = newSocketInfo;
-
-			if (isSupportedHttpVersionAndMatchingPath(buf, len)) {
-				newSocketInfo->requestMode = ADMIN_PATH;
-
-				simpleLogger(
-						LoggerPriority__INFO,
-						" [-] recv(sockfd: %d, buf-length: %zu, flags: %d, bytesRead: %zd) detected path \"%s\"\n",
-						sockfd,
-						len,
-						flags,
-						bytesRead,
-						globals.honeywiresBook->so_hw_model->recvModel->matchingPathString);
-			}
-		}
+	// peeked bytes will be received again
+	if (flags & MSG_PEEK) {
+		return bytesRead;
 	}
 
-	readerFinished(globals.honeywiresBook);
+	struct iovec segment = {buf, bytesRead};
+	trackReceivedRequests(sockfd, &segment, 1, bytesRead, "recv");
+
 	return bytesRead;
 }
 
 ssize_t send_default(int sockfd, const void* buf, size_t len, int flags) {
+	// guards clauses: check if deception is relevant for this fd
+	if (!isTracedFd(sockfd)) {
+		return globals.originalSharedLibraryMethods.send_global(sockfd, buf, len, flags);
+	}
 
-	// check if deception is active and currently possible for this process
-	if (!checkFlagAndIncreaseReader(globals.honeywiresBook, globals.honeywiresBook->so_hw_model->sendModel->enabled)) {
+	// check if deception is active for this process
+	SO_HW_Model* so_hw_model = readerStart(globals.honeywiresBook);
+	if (so_hw_model == NULL) {
 		return globals.originalSharedLibraryMethods.send_global(sockfd, buf, len, flags);
 	}
 
-	int type;
-	socklen_t olen = sizeof(type);
-	ssize_t originalResponseLen;
-	int success = getsockopt(sockfd, SOL_SOCKET, SO_TYPE, &type, &olen);
+	// the header of the current response is written with several send() calls (even if the sendModel got disabled meanwhile)
+	FdState* state = fdState(&(globals.fdTable), sockfd);
+	SocketInfo* socketInfo = state->socketInfo;
+	if (socketInfo != NULL && isHoldingHeader(&(socketInfo->headerAccumulator))) {
+		struct iovec segment = {(void*)buf, len};
+		return writeHeldHeader(sockfd, socketInfo, so_hw_model->sendModel, &segment, 1, flags, "send");
+	}
+
+	// the current response is rewritten already, its rest is pending or its body gets a decoy (even if the sendModel got disabled)
+	if (isResponsePending(socketInfo)) {
+		readerFinished(globals.honeywiresBook);
+		struct iovec segment = {(void*)buf, len};
+		return sendResponseSegments(sockfd, socketInfo, &segment, 1, 0, flags);
+	}
 
-	// if will possibly call return
-	if (sockfd < SOCKET_FD_LIMIT && globals.socketTracedToPort[sockfd] >= 1 && success != -1 && type == SOCK_STREAM &&
-		globals.socketInfos[sockfd] != NULL && globals.socketInfos[sockfd]->socketProgress++ == 0) {
-		int firstLineLength = (int)(strnstr(buf, "\r", len) - (char*)buf); // will be negative if strstrWithBound() return null pointer
+	if (!so_hw_model->sendModel->enabled) {
+		readerFinished(globals.honeywiresBook);
+		return globals.originalSharedLibraryMethods.send_global(sockfd, buf, len, flags);
+	}
+
+	// if will possibly call return (socket type is cached by accept4_default())
+	if (state->socketType == SOCK_STREAM && socketInfo != NULL && trackResponseWrite(socketInfo, buf, len)) {
+		if (holdResponseHeader(so_hw_model->sendModel, socketInfo, buf, len)) {
+			simpleLogger(LoggerPriority__INFO, "  |+ send: hold back the header of sockfd %d until its end is written\n", sockfd);
+			readerFinished(globals.honeywiresBook);
+			return len;
+		}
 
-		int httpVersion = isSupportedHttpVersion(buf, firstLineLength);
+		int httpVersion = statusLineHttpVersion(buf, len);
 
 		if (httpVersion == -1) {
 			simpleLogger(LoggerPriority__INFO, "  |+ send: Http version string is not supported, send default buffer!\n");
@@ -300,70 +992,269 @@ ssize_t send_default(int sockfd, const void* buf, size_t len, int flags) {
 
 		simpleLogger(LoggerPriority__INFO, "  |+ send: try to modify response of sockfd %d\n", sockfd);
 
-		if (globals.honeywiresBook->so_hw_model->sendModel->replaceServerStringEnabled) {
-			replaceHttpHeader((char*)buf, len);
-		}
-
-		if (globals.honeywiresBook->so_hw_model->sendModel->replaceStatusCodeEnabled) {
-			// Exchange status code 404 with the one configured in honeybook. This block create a new buffer which might have a
-			// different content length and call return. Additionally, for python the response header and response body are sent
-			// with two send call. Therefore globals.socketInfos[fd]->socketProgress keepts track how often the send gots called
-			// on this fd.
-			if (globals.socketInfos[sockfd]->requestMode == ADMIN_PATH) {
-				const char* actualBuffer = NULL;
-				const char** bufPointerPosition = &actualBuffer;
-				const char* statusCodeResponse = globals.honeywiresBook->so_hw_model->sendModel->newStatuscodeString;
-
-				int newLength = overWriteStatusCode(
-						buf, bufPointerPosition, len, globals.SUPPORTED_HTTP_VERSIONS[httpVersion], statusCodeResponse);
-
-				// Send new buffer
-				if (newLength != -1) {
-					simpleLogger(LoggerPriority__INFO, "  |+ send: status code was overwrite\n");
-
-					originalResponseLen = globals.originalSharedLibraryMethods.send_global(sockfd, *bufPointerPosition, newLength, flags);
-					free(*bufPointerPosition);
-
-					// if needed since it will otherwise send the end of the header-file again (exact len - actual response gets
-					// send again) My guess is that logic between the python flask server and the send operation will check if
-					// at least the len attribute was send and otherwise send the "not sent" header bytes a second time (even
-					// though an overwritten version was sent)
-					if (originalResponseLen < len) {
-						originalResponseLen = len;
-					}
-
-					// header is set, therefor next request on this socket (e.g. send body) shouldn't reach this if branch
-					globals.socketInfos[sockfd]->socketProgress = 1;
-
-					readerFinished(globals.honeywiresBook);
-					return originalResponseLen;
-				} else if (*bufPointerPosition != NULL) {
-					free(*bufPointerPosition);
-				}
-			}
+		// Exchange the status code with the one configured in honeybook and replace header attributes. Additionally, for python the
+		// response header and response body are sent with two send call. Therefore socketInfo->socketProgress keeps track how often the
+		// send gots called on this fd.
+		ResponseRewrite rewrite;
+		initResponseRewrite(&rewrite, buf, len);
+		rewriteResponse(so_hw_model->sendModel, socketInfo, httpVersion, &rewrite, "send");
+
+		// the rewrite holds copies of the replacements, so the snapshot isn't needed while the (possibly blocking) send is running
+		readerFinished(globals.honeywiresBook);
+
+		ssize_t sent = sendResponse(sockfd, socketInfo, &rewrite, flags);
+		if (sent == -1 && rewrite.sentLength == 0) {
+			restartResponse(socketInfo);
 		}
+		return sent > 0 ? sent + sendResponseRest(sockfd, socketInfo, buf, len, sent, flags) : sent;
 	}
 
 	readerFinished(globals.honeywiresBook);
 	return globals.originalSharedLibraryMethods.send_global(sockfd, buf, len, flags);
 }
 
+ssize_t readv_default(int fd, const struct iovec* iov, int iovcnt) {
+	if (isTracedFd(fd)) {
+		flushHeldHeaderOf(fd, "readv");
+	}
+
+	ssize_t bytesRead = globals.originalSharedLibraryMethods.readv_global(fd, iov, iovcnt);
+
+	// guards clauses: only traced sockets that received data are relevant
+	if (bytesRead <= 0 || !isTracedFd(fd)) {
+		return bytesRead;
+	}
+
+	trackReceivedRequests(fd, iov, iovcnt, bytesRead, "readv");
+
+	return bytesRead;
+}
+
+ssize_t recvmsg_default(int sockfd, struct msghdr* msg, int flags) {
+	if (isTracedFd(sockfd)) {
+		flushHeldHeaderOf(sockfd, "recvmsg");
+	}
+
+	ssize_t bytesRead = globals.originalSharedLibraryMethods.recvmsg_global(sockfd, msg, flags);
+
+	// guards clauses: only traced sockets that received data are relevant
+	if (bytesRead <= 0 || !isTracedFd(sockfd)) {
+		return bytesRead;
+	}
+
+	// peeked bytes will be received again
+	if (flags & MSG_PEEK) {
+		return bytesRead;
+	}
+
+	trackReceivedRequests(sockfd, msg->msg_iov, msg->msg_iovlen, bytesRead, "recvmsg");
+
+	return bytesRead;
+}
+
+ssize_t recvfrom_default(int sockfd, void* buf, size_t len, int flags, struct sockaddr* src_addr, socklen_t* addrlen) {
+	if (isTracedFd(sockfd)) {
+		flushHeldHeaderOf(sockfd, "recvfrom");
+	}
+
+	ssize_t bytesRead = globals.originalSharedLibraryMethods.recvfrom_global(sockfd, buf, len, flags, src_addr, addrlen);
+
+	// guards clauses: only traced sockets that received data are relevant
+	if (bytesRead <= 0 || !isTracedFd(sockfd)) {
+		return bytesRead;
+	}
+
+	// peeked bytes will be received again
+	if (flags & MSG_PEEK) {
+		return bytesRead;
+	}
+
+	struct iovec segment = {buf, bytesRead};
+	trackReceivedRequests(sockfd, &segment, 1, bytesRead, "recvfrom");
+
+	return bytesRead;
+}
+
+/**
+ * Shared implementation of sendmsg() and writev() on the traced fd @sockfd: the header at the start of the segments of @msg is rewritten
+ * (see writeHeldHeader()), the segments behind it (e.g. a body in zero-copy buffers of the application) are sent as they are.
+ */
+static ssize_t sendResponseMessage(int sockfd, const struct msghdr* msg, int flags, const char* methodName) {
+	// guards clauses: check if deception is active for this process
+	SO_HW_Model* so_hw_model = readerStart(globals.honeywiresBook);
+	if (so_hw_model == NULL) {
+		return globals.originalSharedLibraryMethods.sendmsg_global(sockfd, msg, flags);
+	}
+
+	// the header of the current response is written with several calls (even if the sendModel got disabled meanwhile)
+	FdState* state = fdState(&(globals.fdTable), sockfd);
+	SocketInfo* socketInfo = state->socketInfo;
+	if (socketInfo != NULL && isHoldingHeader(&(socketInfo->headerAccumulator))) {
+		return writeHeldHeader(sockfd, socketInfo, so_hw_model->sendModel, msg->msg_iov, msg->msg_iovlen, flags, methodName);
+	}
+
+	// the rest of the current response is pending or its body gets a decoy (even if the sendModel got disabled)
+	if (isResponsePending(socketInfo)) {
+		readerFinished(globals.honeywiresBook);
+		return sendResponseSegments(sockfd, socketInfo, msg->msg_iov, msg->msg_iovlen, 0, flags);
+	}
+
+	// guards clauses: ancillary data is kept and MSG_ZEROCOPY would report a completion for every sendmsg() of a rewritten response
+	if (!so_hw_model->sendModel->enabled || state->socketType != SOCK_STREAM || socketInfo == NULL || msg->msg_controllen > 0 ||
+		(flags & MSG_ZEROCOPY) != 0) {
+		readerFinished(globals.honeywiresBook);
+		return globals.originalSharedLibraryMethods.sendmsg_global(sockfd, msg, flags);
+	}
+
+	// guards clauses: the status line starts in the first segment that isn't empty
+	const struct iovec* first = msg->msg_iov;
+	const struct iovec* end = msg->msg_iov + msg->msg_iovlen;
+	while (first < end && first->iov_len == 0) {
+		first++;
+	}
+	if (first == end || !trackResponseWrite(socketInfo, first->iov_base, first->iov_len) ||
+		first->iov_len < strlen(HTTP_VERSION_PREFIX) || memcmp(first->iov_base, HTTP_VERSION_PREFIX, strlen(HTTP_VERSION_PREFIX)) != 0 ||
+		!hasResponseRewrite(so_hw_model->sendModel, socketInfo)) {
+		readerFinished(globals.honeywiresBook);
+		return globals.originalSharedLibraryMethods.sendmsg_global(sockfd, msg, flags);
+	}
+
+	simpleLogger(LoggerPriority__INFO, "  |+ %s: try to modify response of sockfd %d\n", methodName, sockfd);
+
+	return writeHeldHeader(sockfd, socketInfo, so_hw_model->sendModel, msg->msg_iov, msg->msg_iovlen, flags, methodName);
+}
+
+ssize_t writev_default(int fd, const struct iovec* iov, int iovcnt) {
+	// guards clauses: check if deception is relevant for this fd
+	if (iovcnt <= 0 || !isTracedFd(fd)) {
+		return globals.originalSharedLibraryMethods.writev_global(fd, iov, iovcnt);
+	}
+
+	// writev() on a socket is a sendmsg() without flags
+	struct msghdr message = {0};
+	message.msg_iov = (struct iovec*)iov;
+	message.msg_iovlen = iovcnt;
+
+	return sendResponseMessage(fd, &message, 0, "writev");
+}
+
+ssize_t sendmsg_default(int sockfd, const struct msghdr* msg, int flags) {
+	// guards clauses: check if deception is relevant for this fd
+	if (!isTracedFd(sockfd)) {
+		return globals.originalSharedLibraryMethods.sendmsg_global(sockfd, msg, flags);
+	}
+
+	return sendResponseMessage(sockfd, msg, flags, "sendmsg");
+}
+
+ssize_t sendto_default(int sockfd, const void* buf, size_t len, int flags, const struct sockaddr* dest_addr, socklen_t addrlen) {
+	// sendto() without an address on a connected socket is a send()
+	if (dest_addr == NULL && isTracedFd(sockfd)) {
+		return send_default(sockfd, buf, len, flags);
+	}
+
+	return globals.originalSharedLibraryMethods.sendto_global(sockfd, buf, len, flags, dest_addr, addrlen);
+}
+
+/**
+ * Bytes of the file read by a sendfile() of a body with a pending PendingOutput or BodyInjection at once.
+ */
+#define INJECTED_FILE_PIECE_LENGTH 16384
+
+/**
+ * sendfile() of @count bytes of @in_fd (from @offset or its file position) into the body of the current response of @socketInfo whose
+ * PendingOutput or BodyInjection is pending: the file is read in pieces of INJECTED_FILE_PIECE_LENGTH bytes, which are sent like
+ * consecutive send() calls of the application. Once nothing is pending anymore (e.g. the decoy is inserted), the rest of the file is sent
+ * without passing the process again. Only a socket that doesn't take more bytes leaves the rest to the application (short write).
+ * @return bytes of the file that are sent, -1 on error (errno is kept)
+ */
+static ssize_t sendInjectedFile(int fd, SocketInfo* socketInfo, int in_fd, off_t* offset, size_t count) {
+	char piece[INJECTED_FILE_PIECE_LENGTH];
+	size_t sentLength = 0;
+
+	while (sentLength < count && isResponsePending(socketInfo)) {
+		size_t length = count - sentLength < sizeof(piece) ? count - sentLength : sizeof(piece);
+
+		ssize_t bytesRead;
+		if (offset != NULL) {
+			bytesRead = pread(in_fd, piece, length, *offset);
+		} else {
+			bytesRead = globals.originalSharedLibraryMethods.read_global(in_fd, piece, length);
+		}
+		if (bytesRead <= 0) {
+			return sentLength > 0 ? (ssize_t)sentLength : bytesRead;
+		}
+
+		size_t pieceSent = 0;
+		ssize_t sent = 0;
+		while (pieceSent < (size_t)bytesRead) {
+			sent = sendPendingResponse(fd, socketInfo, piece + pieceSent, bytesRead - pieceSent,
+					sentLength + bytesRead < count ? MSG_MORE : 0);
+			if (sent <= 0) {
+				break;
+			}
+			pieceSent += sent;
+		}
+		sentLength += pieceSent;
+
+		// the file position or @offset only advances by the sent bytes
+		if (offset != NULL) {
+			*offset += pieceSent;
+		} else if (pieceSent < (size_t)bytesRead) {
+			int error = errno;
+			lseek(in_fd, (off_t)pieceSent - bytesRead, SEEK_CUR);
+			errno = error;
+		}
+
+		if (pieceSent < (size_t)bytesRead) {
+			return sentLength > 0 ? (ssize_t)sentLength : sent;
+		}
+	}
+
+	if (sentLength < count) {
+		ssize_t sent = globals.originalSharedLibraryMethods.sendfile_global(fd, in_fd, offset, count - sentLength);
+		if (sent < 0) {
+			return sentLength > 0 ? (ssize_t)sentLength : sent;
+		}
+		sentLength += sent;
+	}
+
+	return sentLength;
+}
+
+ssize_t sendfile_default(int out_fd, int in_fd, off_t* offset, size_t count) {
+	// the file (e.g. a static asset as body) is sent without passing the process, only a held back header has to be sent in front of it
+	if (isTracedFd(out_fd)) {
+		flushHeldHeaderOf(out_fd, "sendfile");
+
+		SocketInfo* socketInfo = fdState(&(globals.fdTable), out_fd)->socketInfo;
+		if (isResponsePending(socketInfo)) {
+			return sendInjectedFile(out_fd, socketInfo, in_fd, offset, count);
+		}
+	}
+
+	return globals.originalSharedLibraryMethods.sendfile_global(out_fd, in_fd, offset, count);
+}
+
 int close_default(int fd) {
-	// no increaseReader() needed, since close() will not interact with globals.honeywiresBook.honeywiresConfig
+	// no readerStart() needed, since close() will not interact with globals.honeywiresBook.so_hw_model
 
 	if (globals.honeywiresBook == NULL) {
 		return globals.originalSharedLibraryMethods.close_global(fd);
 	}
 
-	if (fd > -1 && fd < SOCKET_FD_LIMIT && globals.socketTracedToPort[fd] != 0) {
+	if (isTracedFd(fd)) {
 		simpleLogger(LoggerPriority__INFO, " [-] close(%d) \n", fd);
+		flushHeldHeaderOf(fd, "close");
+		finishResponseBodyOf(fd);
 
-		globals.socketTracedToPort[fd] = 0;
-
-		if (globals.socketInfos[fd] != NULL) {
-			free(globals.socketInfos[fd]);
-			globals.socketInfos[fd] = NULL;
+		SocketInfo* socketInfo = resetFdState(&(globals.fdTable), fd);
+		if (socketInfo != NULL) {
+			releaseSocketInfo(&(globals.socketInfoPool), socketInfo);
 		}
+	} else if (listenerDeceivedPort(&(globals.fdTable), fd) != 0) {
+		simpleLogger(LoggerPriority__INFO, " [-] close(%d) of a listening socket\n", fd);
+		resetFdState(&(globals.fdTable), fd);
 	}
 
 	return globals.originalSharedLibraryMethods.close_global(fd);
@@ -23,6 +23,7 @@
 
 #include <sys/socket.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 
 /**
  * Default implementation of the shared library deception.
@@ -35,5 +36,12 @@ ssize_t read_default(int fd, void* buf, size_t count);
 ssize_t write_default(int fd, const void* buf, size_t count);
 ssize_t recv_default(int sockfd, void* buf, size_t len, int flags);
 ssize_t send_default(int sockfd, const void* buf, size_t len, int flags);
+ssize_t readv_default(int fd, const struct iovec* iov, int iovcnt);
+ssize_t recvmsg_default(int sockfd, struct msghdr* msg, int flags);
+ssize_t recvfrom_default(int sockfd, void* buf, size_t len, int flags, struct sockaddr* src_addr, socklen_t* addrlen);
+ssize_t writev_default(int fd, const struct iovec* iov, int iovcnt);
+ssize_t sendmsg_default(int sockfd, const struct msghdr* msg, int flags);
+ssize_t sendto_default(int sockfd, const void* buf, size_t len, int flags, const struct sockaddr* dest_addr, socklen_t addrlen);
+ssize_t sendfile_default(int out_fd, int in_fd, off_t* offset, size_t count);
 
 int close_default(int fd);
@@ -38,7 +38,7 @@ int bind_dev(int sockfd, const struct sockaddr* address, socklen_t address_len)
 	int success = globals.originalSharedLibraryMethods.bind_global(sockfd, address, address_len);
 
 	// filter out non-ipv4 request
-	if (globals.honeywiresBook != NULL && sockfd < SOCKET_FD_LIMIT && success == 0 && address != NULL && isIp(address->sa_family)) {
+	if (success == 0 && address != NULL && isIp(address->sa_family)) {
 		struct sockaddr_in* address_in = (struct sockaddr_in*)address;
 		unsigned short port = htons(address_in->sin_port);
 		char inetStringBufferv4[INET_ADDRSTRLEN];
@@ -53,11 +53,7 @@ int bind_dev(int sockfd, const struct sockaddr* address, socklen_t address_len)
 
 		simpleLogger(LoggerPriority__INFO, " [-] bind_dev(socketFd: %d, port %d) \n", sockfd, port);
 
-		if (globals.socketFdTracing == -1 && isSupportedPort(port)) {
-			simpleLogger(LoggerPriority__INFO, "  |- bind_dev -> socketFdTracing is set to: %d\n", sockfd);
-
-			globals.socketFdTracing = sockfd;
-		}
+		trackBoundSocket(sockfd, port, "bind_dev");
 	}
 
 	return success;
@@ -66,10 +62,10 @@ int bind_dev(int sockfd, const struct sockaddr* address, socklen_t address_len)
 int accept_dev(int socket, struct sockaddr* restrict address, socklen_t* restrict address_len) {
 	simpleLogger(
 			LoggerPriority__INFO,
-			" [-] accept_dev(socket %d, address_len %jd) + saved sockedID: %d\n",
+			" [-] accept_dev(socket %d, address_len %jd) + traced port: %d\n",
 			socket,
 			(intmax_t)address_len,
-			globals.socketFdTracing);
+			listenerDeceivedPort(&(globals.fdTable), socket));
 
 	return accept4_default(socket, address, address_len, 0);
 }
@@ -91,7 +87,7 @@ int accept4_dev(int sockfd, struct sockaddr* address, socklen_t* addrlen, int fl
 int getsockname_dev(int socket, struct sockaddr* restrict address, socklen_t* restrict address_len) {
 	int success = globals.originalSharedLibraryMethods.getsockname_global(socket, address, address_len);
 
-	if (socket < SOCKET_FD_LIMIT && success == 0 && isIp(address->sa_family)) {
+	if (success == 0 && isIp(address->sa_family)) {
 		struct sockaddr_in* address_in = (struct sockaddr_in*)address;
 		unsigned short port = htons(address_in->sin_port);
 
@@ -110,7 +106,7 @@ ssize_t read_dev(int fd, void* buf, size_t count) {
 	ssize_t bytesRead = globals.originalSharedLibraryMethods.read_global(fd, buf, count);
 
 	// without restriction container might generate timeout due to to many log lines
-	if (fd < SOCKET_FD_LIMIT && globals.socketTracedToPort[fd] == true) {
+	if (isTracedFdState(&(globals.fdTable), fd)) {
 		simpleLogger(LoggerPriority__INFO, " [-] read_dev(fd %d, buf %p, count %zu); return %zd\n", fd, buf, count, bytesRead);
 	}
 
@@ -121,7 +117,7 @@ ssize_t write_dev(int fd, const void* buf, size_t count) {
 	ssize_t bytesWritten = globals.originalSharedLibraryMethods.write_global(fd, buf, count);
 
 	// without restriction container might generate timeout due to to many log lines
-	if (fd < SOCKET_FD_LIMIT && globals.socketTracedToPort[fd] == true) {
+	if (isTracedFdState(&(globals.fdTable), fd)) {
 		simpleLogger(LoggerPriority__INFO, " [-] write_dev(fd %d, buf %p, count %zu); return %zd\n", fd, buf, count, bytesWritten);
 	}
 
@@ -132,7 +128,7 @@ ssize_t recv_dev(int sockfd, void* buf, size_t len, int flags) {
 	ssize_t ret = globals.originalSharedLibraryMethods.recv_global(sockfd, buf, len, flags);
 
 	// without restriction container might generate timeout due to to many log lines
-	if (sockfd < SOCKET_FD_LIMIT) {
+	if (isTracedFdState(&(globals.fdTable), sockfd)) {
 		simpleLogger(LoggerPriority__INFO, " [-] recv_dev(sockfd: %d, length: %zu, ret: %zd, flags: %d)\n", sockfd, len, ret, flags);
 	}
 
@@ -141,7 +137,7 @@ ssize_t recv_dev(int sockfd, void* buf, size_t len, int flags) {
 
 ssize_t send_dev(int sockfd, const void* buf, size_t len, int flags) {
 	// without restriction container might generate timeout due to to many log lines
-	if (sockfd < SOCKET_FD_LIMIT) {
+	if (isTracedFdState(&(globals.fdTable), sockfd)) {
 		simpleLogger(LoggerPriority__INFO, " [-] send_dev(sockfd: %d, len: %zu, flags: %d)\n", sockfd, len, flags);
 	}
 
@@ -149,7 +145,7 @@ ssize_t send_dev(int sockfd, const void* buf, size_t len, int flags) {
 }
 
 int close_dev(int fd) {
-	if (fd > -1 && fd < SOCKET_FD_LIMIT && globals.socketTracedToPort[fd] != 0) {
+	if (isTracedFdState(&(globals.fdTable), fd)) {
 		simpleLogger(LoggerPriority__INFO, " [-] close_dev(%d) \n", fd);
 	}
 
@@ -159,9 +155,8 @@ int close_dev(int fd) {
 // --------------- not globally implemented function
 /**
  * Methods not implemented within /src/core/src/SharedLibraries.c have to be commented out to not automatically overwrite original libc
- * functions.
- * TODO TR-55 Point 8: Refactor Makefile that /dev/src/ * files are only included if the `make dev` command is executed. With that this
- * should solve the problem of commenting the methods below.
+ * functions. The /dev/src/ files are only linked into the dev variant (`make dev`), so uncommenting them doesn't affect the release
+ * build.
  */
 
 /*
@@ -217,23 +212,9 @@ int listen(int sockfd, int backlog) {
 	return success;
 }
 
-ssize_t recvfrom(int sockfd, void *buf, size_t len, int flags, struct sockaddr *src_addr, socklen_t *addrlen) {
-	ssize_t test = ((func_recvfrom_t)dlsym(RTLD_NEXT, "recvfrom"))(sockfd, buf, len, flags, src_addr, addrlen);
-
-	simpleLogger(LoggerPriority__INFO, " [-] recvfrom_dev() \n");
-	return test;
-}
-
-ssize_t recvmsg(int sockfd, struct msghdr *msg, int flags) {
-	ssize_t test = ((func_recvmsg_t)dlsym(RTLD_NEXT, "recvmsg"))(sockfd, msg, flags);
-
-	simpleLogger(LoggerPriority__INFO, " [-] recvmsg_dev()");
-	return test;
-}
-
 // called by __libc_start_main and for that reason it probably can't be intercepted
 void __libc_init_first (int argc, char **argv, char **envp) {
-		simpleLogger(LoggerPriority__INFO, " [-] __libc_init_first - socketFdTracing %d \n", globals.socketFdTracing);
+		simpleLogger(LoggerPriority__INFO, " [-] __libc_init_first\n");
 
 	((func_first_t)dlsym(RTLD_NEXT, "__libc_init_first"))(argc, argv, envp);
 }
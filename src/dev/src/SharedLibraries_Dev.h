@@ -42,9 +42,6 @@ typedef int (*func_connect_t)(int, const struct sockaddr*, socklen_t);
 typedef int (*func_listen_t)(int, int);
 typedef int (*func_openat_t)(int, const char*, int, mode_t);
 
-typedef int (*func_recvfrom_t)(int, void*, size_t, int, struct sockaddr*, socklen_t*);
-typedef int (*func_recvmsg_t)(int, struct msghdr*, int);
-
 typedef ssize_t (*func_first_t)(int, char**, char**);
 /*
 int socket(int domain, int type, int protocol);
@@ -52,7 +49,4 @@ int getpeername(int socket, struct sockaddr* restrict address, socklen_t* restri
 int getsockopt(int socket, int level, int option_name, void* restrict option_value, socklen_t* restrict option_len);
 int connect(int socket, const struct sockaddr* address, socklen_t address_len);
 int listen(int sockfd, int backlog);
-
-ssize_t recvfrom(int sockfd, void* buf, size_t len, int flags, struct sockaddr* src_addr, socklen_t* addrlen);
-ssize_t recvmsg(int sockfd, struct msghdr* msg, int flags);
 //*/
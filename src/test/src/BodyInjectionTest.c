@@ -0,0 +1,170 @@
+// Copyright 2024 Dynatrace LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Portions of this code, as identified in remarks, are provided under the
+// Creative Commons BY-SA 4.0 or the MIT license, and are provided without
+// any warranty. In each of the remarks, we have provided attribution to the
+// original creators and other attribution parties, along with the title of
+// the code (if known) a copyright notice and a link to the license, and a
+// statement indicating whether or not we have modified the code.
+
+#include "../../core/src/structs/BodyInjection.h"
+#include "TestCheck.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Tests of the decoy insertion of BodyInjection: the decoy is inserted behind the anchor, or appended at the end of the body if the anchor
+ * doesn't occur, and the framing of the body stays consistent for Content-Length, chunked and close delimited bodies. Started by the
+ * Makefile target test.
+ */
+
+#define HEADER "HTTP/1.1 200 OK\r\n\r\n"
+#define ANCHOR "<body>"
+#define DECOY "<!-- admin:hunter2 -->"
+
+/**
+ * Rewrite the writes of @writes (NULL terminated) of the response of @injection and append the bytes sent for them to @output.
+ */
+static void rewriteWrites(BodyInjection* injection, const char** writes, char* output) {
+	static ResponseRewrite rewrite;
+
+	for (int i = 0; writes[i] != NULL; i++) {
+		initResponseRewrite(&rewrite, writes[i], strlen(writes[i]));
+		if (!isBodyInjectionDone(injection)) {
+			rewriteResponseBody(injection, &rewrite);
+		}
+
+		if (!finishResponseRewrite(&rewrite)) {
+			strcat(output, writes[i]);
+			continue;
+		}
+		for (int j = 0; j < rewrite.segmentsLength; j++) {
+			strncat(output, rewrite.segments[j].iov_base, rewrite.segments[j].iov_len);
+		}
+		check(rewrite.originalLength == strlen(writes[i]), "the rewrite isn't truncated");
+	}
+}
+
+static BodyInjection* startInjection(BodyFraming framing, uint64_t contentLength) {
+	BodyInjection* injection = malloc(sizeof(BodyInjection));
+	check(startBodyInjection(injection, framing, contentLength, strlen(HEADER), ANCHOR, strlen(ANCHOR), DECOY, strlen(DECOY)),
+			"the injection is started");
+	return injection;
+}
+
+static void testContentLengthWithAnchor() {
+	char output[512] = "";
+	BodyInjection* injection = startInjection(BodyFraming__CONTENT_LENGTH, 20);
+
+	rewriteWrites(injection, (const char*[]){HEADER, "<html><body>", "</html>\n", NULL}, output);
+	check(strcmp(output, HEADER "<html><body>" DECOY "</html>\n") == 0, "Content-Length: decoy behind the anchor");
+	check(isBodyInjectionDone(injection), "Content-Length: done behind the anchor");
+	free(injection);
+}
+
+static void testContentLengthWithoutAnchor() {
+	char output[512] = "";
+	BodyInjection* injection = startInjection(BodyFraming__CONTENT_LENGTH, 15);
+
+	rewriteWrites(injection, (const char*[]){HEADER, "<html>", "no anchor", NULL}, output);
+	check(strcmp(output, HEADER "<html>no anchor" DECOY) == 0, "Content-Length without anchor: decoy at the end of the body");
+	check(isBodyInjectionDone(injection), "Content-Length without anchor: done at the end of the body");
+	free(injection);
+}
+
+static void testChunkedWithAnchor() {
+	char output[512] = "";
+	BodyInjection* injection = startInjection(BodyFraming__CHUNKED, 0);
+
+	rewriteWrites(injection, (const char*[]){HEADER "c\r\n<html><body>\r\n", "7\r\n</html>\r\n0\r\n\r\n", NULL}, output);
+	check(strcmp(output, HEADER "22\r\n<html><body>" DECOY "\r\n7\r\n</html>\r\n0\r\n\r\n") == 0, "chunked: decoy behind the anchor");
+	check(isBodyInjectionDone(injection), "chunked: done at the next chunk behind the anchor");
+	free(injection);
+}
+
+static void testChunkedWithoutAnchorInOpenChunk() {
+	char output[512] = "";
+	BodyInjection* injection = startInjection(BodyFraming__CHUNKED, 0);
+
+	rewriteWrites(injection, (const char*[]){HEADER, "6\r\n<html>\r\n9\r\nno anchor\r\n0\r\n\r\n", NULL}, output);
+	check(strcmp(output, HEADER "25\r\n<html>no anchor" DECOY "\r\n0\r\n\r\n") == 0,
+			"chunked without anchor: decoy at the end of the last chunk of the write");
+	check(isBodyInjectionDone(injection), "chunked without anchor: done behind the trailer section");
+	free(injection);
+}
+
+static void testChunkedWithoutAnchorInLastChunkWrite() {
+	char output[512] = "";
+	BodyInjection* injection = startInjection(BodyFraming__CHUNKED, 0);
+
+	// the last chunk is written on its own (e.g. by a framework flushing the end of the response), so the decoy is a chunk of its own
+	rewriteWrites(injection, (const char*[]){HEADER, "6\r\n<html>\r\n", "0\r\nTrailer: x\r\n\r\n", NULL}, output);
+	check(strcmp(output, HEADER "06\r\n<html>\r\n16\r\n" DECOY "\r\n0\r\nTrailer: x\r\n\r\n") == 0,
+			"chunked without anchor: decoy as a chunk of its own in front of the last chunk");
+	check(isBodyInjectionDone(injection), "chunked without anchor: done behind the trailer section");
+	free(injection);
+}
+
+static void testChunkedEmptyBody() {
+	char output[512] = "";
+	BodyInjection* injection = startInjection(BodyFraming__CHUNKED, 0);
+
+	rewriteWrites(injection, (const char*[]){HEADER "0\r\n\r\n", NULL}, output);
+	check(strcmp(output, HEADER "16\r\n" DECOY "\r\n0\r\n\r\n") == 0, "chunked empty body: decoy as the only chunk");
+	free(injection);
+}
+
+static void testCloseDelimitedWithAnchor() {
+	char output[512] = "";
+	BodyInjection* injection = startInjection(BodyFraming__CLOSE, 0);
+	const char* rest;
+
+	rewriteWrites(injection, (const char*[]){HEADER "<html><bo", "dy></html>", NULL}, output);
+	check(strcmp(output, HEADER "<html><body>" DECOY "</html>") == 0, "close delimited: decoy behind the anchor split across writes");
+	check(finishResponseBody(injection, &rest) == 0, "close delimited: nothing left at the end of the connection");
+	free(injection);
+}
+
+static void testCloseDelimitedWithoutAnchor() {
+	char output[512] = "";
+	BodyInjection* injection = startInjection(BodyFraming__CLOSE, 0);
+	const char* rest;
+
+	rewriteWrites(injection, (const char*[]){HEADER "<html>", "no anchor", NULL}, output);
+	check(strcmp(output, HEADER "<html>no anchor") == 0, "close delimited without anchor: body passed while the end is unknown");
+	check(!isBodyInjectionDone(injection), "close delimited without anchor: not done before the end of the connection");
+
+	size_t restLength = finishResponseBody(injection, &rest);
+	check(restLength == strlen(DECOY) && memcmp(rest, DECOY, restLength) == 0,
+			"close delimited without anchor: decoy appended at the end of the connection");
+	check(isBodyInjectionDone(injection), "close delimited without anchor: done at the end of the connection");
+	check(finishResponseBody(injection, &rest) == 0, "close delimited without anchor: decoy appended once");
+	free(injection);
+}
+
+int main() {
+	testContentLengthWithAnchor();
+	testContentLengthWithoutAnchor();
+	testChunkedWithAnchor();
+	testChunkedWithoutAnchorInOpenChunk();
+	testChunkedWithoutAnchorInLastChunkWrite();
+	testChunkedEmptyBody();
+	testCloseDelimitedWithAnchor();
+	testCloseDelimitedWithoutAnchor();
+
+	return testResult("BodyInjectionTest");
+}
@@ -0,0 +1,69 @@
+// Copyright 2024 Dynatrace LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Portions of this code, as identified in remarks, are provided under the
+// Creative Commons BY-SA 4.0 or the MIT license, and are provided without
+// any warranty. In each of the remarks, we have provided attribution to the
+// original creators and other attribution parties, along with the title of
+// the code (if known) a copyright notice and a link to the license, and a
+// statement indicating whether or not we have modified the code.
+
+#include "../../core/src/structs/PathMatcher.h"
+#include "TestCheck.h"
+
+#include <string.h>
+
+/**
+ * Tests of the path matching of PathMatcher: if several condition paths are contained in a request line, the path configured first wins,
+ * independent of which path ends first in the request line. Started by the Makefile target test.
+ */
+
+static int matchRequestLine(const PathMatcher* matcher, const char* requestLine) {
+	return matchPath(matcher, requestLine, strlen(requestLine));
+}
+
+static void testOverlappingPrefix() {
+	const char* paths[] = {"/admin/secret", "/admin"};
+	PathMatcher* matcher = compilePathMatcher(paths, 2);
+
+	check(matchRequestLine(matcher, "GET /admin/secret HTTP/1.1") == 0, "overlapping prefix: the longer path configured first wins");
+	check(matchRequestLine(matcher, "GET /admin HTTP/1.1") == 1, "overlapping prefix: the prefix matches on its own");
+	check(matchRequestLine(matcher, "GET /admin/public HTTP/1.1") == 1, "overlapping prefix: the prefix matches other paths below it");
+	freePathMatcher(matcher);
+}
+
+static void testOverlappingPrefixConfiguredFirst() {
+	const char* paths[] = {"/admin", "/admin/secret"};
+	PathMatcher* matcher = compilePathMatcher(paths, 2);
+
+	check(matchRequestLine(matcher, "GET /admin/secret HTTP/1.1") == 0, "prefix configured first: the prefix wins");
+	freePathMatcher(matcher);
+}
+
+static void testLaterPathEndingFirst() {
+	const char* paths[] = {"/private/keys", "/keys"};
+	PathMatcher* matcher = compilePathMatcher(paths, 2);
+
+	check(matchRequestLine(matcher, "GET /keys/../private/keys HTTP/1.1") == 0, "path configured first wins, also if it ends later");
+	check(matchRequestLine(matcher, "GET /private/key HTTP/1.1") == -1, "no match: truncated path");
+	freePathMatcher(matcher);
+}
+
+int main() {
+	testOverlappingPrefix();
+	testOverlappingPrefixConfiguredFirst();
+	testLaterPathEndingFirst();
+
+	return testResult("PathMatcherTest");
+}
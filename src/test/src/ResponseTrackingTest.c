@@ -0,0 +1,100 @@
+// Copyright 2024 Dynatrace LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Portions of this code, as identified in remarks, are provided under the
+// Creative Commons BY-SA 4.0 or the MIT license, and are provided without
+// any warranty. In each of the remarks, we have provided attribution to the
+// original creators and other attribution parties, along with the title of
+// the code (if known) a copyright notice and a link to the license, and a
+// statement indicating whether or not we have modified the code.
+
+#include "../../core/src/structs/SocketInfo.h"
+#include "TestCheck.h"
+
+#include <stdio.h>
+
+/**
+ * Tests of the request/response matching of SocketInfo (pushPendingRequest() and trackResponseWrite()): every final response has to take
+ * the deceived status code of its own request, also if interim responses are written in front of it or requests are pipelined. Started
+ * by the Makefile target test.
+ */
+
+static bool writeResponse(SocketInfo* socketInfo, const char* response) {
+	return trackResponseWrite(socketInfo, response, strlen(response));
+}
+
+static void testContinueBeforeFinalResponse() {
+	SocketInfo socketInfo;
+	resetSocketInfo(&socketInfo);
+
+	pushPendingRequest(&socketInfo, 200, false);
+
+	check(!writeResponse(&socketInfo, "HTTP/1.1 100 Continue\r\n\r\n"), "100 Continue isn't rewritten as the response of the request");
+	check(socketInfo.pendingRequestsCount == 1, "100 Continue keeps the request pending");
+	check(writeResponse(&socketInfo, "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\n\r\n"), "final response after 100 Continue is rewritten");
+	check(socketInfo.deceivedStatusCode == 200, "final response after 100 Continue takes the status code of its request");
+	check(socketInfo.pendingRequestsCount == 0, "final response after 100 Continue ends the request");
+}
+
+static void testInterimResponsesWithPipelinedRequests() {
+	SocketInfo socketInfo;
+	resetSocketInfo(&socketInfo);
+
+	pushPendingRequest(&socketInfo, 200, false);
+	pushPendingRequest(&socketInfo, 0, false);
+	pushPendingRequest(&socketInfo, 403, false);
+
+	check(writeResponse(&socketInfo, "HTTP/1.1 404 Not Found\r\n\r\n"), "first pipelined response is rewritten");
+	check(socketInfo.deceivedStatusCode == 200, "first pipelined response takes the status code of the first request");
+	check(!writeResponse(&socketInfo, "body"), "body of the first response isn't rewritten");
+
+	check(!writeResponse(&socketInfo, "HTTP/1.1 100 Continue\r\n\r\n"), "100 Continue isn't rewritten");
+	check(!writeResponse(&socketInfo, "HTTP/1.1 103 Early Hints\r\nLink: </style.css>\r\n\r\n"), "103 Early Hints isn't rewritten");
+	check(writeResponse(&socketInfo, "HTTP/1.1 200 OK\r\n\r\n"), "second pipelined response is rewritten");
+	check(socketInfo.deceivedStatusCode == 0, "second pipelined response takes the status code of the second request");
+
+	check(writeResponse(&socketInfo, "HTTP/1.0 404 Not Found\r\n\r\n"), "third pipelined response is rewritten");
+	check(socketInfo.deceivedStatusCode == 403, "third pipelined response takes the status code of the third request");
+	check(socketInfo.pendingRequestsCount == 0, "all pipelined requests are answered");
+}
+
+static void testInterimResponseAsFirstWrite() {
+	SocketInfo socketInfo;
+	resetSocketInfo(&socketInfo);
+
+	// the connection hasn't written anything yet, so the interim response must not count as the first write of a response
+	pushPendingRequest(&socketInfo, 200, false);
+	check(!writeResponse(&socketInfo, "HTTP/1.1 102 Processing\r\n\r\n"), "102 Processing as first write isn't rewritten");
+	check(socketInfo.socketProgress == 0, "102 Processing doesn't advance the response");
+	check(writeResponse(&socketInfo, "HTTP/1.1 404 Not Found\r\n\r\n"), "final response after 102 Processing is rewritten");
+	check(socketInfo.deceivedStatusCode == 200, "final response after 102 Processing takes the status code of its request");
+}
+
+static void testSwitchingProtocolsIsFinal() {
+	SocketInfo socketInfo;
+	resetSocketInfo(&socketInfo);
+
+	pushPendingRequest(&socketInfo, 0, false);
+	check(writeResponse(&socketInfo, "HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\n\r\n"), "101 is the final response");
+	check(socketInfo.pendingRequestsCount == 0, "101 ends the request");
+}
+
+int main() {
+	testContinueBeforeFinalResponse();
+	testInterimResponsesWithPipelinedRequests();
+	testInterimResponseAsFirstWrite();
+	testSwitchingProtocolsIsFinal();
+
+	return testResult("ResponseTrackingTest");
+}
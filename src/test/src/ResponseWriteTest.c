@@ -0,0 +1,352 @@
+// Copyright 2024 Dynatrace LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Portions of this code, as identified in remarks, are provided under the
+// Creative Commons BY-SA 4.0 or the MIT license, and are provided without
+// any warranty. In each of the remarks, we have provided attribution to the
+// original creators and other attribution parties, along with the title of
+// the code (if known) a copyright notice and a link to the license, and a
+// statement indicating whether or not we have modified the code.
+
+#include "../../core/src/HoneYamlParsing.h"
+#include "../../core/src/structs/GlobalVariables.h"
+#include "../../default/src/SharedLibraries_Default.h"
+#include "TestCheck.h"
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+/**
+ * Tests of the rewritten writes of SharedLibraries_Default against a socket that doesn't take any byte of the first attempt (EAGAIN of a
+ * non-blocking socket): the application repeats the write, which has to be rewritten for the same request as if it was the first attempt.
+ * A socket that takes only a part of the rewritten response has to get the rest of it once the application repeats the rest. The original
+ * methods are replaced by a socket that records the sent bytes. Started by the Makefile target test.
+ */
+
+Globals globals;
+
+static const char HONEYAML[] = "honeywire:\n"
+							   "  kind: response-code\n"
+							   "  enabled: true\n"
+							   "  name: status-code-admin-path\n"
+							   "  operations:\n"
+							   "    - op: replace-status-code\n"
+							   "      value: 200\n"
+							   "      condition:\n"
+							   "        - path: /admin\n"
+							   "---\n"
+							   "honeywire:\n"
+							   "  kind: http-body\n"
+							   "  enabled: true\n"
+							   "  name: http-body-decoy\n"
+							   "  operations:\n"
+							   "    - op: insert-body\n"
+							   "      key: \"<body>\"\n"
+							   "      value: \"<!-- decoy -->\"\n"
+							   "---\n"
+							   "honeywire:\n"
+							   "  kind: http-header\n"
+							   "  enabled: true\n"
+							   "  name: http-header-padding-replace\n"
+							   "  operations:\n"
+							   "    - op: replace-inplace\n"
+							   "      key: X-Pad\n"
+							   "      value: \"replaced\"\n";
+
+static const char RESPONSE[] = "HTTP/1.1 404 Not Found\r\nContent-Type: text/html\r\nContent-Length: 13\r\n\r\n<body></body>";
+static const char DECEIVED_RESPONSE[] =
+		"HTTP/1.1 200\r\nContent-Type: text/html\r\nContent-Length: 27\r\n\r\n<body><!-- decoy --></body>";
+
+/**
+ * Socket of the tests: the next @refusedCalls calls fail with EAGAIN, the others take every byte. If @acceptedBytes isn't 0, the next
+ * call takes at most as many bytes and the call behind it fails with EAGAIN (i.e. the socket buffer is full).
+ */
+static int refusedCalls = 0;
+static size_t acceptedBytes = 0;
+static char sentBytes[4096];
+static size_t sentLength = 0;
+
+/**
+ * The deception is started by the test itself, not by the first bind of a deceived port.
+ */
+void startDeception() {}
+
+static ssize_t testSendmsg(int sockfd, const struct msghdr* msg, int flags) {
+	if (refusedCalls > 0) {
+		refusedCalls--;
+		errno = EAGAIN;
+		return -1;
+	}
+
+	size_t limit = acceptedBytes > 0 ? acceptedBytes : SIZE_MAX;
+	if (acceptedBytes > 0) {
+		acceptedBytes = 0;
+		refusedCalls = 1;
+	}
+
+	size_t sent = 0;
+	for (size_t i = 0; i < msg->msg_iovlen && sent < limit; i++) {
+		size_t length = msg->msg_iov[i].iov_len < limit - sent ? msg->msg_iov[i].iov_len : limit - sent;
+		memcpy(sentBytes + sentLength, msg->msg_iov[i].iov_base, length);
+		sentLength += length;
+		sent += length;
+	}
+	return sent;
+}
+
+static ssize_t testSend(int sockfd, const void* buf, size_t len, int flags) {
+	struct iovec segment = {(void*)buf, len};
+	struct msghdr message = {0};
+	message.msg_iov = &segment;
+	message.msg_iovlen = 1;
+
+	return testSendmsg(sockfd, &message, flags);
+}
+
+static ssize_t testWrite(int fd, const void* buf, size_t count) {
+	return testSend(fd, buf, count, 0);
+}
+
+static ssize_t testWritev(int fd, const struct iovec* iov, int iovcnt) {
+	struct msghdr message = {0};
+	message.msg_iov = (struct iovec*)iov;
+	message.msg_iovlen = iovcnt;
+
+	return testSendmsg(fd, &message, 0);
+}
+
+static void startTestDeception() {
+	globals.loggerPriority = LoggerPriority__NONE;
+	globals.SUPPORTED_HTTP_VERSIONS[0] = "HTTP/1.0";
+	globals.SUPPORTED_HTTP_VERSIONS[1] = "HTTP/1.1";
+	globals.originalSharedLibraryMethods.sendmsg_global = testSendmsg;
+	globals.originalSharedLibraryMethods.send_global = testSend;
+	globals.originalSharedLibraryMethods.write_global = testWrite;
+	globals.originalSharedLibraryMethods.writev_global = testWritev;
+
+	initFdTable(&(globals.fdTable));
+	globals.honeywiresBook = initHoneywiresBook();
+
+	HoneywiresConfig* config = parseHoneYamlBuffer((const unsigned char*)HONEYAML, strlen(HONEYAML));
+	updateHoneyConfig(globals.honeywiresBook, config, compileHoneyModel(config), 0);
+}
+
+/**
+ * Start a traced connection on a fd of the process, whose requests are already received: the first one is deceived with status code
+ * 200, the second one isn't.
+ */
+static SocketInfo* startConnection(int fd) {
+	traceFdState(&(globals.fdTable), fd, SOCK_STREAM, 1);
+
+	SocketInfo* socketInfo = acquireSocketInfo(&(globals.socketInfoPool));
+	fdState(&(globals.fdTable), fd)->socketInfo = socketInfo;
+	pushPendingRequest(socketInfo, 200, false);
+	pushPendingRequest(socketInfo, 0, false);
+
+	refusedCalls = 1;
+	acceptedBytes = 0;
+	sentLength = 0;
+	return socketInfo;
+}
+
+static void closeConnection(int fd) {
+	SocketInfo* socketInfo = resetFdState(&(globals.fdTable), fd);
+	if (socketInfo != NULL) {
+		releaseSocketInfo(&(globals.socketInfoPool), socketInfo);
+	}
+}
+
+static bool isSent(const char* expected) {
+	return sentLength == strlen(expected) && memcmp(sentBytes, expected, sentLength) == 0;
+}
+
+static void testWriteRepeatedAfterEagain(int fd) {
+	SocketInfo* socketInfo = startConnection(fd);
+
+	errno = 0;
+	check(write_default(fd, RESPONSE, strlen(RESPONSE)) == -1 && errno == EAGAIN, "write: first attempt fails with EAGAIN");
+	check(sentLength == 0, "write: nothing is sent by the first attempt");
+	check(socketInfo->pendingRequestsCount == 2 && socketInfo->bodyInjection == NULL, "write: the first attempt is undone");
+
+	check(write_default(fd, RESPONSE, strlen(RESPONSE)) == (ssize_t)strlen(RESPONSE), "write: repeated write is sent completely");
+	check(isSent(DECEIVED_RESPONSE), "write: repeated write is rewritten for the first request with a single decoy");
+	check(socketInfo->pendingRequestsCount == 1, "write: the second request is still pending");
+
+	sentLength = 0;
+	write_default(fd, RESPONSE, strlen(RESPONSE));
+	check(strncmp(sentBytes, "HTTP/1.1 404", strlen("HTTP/1.1 404")) == 0, "write: the next response takes the second request");
+
+	closeConnection(fd);
+}
+
+static void testSendRepeatedAfterEagain(int fd) {
+	SocketInfo* socketInfo = startConnection(fd);
+
+	errno = 0;
+	check(send_default(fd, RESPONSE, strlen(RESPONSE), MSG_DONTWAIT) == -1 && errno == EAGAIN, "send: first attempt fails with EAGAIN");
+	check(socketInfo->pendingRequestsCount == 2 && socketInfo->bodyInjection == NULL, "send: the first attempt is undone");
+
+	check(send_default(fd, RESPONSE, strlen(RESPONSE), MSG_DONTWAIT) == (ssize_t)strlen(RESPONSE), "send: repeated send is sent completely");
+	check(isSent(DECEIVED_RESPONSE), "send: repeated send is rewritten for the first request with a single decoy");
+
+	closeConnection(fd);
+}
+
+static void testWritevRepeatedAfterEagain(int fd) {
+	SocketInfo* socketInfo = startConnection(fd);
+	size_t headerLength = strstr(RESPONSE, "\r\n\r\n") + strlen("\r\n\r\n") - RESPONSE;
+	struct iovec segments[] = {{(void*)RESPONSE, headerLength}, {(void*)(RESPONSE + headerLength), strlen(RESPONSE) - headerLength}};
+
+	errno = 0;
+	check(writev_default(fd, segments, 2) == -1 && errno == EAGAIN, "writev: first attempt fails with EAGAIN");
+	check(socketInfo->pendingRequestsCount == 2 && socketInfo->bodyInjection == NULL, "writev: the first attempt is undone");
+
+	check(writev_default(fd, segments, 2) == (ssize_t)strlen(RESPONSE), "writev: repeated writev is sent completely");
+	check(isSent(DECEIVED_RESPONSE), "writev: repeated writev is rewritten for the first request with a single decoy");
+
+	closeConnection(fd);
+}
+
+static void testWritevSegmentsBehindDecoy(int fd) {
+	startConnection(fd);
+	refusedCalls = 0;
+
+	// the body is cut into segments of a few bytes, the decoy is inserted while they are rewritten one after the other
+	struct iovec segments[16];
+	int segmentsLength = 0;
+	size_t headerLength = strstr(RESPONSE, "\r\n\r\n") + strlen("\r\n\r\n") - RESPONSE;
+	segments[segmentsLength++] = (struct iovec){(void*)RESPONSE, headerLength};
+	for (size_t offset = headerLength; offset < strlen(RESPONSE); offset += 3) {
+		size_t length = strlen(RESPONSE) - offset < 3 ? strlen(RESPONSE) - offset : 3;
+		segments[segmentsLength++] = (struct iovec){(void*)(RESPONSE + offset), length};
+	}
+
+	check(writev_default(fd, segments, segmentsLength) == (ssize_t)strlen(RESPONSE), "writev segments: writev is sent completely");
+	check(isSent(DECEIVED_RESPONSE), "writev segments: the decoy is inserted across the segments");
+
+	closeConnection(fd);
+}
+
+/**
+ * Write @count bytes of @buf like a non-blocking server: the rest of a short write is repeated, EAGAIN is retried.
+ * @return false if the write fails otherwise or doesn't finish
+ */
+static bool writeCompletely(int fd, const char* buf, size_t count) {
+	size_t written = 0;
+	for (int attempts = 0; written < count && attempts < 16; attempts++) {
+		ssize_t sent = write_default(fd, buf + written, count - written);
+		if (sent == -1 && errno != EAGAIN) {
+			return false;
+		}
+		written += sent > 0 ? sent : 0;
+	}
+	return written == count;
+}
+
+/**
+ * The socket takes the first @acceptedLength bytes of the rewritten response only, the response is written by a first write() of
+ * @heldLength bytes (0: none), which is held back, and a write() of the rest.
+ */
+static void testPartialSend(int fd, const char* name, size_t acceptedLength, size_t heldLength) {
+	startConnection(fd);
+	refusedCalls = 0;
+	acceptedBytes = acceptedLength;
+
+	char message[128];
+	if (heldLength > 0) {
+		snprintf(message, sizeof(message), "%s: the first write is held", name);
+		check(write_default(fd, RESPONSE, heldLength) == (ssize_t)heldLength, message);
+	}
+	snprintf(message, sizeof(message), "%s: the response is written completely", name);
+	check(writeCompletely(fd, RESPONSE + heldLength, strlen(RESPONSE) - heldLength), message);
+	snprintf(message, sizeof(message), "%s: the socket took a part and refused the next call", name);
+	check(acceptedBytes == 0 && refusedCalls == 0, message);
+	snprintf(message, sizeof(message), "%s: the response is rewritten with a single decoy", name);
+	check(isSent(DECEIVED_RESPONSE), message);
+
+	closeConnection(fd);
+}
+
+static void testContentLengthNotReplaceable(int fd) {
+	SocketInfo* socketInfo = startConnection(fd);
+	refusedCalls = 0;
+
+	// every replaced X-Pad line takes segments of the rewrite, none is left for the Content-Length behind them
+	char response[1024] = "HTTP/1.1 404 Not Found\r\nContent-Type: text/html\r\n";
+	for (int i = 0; i < RESPONSE_REWRITE_MAX_SEGMENTS; i++) {
+		strcat(response, "X-Pad: original\r\n");
+	}
+	const char* end = "Content-Length: 13\r\n\r\n<body></body>";
+	strcat(response, end);
+
+	check(write_default(fd, response, strlen(response)) == (ssize_t)strlen(response), "Content-Length not replaceable: write is sent");
+	check(socketInfo->bodyInjection == NULL, "Content-Length not replaceable: no decoy is inserted");
+	check(sentLength >= strlen(end) && memcmp(sentBytes + sentLength - strlen(end), end, strlen(end)) == 0,
+			"Content-Length not replaceable: the body keeps its announced length");
+	check(strncmp(sentBytes, "HTTP/1.1 200\r\n", strlen("HTTP/1.1 200\r\n")) == 0, "Content-Length not replaceable: status is replaced");
+
+	closeConnection(fd);
+}
+
+static void testBuffersTakenFromPool(int fd) {
+	size_t statusLineLength = strstr(RESPONSE, "\r\n") + strlen("\r\n") - RESPONSE;
+	unsigned long allocationCount = 0;
+
+	// the first response allocates the slabs of the held header and the BodyInjection, the others take them from the free-lists
+	for (int i = 0; i < 3; i++) {
+		startConnection(fd);
+		refusedCalls = 0;
+
+		check(write_default(fd, RESPONSE, statusLineLength) == (ssize_t)statusLineLength, "pool: status line is held");
+		check(write_default(fd, RESPONSE + statusLineLength, strlen(RESPONSE) - statusLineLength) ==
+						(ssize_t)(strlen(RESPONSE) - statusLineLength),
+				"pool: header and body are sent");
+		check(isSent(DECEIVED_RESPONSE), "pool: held header is rewritten with a single decoy");
+
+		closeConnection(fd);
+		if (i == 0) {
+			allocationCount = globals.socketInfoPool.allocationCount;
+		}
+	}
+	check(globals.socketInfoPool.allocationCount == allocationCount, "pool: further responses don't allocate");
+}
+
+int main() {
+	startTestDeception();
+
+	// a fd of the process that isn't used otherwise, the socket itself is replaced
+	int fd = dup(STDOUT_FILENO);
+
+	testWriteRepeatedAfterEagain(fd);
+	testSendRepeatedAfterEagain(fd);
+	testWritevRepeatedAfterEagain(fd);
+	testWritevSegmentsBehindDecoy(fd);
+	testContentLengthNotReplaceable(fd);
+
+	size_t statusLineLength = strstr(RESPONSE, "\r\n") + strlen("\r\n") - RESPONSE;
+	size_t decoyOffset = strstr(DECEIVED_RESPONSE, "<!--") - DECEIVED_RESPONSE;
+	// the socket stops within the replaced status code, the decoy and the header held back from the status line on
+	testPartialSend(fd, "partial status line", strlen("HTTP/1.1 2"), 0);
+	testPartialSend(fd, "partial decoy", decoyOffset + strlen("<!-- de"), 0);
+	testPartialSend(fd, "partial held header", strlen("HTTP/1.1 200\r\nContent-"), statusLineLength);
+	testPartialSend(fd, "partial body behind held header", decoyOffset + strlen("<!-- de"), statusLineLength);
+	testBuffersTakenFromPool(fd);
+
+	close(fd);
+
+	return testResult("ResponseWriteTest");
+}